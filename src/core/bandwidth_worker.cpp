@@ -0,0 +1,262 @@
+#include "bandwidth_worker.h"
+#include "../utils/anti_detect.h"
+#include "overhead_meter.h"
+#include "../platform/cpu_features.h"
+
+// 每次 triad 处理的块大小，足够小以便及时检查占空比时间片
+#define BANDWIDTH_TRIAD_CHUNK_BYTES (256 * 1024)
+
+BandwidthWorker::BandwidthWorker(int threads, int bufferMB)
+    : running(0), dutyPercent(0), nextSlice(0), bytesMB(0),
+      buffer(NULL), bufferBytes(0), sliceBytes(0),
+      targetGBps(0), targetPercent(20), peakGBps(0), currentGBps(0), lastSampleTick(0),
+      pid(0.5, 0.8, 0.0) {
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+
+    // 默认只用一半核心：少数几个核心就能跑满内存控制器，再多只会额外占 CPU
+    numWorkers = threads > 0 ? threads : (int)(sysInfo.dwNumberOfProcessors + 1) / 2;
+    if (numWorkers < 1) numWorkers = 1;
+    if (numWorkers > 64) numWorkers = 64;
+
+    if (bufferMB < 16) bufferMB = 16;
+    bufferBytes = (size_t)bufferMB * 1024 * 1024;
+
+    // 每个线程一段，段内再三等分为 a/b/c 三个数组，保持 64 字节对齐
+    sliceBytes = bufferBytes / numWorkers / 192 * 192;
+
+    pid.SetOutputLimits(-50, 50);
+    InitializeCriticalSection(&adjustLock);
+}
+
+BandwidthWorker::~BandwidthWorker() {
+    Stop();
+    DeleteCriticalSection(&adjustLock);
+}
+
+void BandwidthWorker::Start() {
+    if (InterlockedCompareExchange(&running, 1, 0) != 0) return;
+
+    buffer = (char*)VirtualAlloc(NULL, bufferBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!buffer || sliceBytes == 0) {
+        if (buffer) VirtualFree(buffer, 0, MEM_RELEASE);
+        buffer = NULL;
+        InterlockedExchange(&running, 0);
+        return;
+    }
+
+    // 预先写满，避免首轮 triad 把缺页开销算进带宽
+    double* values = (double*)buffer;
+    for (size_t i = 0; i < bufferBytes / sizeof(double); ++i) {
+        values[i] = (double)(i & 0xFF);
+    }
+
+    InterlockedExchange(&nextSlice, 0);
+    InterlockedExchange(&bytesMB, 0);
+    InterlockedExchange(&dutyPercent, 0);
+    pid.Reset();
+    currentGBps = 0;
+    lastSampleTick = GetTickCount();
+
+    RandomDelay(100, 300);
+
+    for (int i = 0; i < numWorkers; i++) {
+        HANDLE hThread = CreateThread(NULL, 0, WorkerThreadProc, this, 0, NULL);
+        if (hThread) {
+            SetThreadPriority(hThread, THREAD_PRIORITY_BELOW_NORMAL);
+            EnterCriticalSection(&adjustLock);
+            workers.push_back(hThread);
+            LeaveCriticalSection(&adjustLock);
+        }
+    }
+
+    if (peakGBps <= 0) {
+        Calibrate();
+    }
+
+    EnterCriticalSection(&adjustLock);
+    double target = EffectiveTargetGBps();
+    int initialDuty = peakGBps > 0 ? (int)(target / peakGBps * 100.0) : 0;
+    if (initialDuty > 100) initialDuty = 100;
+    InterlockedExchange(&dutyPercent, initialDuty);
+    InterlockedExchange(&bytesMB, 0);
+    lastSampleTick = GetTickCount();
+    LeaveCriticalSection(&adjustLock);
+}
+
+void BandwidthWorker::Stop() {
+    if (InterlockedCompareExchange(&running, 0, 1) != 1) return;
+
+    // 先从列表中摘下句柄，控制线程统计 CPU 时间时不会碰到已关闭的句柄
+    std::vector<HANDLE> threads;
+    EnterCriticalSection(&adjustLock);
+    threads.swap(workers);
+    LeaveCriticalSection(&adjustLock);
+
+    // 线程可能还在 triad 中写缓冲区，全部退出后才能释放；每个时间片最多 100ms，不会久等
+    if (!threads.empty()) {
+        WaitForMultipleObjects((DWORD)threads.size(), &threads[0], TRUE, INFINITE);
+
+        for (size_t i = 0; i < threads.size(); i++) {
+            CloseHandle(threads[i]);
+        }
+    }
+
+    InterlockedExchange(&dutyPercent, 0);
+
+    if (buffer) {
+        VirtualFree(buffer, 0, MEM_RELEASE);
+        buffer = NULL;
+    }
+    currentGBps = 0;
+}
+
+void BandwidthWorker::SetTarget(double targetGB, int percentOfPeak) {
+    EnterCriticalSection(&adjustLock);
+    targetGBps = targetGB > 0 ? targetGB : 0;
+    if (percentOfPeak < 0) percentOfPeak = 0;
+    if (percentOfPeak > 100) percentOfPeak = 100;
+    targetPercent = percentOfPeak;
+    pid.Reset();
+    LeaveCriticalSection(&adjustLock);
+}
+
+double BandwidthWorker::EffectiveTargetGBps() const {
+    if (targetGBps > 0) {
+        return peakGBps > 0 && targetGBps > peakGBps ? peakGBps : targetGBps;
+    }
+    return peakGBps * targetPercent / 100.0;
+}
+
+double BandwidthWorker::MeasureGBps(DWORD windowMs) {
+    InterlockedExchange(&bytesMB, 0);
+    DWORD begin = GetTickCount();
+    Sleep(windowMs);
+    LONG mb = InterlockedExchange(&bytesMB, 0);
+    DWORD elapsed = GetTickCount() - begin;
+    if (elapsed == 0) return 0;
+    return (double)mb * 1048576.0 / (elapsed / 1000.0) / 1e9;
+}
+
+double BandwidthWorker::Calibrate() {
+    if (!running) return peakGBps;
+
+    // 满占空比跑一遍 triad，预热 200ms 后取 1 秒的平均值作为峰值
+    LONG previousDuty = InterlockedExchange(&dutyPercent, 100);
+    Sleep(200);
+    double measured = MeasureGBps(1000);
+    InterlockedExchange(&dutyPercent, previousDuty);
+
+    EnterCriticalSection(&adjustLock);
+    if (measured > 0) {
+        peakGBps = measured;
+    }
+    LeaveCriticalSection(&adjustLock);
+    return peakGBps;
+}
+
+DWORD WINAPI BandwidthWorker::WorkerThreadProc(LPVOID lpParam) {
+    BandwidthWorker* self = (BandwidthWorker*)lpParam;
+    self->WorkerThread();
+    return 0;
+}
+
+void BandwidthWorker::WorkerThread() {
+    LONG slice = InterlockedIncrement(&nextSlice) - 1;
+    if (slice < 0 || slice >= numWorkers) return;
+
+    const size_t arrayBytes = sliceBytes / 3;
+    char* base = buffer + (size_t)slice * sliceBytes;
+    double* a = (double*)base;
+    const double* b = (const double*)(base + arrayBytes);
+    const double* c = (const double*)(base + arrayBytes * 2);
+    const size_t totalCount = arrayBytes / sizeof(double);
+    const size_t chunkCount = BANDWIDTH_TRIAD_CHUNK_BYTES / sizeof(double);
+    size_t position = 0;
+    size_t pendingBytes = 0;  // 尚未累加到 bytesMB 的零头
+
+    while (running) {
+        LONG currentDuty = dutyPercent;
+        DWORD workDuration = currentDuty;
+        DWORD sleepDuration = 100 - currentDuty;
+
+        if (workDuration > 0) {
+            DWORD startTime = GetTickCount();
+            while (GetTickCount() - startTime < workDuration && running) {
+                size_t count = totalCount - position < chunkCount ? totalCount - position : chunkCount;
+                CpuFeatures::StreamTriad(a + position, b + position, c + position, 3.0, count);
+                // triad 每个元素读 b、c 写 a，按 STREAM 惯例计 3 倍字节
+                pendingBytes += count * sizeof(double) * 3;
+                position += count;
+                if (position >= totalCount) position = 0;
+            }
+            // 按 MB 计数，32 位计数器在任何采样周期内都不会回绕（按 KB 计在高带宽下几十秒就会溢出）
+            if (pendingBytes >= 1048576) {
+                InterlockedExchangeAdd(&bytesMB, (LONG)(pendingBytes / 1048576));
+                pendingBytes %= 1048576;
+            }
+        }
+
+        if (sleepDuration > 0 && running) {
+            Sleep(sleepDuration);
+        }
+    }
+}
+
+void BandwidthWorker::Update() {
+    if (!running) return;
+
+    EnterCriticalSection(&adjustLock);
+
+    DWORD now = GetTickCount();
+    DWORD elapsed = now - lastSampleTick;
+    if (elapsed < 500) {
+        LeaveCriticalSection(&adjustLock);
+        return;
+    }
+    lastSampleTick = now;
+
+    LONG mb = InterlockedExchange(&bytesMB, 0);
+    currentGBps = (double)mb * 1048576.0 / (elapsed / 1000.0) / 1e9;
+
+    if (peakGBps > 0) {
+        // 以峰值百分比为单位闭环：前馈取目标百分比，PID 修正非线性和其他进程的争用
+        double targetPct = EffectiveTargetGBps() / peakGBps * 100.0;
+        double currentPct = currentGBps / peakGBps * 100.0;
+        pid.SetTarget(targetPct);
+        double correction = pid.Compute(currentPct, elapsed / 1000.0);
+
+        LONG newDuty = (LONG)(targetPct + correction + 0.5);
+        if (targetPct <= 0) newDuty = 0;
+        if (newDuty < 0) newDuty = 0;
+        if (newDuty > 100) newDuty = 100;
+        InterlockedExchange(&dutyPercent, newDuty);
+    }
+
+    LeaveCriticalSection(&adjustLock);
+}
+
+LONGLONG BandwidthWorker::GetThreadCpuTime() const {
+    LONGLONG total = 0;
+    EnterCriticalSection((LPCRITICAL_SECTION)&adjustLock);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        total += OverheadMeter::GetThreadCpuTime(workers[i]);
+    }
+    LeaveCriticalSection((LPCRITICAL_SECTION)&adjustLock);
+    return total;
+}
+
+BandwidthWorkerStats BandwidthWorker::GetStats() const {
+    BandwidthWorkerStats stats;
+
+    EnterCriticalSection((LPCRITICAL_SECTION)&adjustLock);
+    stats.currentGBps = currentGBps;
+    stats.targetGBps = EffectiveTargetGBps();
+    stats.peakGBps = peakGBps;
+    stats.threadCount = (int)workers.size();
+    LeaveCriticalSection((LPCRITICAL_SECTION)&adjustLock);
+
+    stats.dutyPercent = dutyPercent;
+    stats.bufferBytes = (int64_t)bufferBytes;
+    return stats;
+}
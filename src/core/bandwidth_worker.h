@@ -0,0 +1,64 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include <stdint.h>
+#include "pid_controller.h"
+
+struct BandwidthWorkerStats {
+    double currentGBps;
+    double targetGBps;
+    double peakGBps;
+    int dutyPercent;
+    int threadCount;
+    int64_t bufferBytes;
+
+    BandwidthWorkerStats()
+        : currentGBps(0), targetGBps(0), peakGBps(0), dutyPercent(0),
+          threadCount(0), bufferBytes(0) {}
+};
+
+// 内存带宽负载 - 在远大于末级缓存的私有缓冲区上循环执行 STREAM triad，
+// 与 CPUWorker 一样按 100ms 周期做占空比控制，由闭环把实际带宽拉到目标 GB/s
+class BandwidthWorker {
+private:
+    volatile LONG running;
+    volatile LONG dutyPercent;
+    volatile LONG nextSlice;
+    volatile LONG bytesMB;      // 各线程累加的流量（MB，不足 1MB 的部分留在线程内），控制器每次采样后清零
+    std::vector<HANDLE> workers;  // 增删和遍历都在 adjustLock 内
+    int numWorkers;
+    char* buffer;
+    size_t bufferBytes;
+    size_t sliceBytes;
+    CRITICAL_SECTION adjustLock;
+
+    double targetGBps;
+    int targetPercent;
+    double peakGBps;
+    double currentGBps;
+    DWORD lastSampleTick;
+    PIDController pid;
+
+public:
+    BandwidthWorker(int threads, int bufferMB);
+    ~BandwidthWorker();
+
+    void Start();
+    void Stop();
+    bool IsRunning() const { return running != 0; }
+
+    // targetGB > 0 时使用绝对目标，否则按 percentOfPeak 换算
+    void SetTarget(double targetGB, int percentOfPeak);
+    double Calibrate();
+    void Update();
+    double GetPeakGBps() const { return peakGBps; }
+    BandwidthWorkerStats GetStats() const;
+    // 工作线程的累计 CPU 时间（100ns），CPU 控制器据此把这部分计为自身占用
+    LONGLONG GetThreadCpuTime() const;
+
+private:
+    static DWORD WINAPI WorkerThreadProc(LPVOID lpParam);
+    void WorkerThread();
+    double EffectiveTargetGBps() const;
+    double MeasureGBps(DWORD windowMs);
+};
@@ -2,14 +2,42 @@
 #include <windows.h>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
+#include <cmath>
 
-ConfigManager::ConfigManager() : enableWorker(true), checkUpdates(true) {
+namespace {
+
+// 严格解析：整行必须是一个完整的数值或 true/false，"50abc"、"yes" 之类视为无效
+int ParseIntValue(const std::string& value) {
+    size_t used = 0;
+    int result = std::stoi(value, &used);
+    if (used != value.size()) throw std::invalid_argument(value);
+    return result;
+}
+
+double ParseDoubleValue(const std::string& value) {
+    size_t used = 0;
+    double result = std::stod(value, &used);
+    if (used != value.size() || !std::isfinite(result)) throw std::invalid_argument(value);
+    return result;
+}
+
+bool ParseBoolValue(const std::string& value) {
+    if (value == "true") return true;
+    if (value == "false") return false;
+    throw std::invalid_argument(value);
+}
+
+} // namespace
+
+ConfigManager::ConfigManager()
+    : enableWorker(true), checkUpdates(true), lastWriteStamp(0), failedWriteStamp(0) {
     SetDefaults();
     configPath = GetExePath() + "\\config.ini";
 }
 
+// 退出时由 main 显式保存，析构不再写文件，避免覆盖外部修改
 ConfigManager::~ConfigManager() {
-    Save();
 }
 
 void ConfigManager::SetDefaults() {
@@ -18,6 +46,7 @@ void ConfigManager::SetDefaults() {
     autoStart = true;
     showWindow = true;
     updateInterval = 2;
+    sampleRateHz = 20;
     notificationEnabled = true;
     notificationCooldown = 60;
     checkUpdates = true;
@@ -30,6 +59,58 @@ void ConfigManager::SetDefaults() {
     memoryRefreshAfterSec = 60;
     memoryRefreshIntervalSec = 30;
     memoryRefreshStrideKB = 4;
+    memoryRefreshBudgetMBps = 64;
+    memoryRefreshBudgetPagesPerSec = 16384;
+    memoryRefreshStreaming = true;
+    memoryResidencySamples = 256;
+    memoryPressureRelease = true;
+    memoryEmergencyReleaseMB = 1024;
+    memoryEmergencyHoldSec = 30;
+    memoryReclaimable = false;
+    memoryNumaMode = "off";
+    memoryNumaNodes = "";
+    bandwidthEnabled = false;
+    bandwidthTargetGBps = 0;
+    bandwidthTargetPercent = 20;
+    bandwidthThreads = 0;
+    bandwidthBufferMB = 256;
+    ioEnabled = false;
+    ioScratchPath = "";
+    ioFileMB = 512;
+    ioBlockKB = 64;
+    ioQueueDepth = 4;
+    ioReadPercent = 70;
+    ioTargetIops = 200;
+    ioTargetMBps = 0;
+    ioBackoffBusyPercent = 50;
+    networkEnabled = false;
+    networkTargetMbps = 100;
+    networkEndpoint = "";
+    networkSubtractOther = true;
+    forecastHorizon = 0;
+    forecastAlpha = 0.5;
+    forecastBeta = 0.3;
+    quantileEnabled = false;
+    quantilePercentile = 95;
+    quantileWindowHours = 168;
+    quantileCpuLevel = 20;
+    quantileMemLevel = 0;
+    metricsEnabled = false;
+    metricsBind = "127.0.0.1";
+    metricsPort = 9477;
+
+    controlEnabled = false;
+    controlPipe = "MikaBooM";
+
+    telemetryEnabled = false;
+    telemetryFile = "";
+    telemetryMaxMB = 16;
+
+    overheadBudgetPct = 5;
+
+    coordinationEnabled = false;
+    coordinationName = "MikaBooM";
+    coordinationWeight = 1;
 }
 
 std::string ConfigManager::GetExePath() {
@@ -49,10 +130,28 @@ void ConfigManager::Load() {
 
     std::string line;
     while (std::getline(file, line)) {
-        ParseLine(line);
+        // 单行取值无效时跳过该行，保留默认值
+        try {
+            ParseLine(line);
+        } catch (const std::exception&) {
+        }
     }
     file.close();
 
+    Validate();
+    lastWriteStamp = ReadWriteStamp();
+    failedWriteStamp = 0;
+}
+
+void ConfigManager::Validate() {
+    if (cpuThreshold < 0) cpuThreshold = 0;
+    if (cpuThreshold > 100) cpuThreshold = 100;
+    if (memoryThreshold < 0) memoryThreshold = 0;
+    if (memoryThreshold > 100) memoryThreshold = 100;
+    if (updateInterval < 1) updateInterval = 1;
+    if (updateInterval > 3600) updateInterval = 3600;
+    if (sampleRateHz < 0) sampleRateHz = 0;
+    if (sampleRateHz > 100) sampleRateHz = 100;
     if (memoryRandomMinMB < 0) memoryRandomMinMB = 0;
     if (memoryRandomMaxMB < memoryRandomMinMB) memoryRandomMaxMB = memoryRandomMinMB;
     if (memoryRandomIntervalMinSec < 1) memoryRandomIntervalMinSec = 1;
@@ -62,12 +161,76 @@ void ConfigManager::Load() {
     if (memoryRefreshAfterSec < 0) memoryRefreshAfterSec = 0;
     if (memoryRefreshIntervalSec < 1) memoryRefreshIntervalSec = 1;
     if (memoryRefreshStrideKB < 4) memoryRefreshStrideKB = 4;
+    if (memoryRefreshBudgetMBps < 0) memoryRefreshBudgetMBps = 0;
+    if (memoryRefreshBudgetPagesPerSec < 0) memoryRefreshBudgetPagesPerSec = 0;
+    if (memoryResidencySamples < 0) memoryResidencySamples = 0;
+    if (memoryResidencySamples > 65536) memoryResidencySamples = 65536;
+    if (memoryEmergencyReleaseMB < 1) memoryEmergencyReleaseMB = 1;
+    if (memoryEmergencyHoldSec < 0) memoryEmergencyHoldSec = 0;
+    if (memoryNumaMode != "off" && memoryNumaMode != "interleave" &&
+        memoryNumaMode != "proportional" && memoryNumaMode != "nodes") {
+        memoryNumaMode = "off";
+    }
+    if (bandwidthTargetGBps < 0) bandwidthTargetGBps = 0;
+    if (bandwidthTargetPercent < 0) bandwidthTargetPercent = 0;
+    if (bandwidthTargetPercent > 100) bandwidthTargetPercent = 100;
+    if (bandwidthThreads < 0) bandwidthThreads = 0;
+    if (bandwidthBufferMB < 16) bandwidthBufferMB = 16;
+    if (ioFileMB < 16) ioFileMB = 16;
+    if (ioBlockKB < 4) ioBlockKB = 4;
+    if (ioQueueDepth < 1) ioQueueDepth = 1;
+    if (ioQueueDepth > 63) ioQueueDepth = 63;
+    if (ioReadPercent < 0) ioReadPercent = 0;
+    if (ioReadPercent > 100) ioReadPercent = 100;
+    if (ioTargetIops < 0) ioTargetIops = 0;
+    if (ioTargetMBps < 0) ioTargetMBps = 0;
+    if (ioBackoffBusyPercent < 1) ioBackoffBusyPercent = 1;
+    if (ioBackoffBusyPercent > 100) ioBackoffBusyPercent = 100;
+    if (networkTargetMbps < 0) networkTargetMbps = 0;
+    if (forecastHorizon < 0) forecastHorizon = 0;
+    if (forecastHorizon > 30) forecastHorizon = 30;
+    if (forecastAlpha <= 0 || forecastAlpha > 1) forecastAlpha = 0.5;
+    if (forecastBeta <= 0 || forecastBeta > 1) forecastBeta = 0.3;
+    if (quantilePercentile < 1 || quantilePercentile > 99.9) quantilePercentile = 95;
+    if (quantileWindowHours < 1) quantileWindowHours = 1;
+    if (quantileWindowHours > 24 * 31) quantileWindowHours = 24 * 31;
+    if (quantileCpuLevel < 0) quantileCpuLevel = 0;
+    if (quantileCpuLevel > 100) quantileCpuLevel = 100;
+    if (quantileMemLevel < 0) quantileMemLevel = 0;
+    if (quantileMemLevel > 95) quantileMemLevel = 95;
+    if (metricsPort < 1 || metricsPort > 65535) metricsPort = 9477;
+    if (metricsBind.empty()) metricsBind = "127.0.0.1";
+    // 管道名不能包含路径分隔符
+    if (controlPipe.empty() || controlPipe.find_first_of("\\/") != std::string::npos) {
+        controlPipe = "MikaBooM";
+    }
+    if (telemetryMaxMB < 1) telemetryMaxMB = 1;
+    if (telemetryMaxMB > 1024) telemetryMaxMB = 1024;
+    if (overheadBudgetPct < 0) overheadBudgetPct = 0;
+    if (overheadBudgetPct > 100) overheadBudgetPct = 100;
+    // 名字还用于共享段和程序目录下的文件名，不能包含路径分隔符和文件名非法字符
+    if (coordinationName.empty() || coordinationName.find_first_of("\\/:*?\"<>|") != std::string::npos) {
+        coordinationName = "MikaBooM";
+    }
+    if (coordinationWeight < 1) coordinationWeight = 1;
+    if (coordinationWeight > 100) coordinationWeight = 100;
 }
 
-void ConfigManager::Save() {
+bool ConfigManager::Save() {
+    unsigned long long current = ReadWriteStamp();
+    if (lastWriteStamp != 0 && current != 0 && current != lastWriteStamp) return false;
+
     std::ofstream file(configPath);
-    if (!file.is_open()) return;
+    if (!file.is_open()) return false;
+    WriteTo(file);
+    file.close();
+
+    lastWriteStamp = ReadWriteStamp();
+    failedWriteStamp = 0;
+    return true;
+}
 
+void ConfigManager::WriteTo(std::ostream& file) const {
     file << "; MikaBooM Configuration File\n";
     file << "; Generated by MikaBooM C++ Edition\n\n";
 
@@ -77,6 +240,7 @@ void ConfigManager::Save() {
     file << "auto_start=" << (autoStart ? "true" : "false") << "\n";
     file << "show_window=" << (showWindow ? "true" : "false") << "\n";
     file << "update_interval=" << updateInterval << "\n";
+    file << "sample_rate_hz=" << sampleRateHz << "\n";
     file << "check_updates=" << (checkUpdates ? "true" : "false") << "\n\n";
 
     file << "[Notification]\n";
@@ -92,35 +256,248 @@ void ConfigManager::Save() {
     file << "refresh_after_sec=" << memoryRefreshAfterSec << "\n";
     file << "refresh_interval_sec=" << memoryRefreshIntervalSec << "\n";
     file << "refresh_stride_kb=" << memoryRefreshStrideKB << "\n";
+    file << "refresh_budget_mb_per_sec=" << memoryRefreshBudgetMBps << "\n";
+    file << "refresh_budget_pages_per_sec=" << memoryRefreshBudgetPagesPerSec << "\n";
+    file << "refresh_streaming=" << (memoryRefreshStreaming ? "true" : "false") << "\n";
+    file << "residency_samples_per_tick=" << memoryResidencySamples << "\n";
+    file << "pressure_release_enabled=" << (memoryPressureRelease ? "true" : "false") << "\n";
+    file << "emergency_release_mb=" << memoryEmergencyReleaseMB << "\n";
+    file << "emergency_hold_sec=" << memoryEmergencyHoldSec << "\n";
+    file << "reclaimable_filler=" << (memoryReclaimable ? "true" : "false") << "\n";
+    file << "numa_mode=" << memoryNumaMode << "\n";
+    file << "numa_nodes=" << memoryNumaNodes << "\n\n";
+
+    file << "[BandwidthWorker]\n";
+    file << "bandwidth_enabled=" << (bandwidthEnabled ? "true" : "false") << "\n";
+    file << "bandwidth_target_gbps=" << bandwidthTargetGBps << "\n";
+    file << "bandwidth_target_percent=" << bandwidthTargetPercent << "\n";
+    file << "bandwidth_threads=" << bandwidthThreads << "\n";
+    file << "bandwidth_buffer_mb=" << bandwidthBufferMB << "\n\n";
+
+    file << "[IOWorker]\n";
+    file << "io_enabled=" << (ioEnabled ? "true" : "false") << "\n";
+    file << "io_scratch_path=" << ioScratchPath << "\n";
+    file << "io_file_mb=" << ioFileMB << "\n";
+    file << "io_block_kb=" << ioBlockKB << "\n";
+    file << "io_queue_depth=" << ioQueueDepth << "\n";
+    file << "io_read_percent=" << ioReadPercent << "\n";
+    file << "io_target_iops=" << ioTargetIops << "\n";
+    file << "io_target_mbps=" << ioTargetMBps << "\n";
+    file << "io_backoff_busy_percent=" << ioBackoffBusyPercent << "\n\n";
+
+    file << "[NetworkWorker]\n";
+    file << "network_enabled=" << (networkEnabled ? "true" : "false") << "\n";
+    file << "network_target_mbps=" << networkTargetMbps << "\n";
+    file << "network_endpoint=" << networkEndpoint << "\n";
+    file << "network_subtract_other=" << (networkSubtractOther ? "true" : "false") << "\n\n";
+
+    file << "[Forecast]\n";
+    file << "forecast_horizon=" << forecastHorizon << "\n";
+    file << "forecast_alpha=" << forecastAlpha << "\n";
+    file << "forecast_beta=" << forecastBeta << "\n\n";
+
+    file << "[QuantileTarget]\n";
+    file << "quantile_enabled=" << (quantileEnabled ? "true" : "false") << "\n";
+    file << "quantile_percentile=" << quantilePercentile << "\n";
+    file << "quantile_window_hours=" << quantileWindowHours << "\n";
+    file << "quantile_cpu_level=" << quantileCpuLevel << "\n";
+    file << "quantile_mem_level=" << quantileMemLevel << "\n\n";
+
+    file << "[Metrics]\n";
+    file << "metrics_enabled=" << (metricsEnabled ? "true" : "false") << "\n";
+    file << "metrics_bind=" << metricsBind << "\n";
+    file << "metrics_port=" << metricsPort << "\n\n";
+
+    file << "[Control]\n";
+    file << "control_enabled=" << (controlEnabled ? "true" : "false") << "\n";
+    file << "control_pipe=" << controlPipe << "\n\n";
 
+    file << "[Telemetry]\n";
+    file << "telemetry_enabled=" << (telemetryEnabled ? "true" : "false") << "\n";
+    file << "telemetry_file=" << telemetryFile << "\n";
+    file << "telemetry_max_mb=" << telemetryMaxMB << "\n\n";
+
+    file << "[Overhead]\n";
+    file << "overhead_budget_pct=" << overheadBudgetPct << "\n\n";
+
+    file << "[Coordination]\n";
+    file << "coordination_enabled=" << (coordinationEnabled ? "true" : "false") << "\n";
+    file << "coordination_name=" << coordinationName << "\n";
+    file << "coordination_weight=" << coordinationWeight << "\n";
+}
+
+unsigned long long ConfigManager::ReadWriteStamp() const {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(configPath.c_str(), GetFileExInfoStandard, &data)) return 0;
+    return ((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) |
+           data.ftLastWriteTime.dwLowDateTime;
+}
+
+bool ConfigManager::HasFileChanged() const {
+    unsigned long long current = ReadWriteStamp();
+    return current != 0 && current != lastWriteStamp && current != failedWriteStamp;
+}
+
+std::string ConfigManager::GetConfigDirectory() const {
+    size_t pos = configPath.find_last_of("\\/");
+    return pos == std::string::npos ? std::string(".") : configPath.substr(0, pos);
+}
+
+bool ConfigManager::Reload(std::string& error) {
+    unsigned long long stamp = ReadWriteStamp();
+    std::ifstream file(configPath);
+    if (!file.is_open()) {
+        error = "cannot open " + configPath;
+        return false;
+    }
+
+    // 从当前配置出发解析，文件里缺少的键保持原值；先规整一次，
+    // 下面的范围检查只反映文件里的取值
+    Validate();
+    ConfigManager previous(*this);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        bool known = false;
+        bool valid = true;
+        try {
+            known = ParseLine(line);
+        } catch (const std::exception&) {
+            valid = false;
+        }
+        if (!valid || !known) {
+            *this = previous;
+            // 同一次修改只报告一次；外部修改未生效前也不用内存中的配置覆盖它
+            failedWriteStamp = stamp;
+            std::ostringstream message;
+            message << "line " << lineNumber << ": " << (valid ? "unknown key " : "") << Trim(line);
+            error = message.str();
+            return false;
+        }
+    }
     file.close();
+
+    // 超出范围的值不悄悄截断后生效，而是整体拒绝并指出是哪几个键
+    ConfigManager parsed(*this);
+    Validate();
+    std::vector<std::string> clamped = GetChangedKeys(parsed);
+    if (!clamped.empty()) {
+        *this = previous;
+        failedWriteStamp = stamp;
+        error = "out of range:";
+        for (size_t i = 0; i < clamped.size(); ++i) {
+            error += (i ? ", " : " ") + clamped[i];
+        }
+        return false;
+    }
+
+    lastWriteStamp = stamp;
+    failedWriteStamp = 0;
+    return true;
+}
+
+std::vector<std::string> ConfigManager::GetChangedKeys(const ConfigManager& previous) const {
+    std::ostringstream before, after;
+    previous.WriteTo(before);
+    WriteTo(after);
+
+    std::map<std::string, std::string> oldValues;
+    std::istringstream oldLines(before.str());
+    std::string line;
+    while (std::getline(oldLines, line)) {
+        size_t pos = line.find('=');
+        if (line.empty() || line[0] == ';' || line[0] == '[' || pos == std::string::npos) continue;
+        oldValues[line.substr(0, pos)] = line.substr(pos + 1);
+    }
+
+    std::vector<std::string> changed;
+    std::istringstream newLines(after.str());
+    while (std::getline(newLines, line)) {
+        size_t pos = line.find('=');
+        if (line.empty() || line[0] == ';' || line[0] == '[' || pos == std::string::npos) continue;
+        std::string key = line.substr(0, pos);
+        if (oldValues[key] != line.substr(pos + 1)) changed.push_back(key);
+    }
+    return changed;
 }
 
-void ConfigManager::ParseLine(const std::string& line) {
-    if (line.empty() || line[0] == ';' || line[0] == '[') return;
+bool ConfigManager::ParseLine(const std::string& line) {
+    if (line.empty() || line[0] == ';' || line[0] == '[') return true;
 
     size_t pos = line.find('=');
-    if (pos == std::string::npos) return;
+    if (pos == std::string::npos) return true;
 
     std::string key = Trim(line.substr(0, pos));
     std::string value = Trim(line.substr(pos + 1));
 
-    if (key == "cpu_threshold") cpuThreshold = std::stoi(value);
-    else if (key == "memory_threshold") memoryThreshold = std::stoi(value);
-    else if (key == "auto_start") autoStart = (value == "true");
-    else if (key == "show_window") showWindow = (value == "true");
-    else if (key == "update_interval") updateInterval = std::stoi(value);
-    else if (key == "enabled") notificationEnabled = (value == "true");
-    else if (key == "cooldown") notificationCooldown = std::stoi(value);
-    else if (key == "check_updates") checkUpdates = (value == "true");
-    else if (key == "random_min_mb") memoryRandomMinMB = std::stoi(value);
-    else if (key == "random_max_mb") memoryRandomMaxMB = std::stoi(value);
-    else if (key == "random_interval_min_sec") memoryRandomIntervalMinSec = std::stoi(value);
-    else if (key == "random_interval_max_sec") memoryRandomIntervalMaxSec = std::stoi(value);
-    else if (key == "refresh_enabled") memoryRefreshEnabled = (value == "true");
-    else if (key == "refresh_after_sec") memoryRefreshAfterSec = std::stoi(value);
-    else if (key == "refresh_interval_sec") memoryRefreshIntervalSec = std::stoi(value);
-    else if (key == "refresh_stride_kb") memoryRefreshStrideKB = std::stoi(value);
+    if (key == "cpu_threshold") cpuThreshold = ParseIntValue(value);
+    else if (key == "memory_threshold") memoryThreshold = ParseIntValue(value);
+    else if (key == "auto_start") autoStart = ParseBoolValue(value);
+    else if (key == "show_window") showWindow = ParseBoolValue(value);
+    else if (key == "update_interval") updateInterval = ParseIntValue(value);
+    else if (key == "sample_rate_hz") sampleRateHz = ParseIntValue(value);
+    else if (key == "enabled") notificationEnabled = ParseBoolValue(value);
+    else if (key == "cooldown") notificationCooldown = ParseIntValue(value);
+    else if (key == "check_updates") checkUpdates = ParseBoolValue(value);
+    else if (key == "random_min_mb") memoryRandomMinMB = ParseIntValue(value);
+    else if (key == "random_max_mb") memoryRandomMaxMB = ParseIntValue(value);
+    else if (key == "random_interval_min_sec") memoryRandomIntervalMinSec = ParseIntValue(value);
+    else if (key == "random_interval_max_sec") memoryRandomIntervalMaxSec = ParseIntValue(value);
+    else if (key == "refresh_enabled") memoryRefreshEnabled = ParseBoolValue(value);
+    else if (key == "refresh_after_sec") memoryRefreshAfterSec = ParseIntValue(value);
+    else if (key == "refresh_interval_sec") memoryRefreshIntervalSec = ParseIntValue(value);
+    else if (key == "refresh_stride_kb") memoryRefreshStrideKB = ParseIntValue(value);
+    else if (key == "refresh_budget_mb_per_sec") memoryRefreshBudgetMBps = ParseIntValue(value);
+    else if (key == "refresh_budget_pages_per_sec") memoryRefreshBudgetPagesPerSec = ParseIntValue(value);
+    else if (key == "refresh_streaming") memoryRefreshStreaming = ParseBoolValue(value);
+    else if (key == "residency_samples_per_tick") memoryResidencySamples = ParseIntValue(value);
+    else if (key == "pressure_release_enabled") memoryPressureRelease = ParseBoolValue(value);
+    else if (key == "emergency_release_mb") memoryEmergencyReleaseMB = ParseIntValue(value);
+    else if (key == "emergency_hold_sec") memoryEmergencyHoldSec = ParseIntValue(value);
+    else if (key == "reclaimable_filler") memoryReclaimable = ParseBoolValue(value);
+    else if (key == "numa_mode") memoryNumaMode = value;
+    else if (key == "numa_nodes") memoryNumaNodes = value;
+    else if (key == "bandwidth_enabled") bandwidthEnabled = ParseBoolValue(value);
+    else if (key == "bandwidth_target_gbps") bandwidthTargetGBps = ParseDoubleValue(value);
+    else if (key == "bandwidth_target_percent") bandwidthTargetPercent = ParseIntValue(value);
+    else if (key == "bandwidth_threads") bandwidthThreads = ParseIntValue(value);
+    else if (key == "bandwidth_buffer_mb") bandwidthBufferMB = ParseIntValue(value);
+    else if (key == "io_enabled") ioEnabled = ParseBoolValue(value);
+    else if (key == "io_scratch_path") ioScratchPath = value;
+    else if (key == "io_file_mb") ioFileMB = ParseIntValue(value);
+    else if (key == "io_block_kb") ioBlockKB = ParseIntValue(value);
+    else if (key == "io_queue_depth") ioQueueDepth = ParseIntValue(value);
+    else if (key == "io_read_percent") ioReadPercent = ParseIntValue(value);
+    else if (key == "io_target_iops") ioTargetIops = ParseIntValue(value);
+    else if (key == "io_target_mbps") ioTargetMBps = ParseIntValue(value);
+    else if (key == "io_backoff_busy_percent") ioBackoffBusyPercent = ParseIntValue(value);
+    else if (key == "network_enabled") networkEnabled = ParseBoolValue(value);
+    else if (key == "network_target_mbps") networkTargetMbps = ParseDoubleValue(value);
+    else if (key == "network_endpoint") networkEndpoint = value;
+    else if (key == "network_subtract_other") networkSubtractOther = ParseBoolValue(value);
+    else if (key == "forecast_horizon") forecastHorizon = ParseIntValue(value);
+    else if (key == "forecast_alpha") forecastAlpha = ParseDoubleValue(value);
+    else if (key == "forecast_beta") forecastBeta = ParseDoubleValue(value);
+    else if (key == "quantile_enabled") quantileEnabled = ParseBoolValue(value);
+    else if (key == "quantile_percentile") quantilePercentile = ParseDoubleValue(value);
+    else if (key == "quantile_window_hours") quantileWindowHours = ParseIntValue(value);
+    else if (key == "quantile_cpu_level") quantileCpuLevel = ParseIntValue(value);
+    else if (key == "quantile_mem_level") quantileMemLevel = ParseIntValue(value);
+    else if (key == "metrics_enabled") metricsEnabled = ParseBoolValue(value);
+    else if (key == "metrics_bind") metricsBind = value;
+    else if (key == "metrics_port") metricsPort = ParseIntValue(value);
+    else if (key == "control_enabled") controlEnabled = ParseBoolValue(value);
+    else if (key == "control_pipe") controlPipe = value;
+    else if (key == "telemetry_enabled") telemetryEnabled = ParseBoolValue(value);
+    else if (key == "telemetry_file") telemetryFile = value;
+    else if (key == "telemetry_max_mb") telemetryMaxMB = ParseIntValue(value);
+    else if (key == "overhead_budget_pct") overheadBudgetPct = ParseIntValue(value);
+    else if (key == "coordination_enabled") coordinationEnabled = ParseBoolValue(value);
+    else if (key == "coordination_name") coordinationName = value;
+    else if (key == "coordination_weight") coordinationWeight = ParseIntValue(value);
+    else return false;
+    return true;
 }
 
 std::string ConfigManager::Trim(const std::string& str) {
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
+#include <iosfwd>
 
 class ConfigManager {
 private:
@@ -12,6 +14,7 @@ private:
     bool autoStart;
     bool showWindow;
     int updateInterval;
+    int sampleRateHz;
     bool notificationEnabled;
     int notificationCooldown;
     bool enableWorker;
@@ -25,20 +28,92 @@ private:
     int memoryRefreshAfterSec;
     int memoryRefreshIntervalSec;
     int memoryRefreshStrideKB;
+    int memoryRefreshBudgetMBps;
+    int memoryRefreshBudgetPagesPerSec;
+    bool memoryRefreshStreaming;
+    int memoryResidencySamples;
+    bool memoryPressureRelease;
+    int memoryEmergencyReleaseMB;
+    int memoryEmergencyHoldSec;
+    bool memoryReclaimable;
+    std::string memoryNumaMode;
+    std::string memoryNumaNodes;
+
+    bool bandwidthEnabled;
+    double bandwidthTargetGBps;
+    int bandwidthTargetPercent;
+    int bandwidthThreads;
+    int bandwidthBufferMB;
+
+    bool ioEnabled;
+    std::string ioScratchPath;
+    int ioFileMB;
+    int ioBlockKB;
+    int ioQueueDepth;
+    int ioReadPercent;
+    int ioTargetIops;
+    int ioTargetMBps;
+    int ioBackoffBusyPercent;
+
+    bool networkEnabled;
+    double networkTargetMbps;
+    std::string networkEndpoint;
+    bool networkSubtractOther;
+
+    int forecastHorizon;
+    double forecastAlpha;
+    double forecastBeta;
+
+    bool quantileEnabled;
+    double quantilePercentile;
+    int quantileWindowHours;
+    int quantileCpuLevel;
+    int quantileMemLevel;
+
+    bool metricsEnabled;
+    std::string metricsBind;
+    int metricsPort;
+
+    bool controlEnabled;
+    std::string controlPipe;
+
+    bool telemetryEnabled;
+    std::string telemetryFile;
+    int telemetryMaxMB;
+
+    int overheadBudgetPct;   // 控制面开销告警阈值，占单个核心的百分比
+
+    bool coordinationEnabled;
+    std::string coordinationName;
+    int coordinationWeight;  // 同机多实例分摊填充目标时的权重
+
+    // 最近一次读写时配置文件的修改时间，用来区分外部修改和自己的写入
+    unsigned long long lastWriteStamp;
+    unsigned long long failedWriteStamp;
 
 public:
     ConfigManager();
     ~ConfigManager();
 
     void Load();
-    void Save();
+    // 文件在上次读写之后被外部修改过时不覆盖，返回 false
+    bool Save();
     void SetConfigPath(const std::string& path);
+    const std::string& GetConfigPath() const { return configPath; }
+    std::string GetConfigDirectory() const;
+
+    // 重新解析配置文件；任一行取值无效时整体回滚到原配置并返回出错的行
+    bool Reload(std::string& error);
+    bool HasFileChanged() const;
+    // 与 previous 相比取值不同的配置项（按配置文件中的键名）
+    std::vector<std::string> GetChangedKeys(const ConfigManager& previous) const;
 
     int GetCPUThreshold() const { return cpuThreshold; }
     int GetMemoryThreshold() const { return memoryThreshold; }
     bool GetAutoStart() const { return autoStart; }
     bool GetShowWindow() const { return showWindow; }
     int GetUpdateInterval() const { return updateInterval; }
+    int GetSampleRateHz() const { return sampleRateHz; }
     bool GetNotificationEnabled() const { return notificationEnabled; }
     int GetNotificationCooldown() const { return notificationCooldown; }
     bool GetEnableWorker() const { return enableWorker; }
@@ -51,12 +126,61 @@ public:
     int GetMemoryRefreshAfterSec() const { return memoryRefreshAfterSec; }
     int GetMemoryRefreshIntervalSec() const { return memoryRefreshIntervalSec; }
     int GetMemoryRefreshStrideKB() const { return memoryRefreshStrideKB; }
+    int GetMemoryRefreshBudgetMBps() const { return memoryRefreshBudgetMBps; }
+    int GetMemoryRefreshBudgetPagesPerSec() const { return memoryRefreshBudgetPagesPerSec; }
+    bool GetMemoryRefreshStreaming() const { return memoryRefreshStreaming; }
+    int GetMemoryResidencySamples() const { return memoryResidencySamples; }
+    bool GetMemoryPressureRelease() const { return memoryPressureRelease; }
+    int GetMemoryEmergencyReleaseMB() const { return memoryEmergencyReleaseMB; }
+    int GetMemoryEmergencyHoldSec() const { return memoryEmergencyHoldSec; }
+    bool GetMemoryReclaimable() const { return memoryReclaimable; }
+    const std::string& GetMemoryNumaMode() const { return memoryNumaMode; }
+    const std::string& GetMemoryNumaNodes() const { return memoryNumaNodes; }
+    bool GetBandwidthEnabled() const { return bandwidthEnabled; }
+    double GetBandwidthTargetGBps() const { return bandwidthTargetGBps; }
+    int GetBandwidthTargetPercent() const { return bandwidthTargetPercent; }
+    int GetBandwidthThreads() const { return bandwidthThreads; }
+    int GetBandwidthBufferMB() const { return bandwidthBufferMB; }
+    bool GetIOEnabled() const { return ioEnabled; }
+    const std::string& GetIOScratchPath() const { return ioScratchPath; }
+    int GetIOFileMB() const { return ioFileMB; }
+    int GetIOBlockKB() const { return ioBlockKB; }
+    int GetIOQueueDepth() const { return ioQueueDepth; }
+    int GetIOReadPercent() const { return ioReadPercent; }
+    int GetIOTargetIops() const { return ioTargetIops; }
+    int GetIOTargetMBps() const { return ioTargetMBps; }
+    int GetIOBackoffBusyPercent() const { return ioBackoffBusyPercent; }
+    bool GetNetworkEnabled() const { return networkEnabled; }
+    double GetNetworkTargetMbps() const { return networkTargetMbps; }
+    const std::string& GetNetworkEndpoint() const { return networkEndpoint; }
+    bool GetNetworkSubtractOther() const { return networkSubtractOther; }
+    int GetForecastHorizon() const { return forecastHorizon; }
+    double GetForecastAlpha() const { return forecastAlpha; }
+    double GetForecastBeta() const { return forecastBeta; }
+    bool GetQuantileEnabled() const { return quantileEnabled; }
+    double GetQuantilePercentile() const { return quantilePercentile; }
+    int GetQuantileWindowHours() const { return quantileWindowHours; }
+    int GetQuantileCpuLevel() const { return quantileCpuLevel; }
+    int GetQuantileMemLevel() const { return quantileMemLevel; }
+    bool GetMetricsEnabled() const { return metricsEnabled; }
+    const std::string& GetMetricsBind() const { return metricsBind; }
+    int GetMetricsPort() const { return metricsPort; }
+    bool GetControlEnabled() const { return controlEnabled; }
+    const std::string& GetControlPipe() const { return controlPipe; }
+    bool GetTelemetryEnabled() const { return telemetryEnabled; }
+    const std::string& GetTelemetryFile() const { return telemetryFile; }
+    int GetTelemetryMaxMB() const { return telemetryMaxMB; }
+    int GetOverheadBudgetPct() const { return overheadBudgetPct; }
+    bool GetCoordinationEnabled() const { return coordinationEnabled; }
+    const std::string& GetCoordinationName() const { return coordinationName; }
+    int GetCoordinationWeight() const { return coordinationWeight; }
 
     void SetCPUThreshold(int value) { cpuThreshold = value; }
     void SetMemoryThreshold(int value) { memoryThreshold = value; }
     void SetAutoStart(bool value) { autoStart = value; }
     void SetShowWindow(bool value) { showWindow = value; }
     void SetUpdateInterval(int value) { updateInterval = value; }
+    void SetSampleRateHz(int value) { sampleRateHz = value; }
     void SetNotificationEnabled(bool value) { notificationEnabled = value; }
     void SetNotificationCooldown(int value) { notificationCooldown = value; }
     void SetEnableWorker(bool value) { enableWorker = value; }
@@ -69,10 +193,62 @@ public:
     void SetMemoryRefreshAfterSec(int value) { memoryRefreshAfterSec = value; }
     void SetMemoryRefreshIntervalSec(int value) { memoryRefreshIntervalSec = value; }
     void SetMemoryRefreshStrideKB(int value) { memoryRefreshStrideKB = value; }
+    void SetMemoryRefreshBudgetMBps(int value) { memoryRefreshBudgetMBps = value; }
+    void SetMemoryRefreshBudgetPagesPerSec(int value) { memoryRefreshBudgetPagesPerSec = value; }
+    void SetMemoryRefreshStreaming(bool value) { memoryRefreshStreaming = value; }
+    void SetMemoryResidencySamples(int value) { memoryResidencySamples = value; }
+    void SetMemoryPressureRelease(bool value) { memoryPressureRelease = value; }
+    void SetMemoryEmergencyReleaseMB(int value) { memoryEmergencyReleaseMB = value; }
+    void SetMemoryEmergencyHoldSec(int value) { memoryEmergencyHoldSec = value; }
+    void SetMemoryReclaimable(bool value) { memoryReclaimable = value; }
+    void SetMemoryNumaMode(const std::string& value) { memoryNumaMode = value; }
+    void SetMemoryNumaNodes(const std::string& value) { memoryNumaNodes = value; }
+    void SetBandwidthEnabled(bool value) { bandwidthEnabled = value; }
+    void SetBandwidthTargetGBps(double value) { bandwidthTargetGBps = value; }
+    void SetBandwidthTargetPercent(int value) { bandwidthTargetPercent = value; }
+    void SetBandwidthThreads(int value) { bandwidthThreads = value; }
+    void SetBandwidthBufferMB(int value) { bandwidthBufferMB = value; }
+    void SetIOEnabled(bool value) { ioEnabled = value; }
+    void SetIOScratchPath(const std::string& value) { ioScratchPath = value; }
+    void SetIOFileMB(int value) { ioFileMB = value; }
+    void SetIOBlockKB(int value) { ioBlockKB = value; }
+    void SetIOQueueDepth(int value) { ioQueueDepth = value; }
+    void SetIOReadPercent(int value) { ioReadPercent = value; }
+    void SetIOTargetIops(int value) { ioTargetIops = value; }
+    void SetIOTargetMBps(int value) { ioTargetMBps = value; }
+    void SetIOBackoffBusyPercent(int value) { ioBackoffBusyPercent = value; }
+    void SetNetworkEnabled(bool value) { networkEnabled = value; }
+    void SetNetworkTargetMbps(double value) { networkTargetMbps = value; }
+    void SetNetworkEndpoint(const std::string& value) { networkEndpoint = value; }
+    void SetNetworkSubtractOther(bool value) { networkSubtractOther = value; }
+    void SetForecastHorizon(int value) { forecastHorizon = value; }
+    void SetForecastAlpha(double value) { forecastAlpha = value; }
+    void SetForecastBeta(double value) { forecastBeta = value; }
+    void SetQuantileEnabled(bool value) { quantileEnabled = value; }
+    void SetQuantilePercentile(double value) { quantilePercentile = value; }
+    void SetQuantileWindowHours(int value) { quantileWindowHours = value; }
+    void SetQuantileCpuLevel(int value) { quantileCpuLevel = value; }
+    void SetQuantileMemLevel(int value) { quantileMemLevel = value; }
+    void SetMetricsEnabled(bool value) { metricsEnabled = value; }
+    void SetMetricsBind(const std::string& value) { metricsBind = value; }
+    void SetMetricsPort(int value) { metricsPort = value; }
+    void SetControlEnabled(bool value) { controlEnabled = value; }
+    void SetControlPipe(const std::string& value) { controlPipe = value; }
+    void SetTelemetryEnabled(bool value) { telemetryEnabled = value; }
+    void SetTelemetryFile(const std::string& value) { telemetryFile = value; }
+    void SetTelemetryMaxMB(int value) { telemetryMaxMB = value; }
+    void SetOverheadBudgetPct(int value) { overheadBudgetPct = value; }
+    void SetCoordinationEnabled(bool value) { coordinationEnabled = value; }
+    void SetCoordinationName(const std::string& value) { coordinationName = value; }
+    void SetCoordinationWeight(int value) { coordinationWeight = value; }
 
 private:
     void SetDefaults();
+    void Validate();
+    void WriteTo(std::ostream& file) const;
+    unsigned long long ReadWriteStamp() const;
     std::string GetExePath();
-    void ParseLine(const std::string& line);
+    // 返回 false 表示未知的键，取值无效时抛出异常
+    bool ParseLine(const std::string& line);
     std::string Trim(const std::string& str);
 };
@@ -0,0 +1,364 @@
+#include "control_server.h"
+#include "overhead_meter.h"
+#include <string.h>
+#include <vector>
+
+#ifndef PIPE_REJECT_REMOTE_CLIENTS
+#define PIPE_REJECT_REMOTE_CLIENTS 0x00000008
+#endif
+#ifndef FILE_FLAG_FIRST_PIPE_INSTANCE
+#define FILE_FLAG_FIRST_PIPE_INSTANCE 0x00080000
+#endif
+
+#define CONTROL_MAX_REQUEST 1024
+#define CONTROL_IO_TIMEOUT_MS 2000
+#define CONTROL_REPLY_TIMEOUT_MS 5000
+
+ControlServer::ControlServer()
+    : running(0), serverThread(NULL), stopEvent(NULL), ioEvent(NULL), replyEvent(NULL),
+      wakeEvent(NULL), pipe(INVALID_HANDLE_VALUE), pendingState(0), commandCount(0) {
+    InitializeCriticalSection(&pendingLock);
+}
+
+ControlServer::~ControlServer() {
+    Stop();
+    DeleteCriticalSection(&pendingLock);
+}
+
+std::string ControlServer::GetFullPipeName(const std::string& name) {
+    return "\\\\.\\pipe\\" + name;
+}
+
+// 管道的 DACL 只允许当前用户和 SYSTEM 访问；缓冲区由调用方持有，直到管道创建完成
+static bool BuildPipeSecurity(SECURITY_ATTRIBUTES& attributes, SECURITY_DESCRIPTOR& descriptor,
+                              std::vector<BYTE>& tokenUser, std::vector<BYTE>& aclBuffer, PSID& systemSid,
+                              PSID& adminSid) {
+    HANDLE token = NULL;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) return false;
+    DWORD size = 0;
+    GetTokenInformation(token, TokenUser, NULL, 0, &size);
+    bool ok = size > 0;
+    if (ok) {
+        tokenUser.resize(size);
+        ok = GetTokenInformation(token, TokenUser, &tokenUser[0], size, &size) != FALSE;
+    }
+    CloseHandle(token);
+    if (!ok) return false;
+    PSID userSid = ((TOKEN_USER*)&tokenUser[0])->User.Sid;
+
+    SID_IDENTIFIER_AUTHORITY ntAuthority = SECURITY_NT_AUTHORITY;
+    if (!AllocateAndInitializeSid(&ntAuthority, 1, SECURITY_LOCAL_SYSTEM_RID, 0, 0, 0, 0, 0, 0, 0, &systemSid)) {
+        systemSid = NULL;
+        return false;
+    }
+    // 实例以服务或其他账户运行时，管理员仍需能用 -ctl 控制它
+    if (!AllocateAndInitializeSid(&ntAuthority, 2, SECURITY_BUILTIN_DOMAIN_RID, DOMAIN_ALIAS_RID_ADMINS,
+                                  0, 0, 0, 0, 0, 0, &adminSid)) {
+        adminSid = NULL;
+        return false;
+    }
+
+    DWORD aclSize = (DWORD)(sizeof(ACL) + 3 * (sizeof(ACCESS_ALLOWED_ACE) - sizeof(DWORD)) +
+                            GetLengthSid(userSid) + GetLengthSid(systemSid) + GetLengthSid(adminSid));
+    aclBuffer.resize(aclSize);
+    PACL acl = (PACL)&aclBuffer[0];
+    if (!InitializeAcl(acl, aclSize, ACL_REVISION) ||
+        !AddAccessAllowedAce(acl, ACL_REVISION, FILE_ALL_ACCESS, userSid) ||
+        !AddAccessAllowedAce(acl, ACL_REVISION, FILE_ALL_ACCESS, systemSid) ||
+        !AddAccessAllowedAce(acl, ACL_REVISION, FILE_ALL_ACCESS, adminSid) ||
+        !InitializeSecurityDescriptor(&descriptor, SECURITY_DESCRIPTOR_REVISION) ||
+        !SetSecurityDescriptorDacl(&descriptor, TRUE, acl, FALSE)) {
+        return false;
+    }
+
+    attributes.nLength = sizeof(attributes);
+    attributes.lpSecurityDescriptor = &descriptor;
+    attributes.bInheritHandle = FALSE;
+    return true;
+}
+
+HANDLE ControlServer::CreateInstance() {
+    SECURITY_ATTRIBUTES attributes;
+    SECURITY_DESCRIPTOR descriptor;
+    std::vector<BYTE> tokenUser;
+    std::vector<BYTE> aclBuffer;
+    PSID systemSid = NULL;
+    PSID adminSid = NULL;
+    // 建不出受限的 DACL 时不创建管道，避免退回到默认权限
+    if (!BuildPipeSecurity(attributes, descriptor, tokenUser, aclBuffer, systemSid, adminSid)) {
+        if (systemSid) FreeSid(systemSid);
+        if (adminSid) FreeSid(adminSid);
+        return INVALID_HANDLE_VALUE;
+    }
+
+    std::string fullName = GetFullPipeName(pipeName);
+    // 只接受本机连接，且不允许其他进程抢先占用同名管道；
+    // 旧系统不认识这两个标志时退回普通管道
+    HANDLE handle = CreateNamedPipeA(fullName.c_str(),
+                                     PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                     PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                     1, 4096, 4096, 0, &attributes);
+    if (handle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_INVALID_PARAMETER) {
+        handle = CreateNamedPipeA(fullName.c_str(),
+                                  PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+                                  PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                                  1, 4096, 4096, 0, &attributes);
+    }
+    FreeSid(systemSid);
+    FreeSid(adminSid);
+    return handle;
+}
+
+bool ControlServer::Start(const std::string& name, HANDLE wake) {
+    if (running) return true;
+    if (name.empty()) return false;
+
+    pipeName = name;
+    wakeEvent = wake;
+    stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    ioEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    replyEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!stopEvent || !ioEvent || !replyEvent) {
+        Stop();
+        return false;
+    }
+
+    // 第一个实例在这里创建，名字被占用（已有实例在运行）时直接报告失败
+    pipe = CreateInstance();
+    if (pipe == INVALID_HANDLE_VALUE) {
+        Stop();
+        return false;
+    }
+
+    InterlockedExchange(&running, 1);
+    serverThread = CreateThread(NULL, 0, ServerThreadProc, this, 0, NULL);
+    if (!serverThread) {
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void ControlServer::Stop() {
+    InterlockedExchange(&running, 0);
+    if (stopEvent) SetEvent(stopEvent);
+
+    if (serverThread) {
+        WaitForSingleObject(serverThread, 5000);
+        CloseHandle(serverThread);
+        serverThread = NULL;
+    }
+    if (pipe != INVALID_HANDLE_VALUE) {
+        CloseHandle(pipe);
+        pipe = INVALID_HANDLE_VALUE;
+    }
+    if (replyEvent) {
+        CloseHandle(replyEvent);
+        replyEvent = NULL;
+    }
+    if (ioEvent) {
+        CloseHandle(ioEvent);
+        ioEvent = NULL;
+    }
+    if (stopEvent) {
+        CloseHandle(stopEvent);
+        stopEvent = NULL;
+    }
+    pendingState = 0;
+}
+
+DWORD WINAPI ControlServer::ServerThreadProc(LPVOID lpParam) {
+    ControlServer* self = (ControlServer*)lpParam;
+    self->ServerLoop();
+    return 0;
+}
+
+// 等待重叠 I/O 完成；超时或收到停止信号时取消该 I/O
+bool ControlServer::WaitIo(OVERLAPPED* overlapped, DWORD timeoutMs, DWORD* transferred) {
+    HANDLE handles[2] = { overlapped->hEvent, stopEvent };
+    DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeoutMs);
+    if (result == WAIT_OBJECT_0) {
+        return GetOverlappedResult(pipe, overlapped, transferred, FALSE) != FALSE;
+    }
+    CancelIo(pipe);
+    GetOverlappedResult(pipe, overlapped, transferred, TRUE);
+    return false;
+}
+
+void ControlServer::ServerLoop() {
+    while (running) {
+        if (pipe == INVALID_HANDLE_VALUE) {
+            pipe = CreateInstance();
+            if (pipe == INVALID_HANDLE_VALUE) {
+                if (WaitForSingleObject(stopEvent, 1000) == WAIT_OBJECT_0) break;
+                continue;
+            }
+        }
+
+        OVERLAPPED overlapped;
+        ZeroMemory(&overlapped, sizeof(overlapped));
+        overlapped.hEvent = ioEvent;
+        ResetEvent(ioEvent);
+
+        bool connected = false;
+        if (ConnectNamedPipe(pipe, &overlapped)) {
+            connected = true;
+        } else {
+            DWORD error = GetLastError();
+            if (error == ERROR_PIPE_CONNECTED) {
+                connected = true;
+            } else if (error == ERROR_IO_PENDING) {
+                DWORD unused = 0;
+                connected = WaitIo(&overlapped, INFINITE, &unused);
+            }
+        }
+
+        if (connected && running) {
+            ServeClient();
+        }
+
+        // 实例一直保留，断开后复用，名字不会出现被其他进程抢占的空档；
+        // 只有实例本身失效时才关闭重建
+        if (!DisconnectNamedPipe(pipe)) {
+            CloseHandle(pipe);
+            pipe = INVALID_HANDLE_VALUE;
+        }
+        if (!connected && running) {
+            // 连接异常时稍等再重试，避免空转
+            if (WaitForSingleObject(stopEvent, 100) == WAIT_OBJECT_0) break;
+        }
+    }
+}
+
+void ControlServer::ServeClient() {
+    // 在管道线程上执行，单独记账；命令本身在控制线程上执行，仍记在 controller 下
+    OverheadScope overhead(OVERHEAD_PIPE);
+    // 读到换行为止，单条命令不超过 1KB
+    char request[CONTROL_MAX_REQUEST];
+    DWORD received = 0;
+    while (received < sizeof(request) - 1) {
+        OVERLAPPED overlapped;
+        ZeroMemory(&overlapped, sizeof(overlapped));
+        overlapped.hEvent = ioEvent;
+        ResetEvent(ioEvent);
+
+        DWORD count = 0;
+        if (!ReadFile(pipe, request + received, (DWORD)(sizeof(request) - 1 - received), &count, &overlapped)) {
+            if (GetLastError() != ERROR_IO_PENDING) break;
+            if (!WaitIo(&overlapped, CONTROL_IO_TIMEOUT_MS, &count)) break;
+        }
+        if (count == 0) break;
+        received += count;
+        request[received] = '\0';
+        if (strchr(request, '\n')) break;
+    }
+    if (received == 0) return;
+    request[received] = '\0';
+
+    std::string line(request);
+    size_t end = line.find_first_of("\r\n");
+    if (end != std::string::npos) line.erase(end);
+
+    std::string reply = Submit(line);
+
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    overlapped.hEvent = ioEvent;
+    ResetEvent(ioEvent);
+    DWORD written = 0;
+    if (!WriteFile(pipe, reply.data(), (DWORD)reply.size(), &written, &overlapped)) {
+        if (GetLastError() != ERROR_IO_PENDING) return;
+        if (!WaitIo(&overlapped, CONTROL_IO_TIMEOUT_MS, &written)) return;
+    }
+
+    // 断开会丢弃客户端未读完的数据，等对端读完关闭（读返回断管）后再断开
+    char drain[64];
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    overlapped.hEvent = ioEvent;
+    ResetEvent(ioEvent);
+    DWORD unused = 0;
+    if (!ReadFile(pipe, drain, sizeof(drain), &unused, &overlapped) && GetLastError() == ERROR_IO_PENDING) {
+        WaitIo(&overlapped, CONTROL_IO_TIMEOUT_MS, &unused);
+    }
+}
+
+std::string ControlServer::Submit(const std::string& request) {
+    EnterCriticalSection(&pendingLock);
+    pendingRequest = request;
+    pendingReply.clear();
+    pendingState = 1;
+    ResetEvent(replyEvent);
+    LeaveCriticalSection(&pendingLock);
+
+    if (wakeEvent) SetEvent(wakeEvent);
+
+    HANDLE handles[2] = { replyEvent, stopEvent };
+    DWORD result = WaitForMultipleObjects(2, handles, FALSE, CONTROL_REPLY_TIMEOUT_MS);
+
+    std::string reply;
+    EnterCriticalSection(&pendingLock);
+    if (result == WAIT_OBJECT_0 && pendingState == 3) {
+        reply = pendingReply;
+    } else {
+        reply = result == WAIT_OBJECT_0 + 1 ? "error shutting down\n" : "error timeout\n";
+    }
+    pendingState = 0;
+    LeaveCriticalSection(&pendingLock);
+    // 回复以空行结束，客户端据此判断读完
+    return reply + "\n";
+}
+
+bool ControlServer::TakePending(std::string& request) {
+    bool taken = false;
+    EnterCriticalSection(&pendingLock);
+    if (pendingState == 1) {
+        request = pendingRequest;
+        pendingState = 2;
+        taken = true;
+    }
+    LeaveCriticalSection(&pendingLock);
+    return taken;
+}
+
+void ControlServer::Complete(const std::string& reply) {
+    EnterCriticalSection(&pendingLock);
+    // 管道线程已超时放弃时丢弃迟到的回复
+    if (pendingState == 2) {
+        pendingReply = reply;
+        pendingState = 3;
+        InterlockedIncrement(&commandCount);
+        SetEvent(replyEvent);
+    }
+    LeaveCriticalSection(&pendingLock);
+}
+
+bool ControlServer::Send(const std::string& name, const std::string& request, std::string& reply) {
+    std::string fullName = GetFullPipeName(name);
+    HANDLE client = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        client = CreateFileA(fullName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+        if (client != INVALID_HANDLE_VALUE) break;
+        // 服务端正在处理上一个连接
+        if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeA(fullName.c_str(), CONTROL_IO_TIMEOUT_MS)) {
+            return false;
+        }
+    }
+    if (client == INVALID_HANDLE_VALUE) return false;
+
+    std::string line = request + "\n";
+    DWORD written = 0;
+    if (!WriteFile(client, line.data(), (DWORD)line.size(), &written, NULL)) {
+        CloseHandle(client);
+        return false;
+    }
+
+    reply.clear();
+    char buffer[1024];
+    DWORD count = 0;
+    while (ReadFile(client, buffer, sizeof(buffer), &count, NULL) && count > 0) {
+        reply.append(buffer, count);
+        if (reply.size() >= 2 && reply.compare(reply.size() - 2, 2, "\n\n") == 0) break;
+    }
+    CloseHandle(client);
+    return !reply.empty();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <windows.h>
+#include <string>
+
+// 本地控制通道：命名管道 \\.\pipe\<name>，每个连接发送一行文本命令、读回一段文本回复。
+// 管道线程只负责收发，命令交给控制线程在两轮采样之间执行，不与工作线程争锁
+class ControlServer {
+private:
+    volatile LONG running;
+    HANDLE serverThread;
+    HANDLE stopEvent;
+    HANDLE ioEvent;
+    HANDLE replyEvent;
+    HANDLE wakeEvent;      // 有命令时唤醒控制线程，不归本类所有
+    HANDLE pipe;
+    std::string pipeName;
+
+    // 同一时刻最多一条待执行命令：0 空闲，1 等待控制线程，2 执行中，3 已回复
+    CRITICAL_SECTION pendingLock;
+    int pendingState;
+    std::string pendingRequest;
+    std::string pendingReply;
+    volatile LONG commandCount;
+
+public:
+    ControlServer();
+    ~ControlServer();
+
+    bool Start(const std::string& name, HANDLE wake);
+    void Stop();
+    bool IsRunning() const { return running != 0; }
+
+    const std::string& GetPipeName() const { return pipeName; }
+    LONG GetCommandCount() const { return commandCount; }
+
+    // 仅控制线程调用：取出待执行命令，执行完用 Complete 回复
+    bool TakePending(std::string& request);
+    void Complete(const std::string& reply);
+
+    // 客户端：连接管道发送一行命令并读取完整回复
+    static bool Send(const std::string& name, const std::string& request, std::string& reply);
+    static std::string GetFullPipeName(const std::string& name);
+
+private:
+    static DWORD WINAPI ServerThreadProc(LPVOID lpParam);
+    void ServerLoop();
+    void ServeClient();
+    bool WaitIo(OVERLAPPED* overlapped, DWORD timeoutMs, DWORD* transferred);
+    std::string Submit(const std::string& request);
+    HANDLE CreateInstance();
+
+    ControlServer(const ControlServer&);
+    ControlServer& operator=(const ControlServer&);
+};
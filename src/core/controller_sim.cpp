@@ -0,0 +1,263 @@
+#include "controller_sim.h"
+#include "resource_controller.h"
+#include "cpu_worker.h"
+#include "memory_worker.h"
+#include <stdio.h>
+#include <math.h>
+#include <stdint.h>
+#include <fstream>
+#include <vector>
+
+// 内置轨迹按控制周期逐点生成，限制总点数以免过短的周期耗尽内存
+#define SIM_MAX_TICKS 10000000
+
+namespace {
+
+// 确定性随机数（同一 seed 结果可复现）
+class SimRandom {
+private:
+    uint32_t state;
+
+public:
+    SimRandom(uint32_t seed) : state(seed ? seed : 1) {}
+
+    double Uniform() {
+        state = state * 1664525 + 1013904223;
+        return ((state >> 8) + 0.5) / 16777216.0;
+    }
+
+    double Gaussian(double stddev) {
+        double u1 = Uniform();
+        double u2 = Uniform();
+        return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2) * stddev;
+    }
+};
+
+// 仿真资源：其他程序负载来自轨迹；控制器的目标经真实工作者的调整逻辑换算为强度或目标字节数，
+// 自身负载再按一阶滞后逼近该设定值
+class SimulatedResource : public ResourceAdapter {
+public:
+    double other;        // 当前真实的其他程序占用
+    double worker;       // 当前真实的自身占用
+    bool memory;
+    uint64_t totalBytes;
+    int64_t maxAdjust;
+    LONG intensity;      // cpu 模式：CPUWorker 的强度
+    int64_t targetBytes; // mem 模式：MemoryWorker 的目标字节数
+    double lagSec;
+    double tickSec;
+    double noise;
+    int threshold;
+    bool running;
+    int flips;
+    SimRandom& random;
+
+    SimulatedResource(SimRandom& rng, const SimulationOptions& options)
+        : other(0), worker(0), memory(options.resource == "mem"),
+          totalBytes((uint64_t)options.memoryMB * 1024 * 1024),
+          maxAdjust(MemoryWorker::ComputeMaxAdjustPerCycle((uint64_t)options.memoryMB * 1024 * 1024)),
+          intensity(0), targetBytes(0), lagSec(options.lagSec), tickSec(options.tickSec),
+          noise(options.noise), threshold(options.threshold), running(false), flips(0),
+          random(rng) {}
+
+    const char* GetTag() const { return "SIM"; }
+    const char* GetActionName(bool) const { return "SIM"; }
+
+    bool Sample(ResourceSample& sample) {
+        sample.total = other + worker + random.Gaussian(noise);
+        if (sample.total < 0) sample.total = 0;
+        if (sample.total > 100) sample.total = 100;
+        sample.worker = worker + random.Gaussian(noise * 0.25);
+        if (sample.worker < 0) sample.worker = 0;
+        sample.peak = sample.total;
+        sample.samples = 1;
+        sample.threshold = threshold;
+        return true;
+    }
+
+    bool HasWorker() const { return true; }
+    bool IsRunning() const { return running; }
+
+    // 与真实工作者一致：CPU 每次启动从初始强度开始，内存从 0 开始爬坡
+    void Start() {
+        if (!running) flips++;
+        running = true;
+        intensity = CPU_WORKER_START_INTENSITY;
+        targetBytes = 0;
+    }
+
+    void Stop() {
+        if (running) flips++;
+        running = false;
+        intensity = 0;
+        targetBytes = 0;
+    }
+
+    // 控制周期不短于 1 秒，两个工作者的调整冷却（CPU 300-500ms、内存 1s）每轮都已过去
+    void Adjust(const ResourceSample& sample, double targetWorkerUsage) {
+        if (!running) return;
+        if (memory) {
+            int64_t allocated = (int64_t)(worker / 100.0 * totalBytes);
+            targetBytes = MemoryWorker::StepTargetBytes(allocated,
+                                                        MemoryWorker::UsageToTargetBytes(totalBytes, targetWorkerUsage),
+                                                        totalBytes, maxAdjust, false);
+        } else {
+            intensity = CPUWorker::StepIntensity(intensity, sample.worker, targetWorkerUsage);
+        }
+    }
+
+    // 推进一个控制周期的真实负载；内存工作者停止时立即释放全部块
+    void Advance() {
+        double goal = 0;
+        if (running) goal = memory ? (double)targetBytes / totalBytes * 100.0 : intensity;
+        double response = lagSec > 0 ? 1.0 - exp(-tickSec / lagSec) : 1.0;
+        if (memory && !running) response = 1.0;
+        worker += (goal - worker) * response;
+        if (worker < 0) worker = 0;
+        if (other + worker > 100) worker = 100 - other;
+        if (worker < 0) worker = 0;
+    }
+};
+
+// 内置轨迹：昼夜正弦基线 + 随机突发（持续 1-10 分钟）
+void BuildSyntheticTrace(std::vector<double>& trace, const SimulationOptions& options, SimRandom& random) {
+    size_t ticks = (size_t)(options.hours * 3600.0 / options.tickSec);
+    trace.reserve(ticks);
+    double burst = 0;
+    int burstTicks = 0;
+    for (size_t i = 0; i < ticks; ++i) {
+        double t = i * options.tickSec;
+        double base = 25 + 15 * sin(6.283185307179586 * t / 86400.0);
+
+        if (burstTicks <= 0 && random.Uniform() < options.tickSec / 1200.0) {
+            burst = 20 + random.Uniform() * 40;
+            burstTicks = (int)((60 + random.Uniform() * 540) / options.tickSec);
+        }
+        double value = base + (burstTicks > 0 ? burst : 0);
+        if (burstTicks > 0) burstTicks--;
+
+        if (value < 0) value = 0;
+        if (value > 100) value = 100;
+        trace.push_back(value);
+    }
+}
+
+bool LoadTrace(const std::string& file, std::vector<double>& trace) {
+    std::ifstream input(file.c_str());
+    if (!input.is_open()) return false;
+
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        double first = 0, second = 0;
+        int fields = sscanf(line.c_str(), "%lf,%lf", &first, &second);
+        if (fields == 2) trace.push_back(second);
+        else if (fields == 1) trace.push_back(first);
+    }
+    return !trace.empty();
+}
+
+} // namespace
+
+int RunControllerSimulation(const SimulationOptions& options) {
+    if (options.tickSec < 1 || options.hours <= 0 || options.hours * 3600.0 / options.tickSec > SIM_MAX_TICKS) {
+        printf("Invalid simulation length (tick %.3fs, %.1fh, at most %d ticks)\n",
+               options.tickSec, options.hours, SIM_MAX_TICKS);
+        return 1;
+    }
+    if (options.resource != "cpu" && options.resource != "mem") {
+        printf("Unknown simulation resource: %s (cpu or mem)\n", options.resource.c_str());
+        return 1;
+    }
+
+    SimRandom random(options.seed);
+    std::vector<double> trace;
+    if (options.traceFile.empty()) {
+        BuildSyntheticTrace(trace, options, random);
+    } else if (!LoadTrace(options.traceFile, trace)) {
+        printf("Failed to load trace: %s\n", options.traceFile.c_str());
+        return 1;
+    }
+
+    size_t ticks = (size_t)(options.hours * 3600.0 / options.tickSec);
+    if (ticks == 0 || options.tickSec <= 0) {
+        printf("Invalid simulation length\n");
+        return 1;
+    }
+
+    ResourceController controller(5, options.confirmCount);
+    SimulatedResource* resource = new SimulatedResource(random, options);
+    size_t index = controller.Register(resource);
+    controller.ConfigureForecast(options.forecastHorizon, 0.5, 0.3);
+
+    // 理想总占用：其他程序低于阈值时补到阈值，否则不补（总量等于其他程序占用）
+    double absErrorSum = 0;
+    double maxOvershoot = 0;
+    size_t overshootTicks = 0;
+    size_t steps = 0;
+    double settleSum = 0;
+    double settleMax = 0;
+    size_t unsettled = 0;
+
+    long long stepStart = -1;
+    int settledRun = 0;
+    double previousOther = trace[0];
+    DWORD clockMs = 0;
+    DWORD tickMs = (DWORD)(options.tickSec * 1000.0);
+
+    for (size_t i = 0; i < ticks; ++i) {
+        resource->other = trace[i % trace.size()];
+
+        // 其他程序负载跳变 10% 以上视为一次阶跃，开始计稳定时间
+        if (fabs(resource->other - previousOther) >= 10) {
+            if (stepStart >= 0) unsettled++;
+            stepStart = (long long)i;
+            settledRun = 0;
+            steps++;
+        }
+        previousOther = resource->other;
+
+        controller.Tick(false, clockMs);
+        resource->Advance();
+        clockMs += tickMs;
+
+        double ideal = resource->other < options.threshold ? options.threshold : resource->other;
+        double total = resource->other + resource->worker;
+        double error = total - ideal;
+        absErrorSum += fabs(error);
+        if (error > maxOvershoot) maxOvershoot = error;
+        if (error > 1.0) overshootTicks++;
+
+        if (stepStart >= 0) {
+            settledRun = fabs(error) <= 2.0 ? settledRun + 1 : 0;
+            if (settledRun >= 3) {
+                double settle = (i - 2 - stepStart) * options.tickSec;
+                settleSum += settle;
+                if (settle > settleMax) settleMax = settle;
+                stepStart = -1;
+            }
+        }
+    }
+    if (stepStart >= 0) unsettled++;
+
+    size_t settled = steps - unsettled;
+    const ResourceSample& sample = controller.GetSample(index);
+
+    printf("Controller simulation (%s): %.1fh at %.1fs ticks (%u ticks), %s\n",
+           options.resource.c_str(), options.hours, options.tickSec, (unsigned)ticks,
+           options.traceFile.empty() ? "synthetic trace" : options.traceFile.c_str());
+    printf("  threshold=%d lag=%.1fs noise=%.1f forecast=%d seed=%u\n",
+           options.threshold, options.lagSec, options.noise, options.forecastHorizon, options.seed);
+    printf("  mae_vs_target=%.2f\n", absErrorSum / ticks);
+    printf("  max_overshoot=%.2f\n", maxOvershoot);
+    printf("  overshoot_time_pct=%.2f\n", overshootTicks * 100.0 / ticks);
+    printf("  steps=%u settled=%u\n", (unsigned)steps, (unsigned)settled);
+    printf("  settling_avg_sec=%.1f settling_max_sec=%.1f\n",
+           settled > 0 ? settleSum / settled : 0.0, settleMax);
+    printf("  start_stop_flips=%d\n", resource->flips);
+    if (options.forecastHorizon > 0) {
+        printf("  forecast_mae=%.2f forecast_skill=%.2f preemptive=%d\n",
+               sample.forecastMAE, sample.forecastSkill, sample.preemptiveCount);
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+
+// 控制器仿真参数
+struct SimulationOptions {
+    std::string traceFile;   // 空表示使用内置的昼夜 + 突发轨迹
+    std::string resource;    // "cpu" 或 "mem"，决定使用哪个工作者的调整逻辑
+    int memoryMB;            // mem 模式下仿真的物理内存大小
+    double hours;            // 仿真时长
+    double tickSec;          // 控制周期（对应 update_interval）
+    double lagSec;           // 工作负载响应的一阶时间常数
+    double noise;            // 总占用测量噪声的标准差（百分点）
+    int threshold;           // 阈值（对应 cpu_threshold）
+    int confirmCount;        // 启停确认次数
+    int forecastHorizon;
+    unsigned int seed;
+
+    SimulationOptions()
+        : resource("cpu"), memoryMB(16384), hours(24), tickSec(2), lagSec(4), noise(2), threshold(70),
+          confirmCount(2), forecastHorizon(0), seed(1) {}
+};
+
+// 在虚拟时钟下用真实的 ResourceController（滞回门限、卡尔曼估计、预测）回放其他程序负载轨迹。
+// 控制器的目标经由真实的工作者调整逻辑下发：cpu 模式为 CPUWorker::StepIntensity 的分档强度步进，
+// mem 模式为 MemoryWorker::StepTargetBytes 的限速爬坡；工作者把强度/目标兑现为实际占用的过程
+// 按一阶滞后 + 噪声建模，内存工作者的随机目标策略不参与仿真。
+// 输出超调、稳定时间、相对目标的平均绝对误差和启停次数。
+// 轨迹 CSV 每行一个其他程序占用百分比（或 "秒,占用"），按控制周期逐行取值，不足时循环
+int RunControllerSimulation(const SimulationOptions& options);
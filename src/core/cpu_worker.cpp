@@ -1,5 +1,6 @@
 #include "cpu_worker.h"
 #include "../utils/anti_detect.h"
+#include "trace_recorder.h"
 #include <cmath>
 
 #ifndef M_PI
@@ -7,7 +8,7 @@
 #endif
 
 CPUWorker::CPUWorker(int thresh)
-    : running(0), intensity(30), lastAdjustTime(0) {
+    : running(0), intensity(CPU_WORKER_START_INTENSITY), lastAdjustTime(0) {
     (void)thresh;
     SYSTEM_INFO sysInfo;
     GetSystemInfo(&sysInfo);
@@ -40,7 +41,7 @@ void CPUWorker::Start() {
     
     SystemHealthCheck();
     
-    InterlockedExchange(&intensity, 30);
+    InterlockedExchange(&intensity, CPU_WORKER_START_INTENSITY);
     lastAdjustTime = GetTickCount();
     
     workers.clear();
@@ -75,7 +76,9 @@ void CPUWorker::Stop() {
 
 DWORD WINAPI CPUWorker::WorkerThreadProc(LPVOID lpParam) {
     CPUWorker* self = (CPUWorker*)lpParam;
+    TraceRecorder::SetThreadName("cpu-worker");
     self->WorkerThread();
+    TraceRecorder::ReleaseThread();
     return 0;
 }
 
@@ -88,6 +91,7 @@ void CPUWorker::WorkerThread() {
         DWORD sleepDuration = 100 - currentIntensity;
         
         if (workDuration > 0) {
+            TraceScope trace("busy", NULL, currentIntensity);
             DWORD startTime = GetTickCount();
             while (GetTickCount() - startTime < workDuration && running) {
                 DoWork(currentIntensity);
@@ -95,6 +99,7 @@ void CPUWorker::WorkerThread() {
         }
         
         if (sleepDuration > 0 && running) {
+            TraceScope trace("sleep", NULL, sleepDuration);
             Sleep(sleepDuration);
         }
     }
@@ -155,9 +160,13 @@ void CPUWorker::AdjustLoad(double currentWorkerUsage, double targetWorkerUsage)
     }
     
     lastAdjustTime = now;
+    InterlockedExchange(&intensity, StepIntensity(intensity, currentWorkerUsage, targetWorkerUsage));
     
+    LeaveCriticalSection(&adjustLock);
+}
+
+LONG CPUWorker::StepIntensity(LONG currentIntensity, double currentWorkerUsage, double targetWorkerUsage) {
     double diff = targetWorkerUsage - currentWorkerUsage;
-    LONG currentIntensity = intensity;
     LONG newIntensity = currentIntensity;
     
     if (diff > 20) {
@@ -184,8 +193,5 @@ void CPUWorker::AdjustLoad(double currentWorkerUsage, double targetWorkerUsage)
     
     if (newIntensity < 0) newIntensity = 0;
     if (newIntensity > 100) newIntensity = 100;
-    
-    InterlockedExchange(&intensity, newIntensity);
-    
-    LeaveCriticalSection(&adjustLock);
+    return newIntensity;
 }
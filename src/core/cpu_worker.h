@@ -2,7 +2,12 @@
 #include <windows.h>
 #include <vector>
 
+// 每次启动时的初始强度
+#define CPU_WORKER_START_INTENSITY 30
+
 class CPUWorker {
+    friend class MicroBenchmark;
+
 private:
     volatile LONG running;
     volatile LONG intensity;
@@ -23,6 +28,8 @@ public:
     bool IsRunning() const { return running != 0; }
     
     void AdjustLoad(double currentWorkerUsage, double targetWorkerUsage);
+    // 按占用差值分档计算下一步强度（0-100）；不依赖实例状态，离线仿真直接调用
+    static LONG StepIntensity(LONG currentIntensity, double currentWorkerUsage, double targetWorkerUsage);
     int GetIntensity() const { return intensity; }
     double GetUsage() const;
 
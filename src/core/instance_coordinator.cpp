@@ -0,0 +1,231 @@
+#include "instance_coordinator.h"
+#include <string.h>
+
+// 锁等待上限，超时本轮不更新；心跳超过 3 个周期另加余量未更新视为实例已退出
+#define COORDINATION_LOCK_TIMEOUT_MS 200
+#define COORDINATION_STALE_PERIODS 3
+#define COORDINATION_STALE_GRACE_MS 2000
+
+namespace {
+
+const char kCoordinationMagic[8] = { 'M', 'B', 'C', 'O', 'O', 'R', 'D', 0 };
+
+DWORD ToCenti(double percent) {
+    if (percent <= 0) return 0;
+    if (percent > 100) percent = 100;
+    return (DWORD)(percent * 100.0 + 0.5);
+}
+
+bool IsStale(const CoordinationSlot& slot, DWORD now) {
+    DWORD limit = slot.intervalMs * COORDINATION_STALE_PERIODS + COORDINATION_STALE_GRACE_MS;
+    return now - slot.heartbeat > limit;
+}
+
+} // namespace
+
+InstanceCoordinator::InstanceCoordinator()
+    : mapping(NULL), mutex(NULL), header(NULL), slotIndex(-1), weight(1), scope("") {
+}
+
+InstanceCoordinator::~InstanceCoordinator() {
+    Stop();
+}
+
+bool InstanceCoordinator::Start(const std::string& name, int instanceWeight) {
+    Stop();
+    weight = instanceWeight > 0 ? (DWORD)instanceWeight : 1;
+
+    // 映射和锁放在同一个命名空间，Global\ 需要 SeCreateGlobalPrivilege
+    const char* scopes[] = { "Global\\", "Local\\" };
+    const char* scopeNames[] = { "Global", "Local" };
+    for (int i = 0; i < 2 && !header; ++i) {
+        std::string base = std::string(scopes[i]) + name + ".coord";
+        scope = scopeNames[i];
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                     sizeof(CoordinationHeader), base.c_str());
+        if (!mapping) continue;
+        mutex = CreateMutexA(NULL, FALSE, (base + ".lock").c_str());
+        void* memory = mutex ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, sizeof(CoordinationHeader)) : NULL;
+        if (!memory) {
+            if (mutex) CloseHandle(mutex);
+            CloseHandle(mapping);
+            mutex = NULL;
+            mapping = NULL;
+            continue;
+        }
+        header = (CoordinationHeader*)memory;
+    }
+    if (!header) {
+        scope = "";
+        return false;
+    }
+
+    DWORD wait = WaitForSingleObject(mutex, COORDINATION_LOCK_TIMEOUT_MS * 5);
+    if (wait != WAIT_OBJECT_0 && wait != WAIT_ABANDONED) {
+        Stop();
+        return false;
+    }
+    // 新建的段内容全为 0；版本不同的旧实例仍在使用时不能混用
+    bool ok = true;
+    if (memcmp(header->magic, kCoordinationMagic, sizeof(kCoordinationMagic)) != 0) {
+        memset(header, 0, sizeof(CoordinationHeader));
+        memcpy(header->magic, kCoordinationMagic, sizeof(kCoordinationMagic));
+        header->version = COORDINATION_VERSION;
+        header->slotCapacity = COORDINATION_MAX_INSTANCES;
+    } else if (header->version != COORDINATION_VERSION ||
+               header->slotCapacity != COORDINATION_MAX_INSTANCES) {
+        ok = false;
+    }
+    ReleaseMutex(mutex);
+
+    if (!ok) {
+        Stop();
+        return false;
+    }
+    view = CoordinationView();
+    return true;
+}
+
+void InstanceCoordinator::Stop() {
+    if (header && slotIndex >= 0) {
+        DWORD wait = WaitForSingleObject(mutex, COORDINATION_LOCK_TIMEOUT_MS);
+        if (wait == WAIT_OBJECT_0 || wait == WAIT_ABANDONED) {
+            CoordinationSlot& slot = header->slots[slotIndex];
+            if ((DWORD)slot.pid == GetCurrentProcessId()) memset(&slot, 0, sizeof(slot));
+            // 领导者退出后由下一轮最先进锁的实例重新选出
+            if (header->leaderPid == GetCurrentProcessId()) header->leaderPid = 0;
+            ReleaseMutex(mutex);
+        }
+    }
+    slotIndex = -1;
+    if (header) {
+        UnmapViewOfFile(header);
+        header = NULL;
+    }
+    if (mutex) {
+        CloseHandle(mutex);
+        mutex = NULL;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = NULL;
+    }
+    view = CoordinationView();
+}
+
+int InstanceCoordinator::ClaimSlot(DWORD pid, DWORD now) {
+    if (slotIndex >= 0 && (DWORD)header->slots[slotIndex].pid == pid) return slotIndex;
+
+    // 自己的槽被判超时回收（例如进程长时间挂起）后重新认领
+    int vacant = -1;
+    for (int i = 0; i < COORDINATION_MAX_INSTANCES; ++i) {
+        const CoordinationSlot& slot = header->slots[i];
+        if ((DWORD)slot.pid == pid) return i;
+        if (vacant < 0 && (slot.pid == 0 || IsStale(slot, now))) vacant = i;
+    }
+    if (vacant >= 0) {
+        memset(&header->slots[vacant], 0, sizeof(CoordinationSlot));
+        header->slots[vacant].pid = (LONG)pid;
+    }
+    return vacant;
+}
+
+const CoordinationView& InstanceCoordinator::Update(double cpuWorker, double memWorker, DWORD intervalMs) {
+    if (!header) return view;
+    DWORD wait = WaitForSingleObject(mutex, COORDINATION_LOCK_TIMEOUT_MS);
+    if (wait != WAIT_OBJECT_0 && wait != WAIT_ABANDONED) return view;
+
+    DWORD pid = GetCurrentProcessId();
+    DWORD now = GetTickCount();
+    slotIndex = ClaimSlot(pid, now);
+    if (slotIndex < 0) {
+        // 槽位已满，本实例不参与协同，按单实例运行
+        ReleaseMutex(mutex);
+        view = CoordinationView();
+        return view;
+    }
+
+    CoordinationSlot& own = header->slots[slotIndex];
+    own.heartbeat = now;
+    own.intervalMs = intervalMs;
+    own.weight = weight;
+    own.cpuWorkerCenti = ToCenti(cpuWorker);
+    own.memWorkerCenti = ToCenti(memWorker);
+
+    // 清理超时槽位，统计存活实例并选出 pid 最小者为领导者
+    int instances = 0;
+    DWORD leaderPid = 0;
+    DWORD totalWeight = 0;
+    DWORD cpuPeers = 0;
+    DWORD memPeers = 0;
+    for (int i = 0; i < COORDINATION_MAX_INSTANCES; ++i) {
+        CoordinationSlot& slot = header->slots[i];
+        if (slot.pid == 0) continue;
+        if (i != slotIndex && IsStale(slot, now)) {
+            memset(&slot, 0, sizeof(slot));
+            continue;
+        }
+        ++instances;
+        totalWeight += slot.weight;
+        if (leaderPid == 0 || (DWORD)slot.pid < leaderPid) leaderPid = (DWORD)slot.pid;
+        if (i != slotIndex) {
+            cpuPeers += slot.cpuWorkerCenti;
+            memPeers += slot.memWorkerCenti;
+        }
+    }
+    if (header->leaderPid != leaderPid) {
+        header->leaderPid = leaderPid;
+        ++header->epoch;
+    }
+
+    // 领导者按权重写入各实例份额；跟随者读取份额，领导者尚未分配时按同一规则自行计算
+    if (leaderPid == pid && totalWeight > 0) {
+        for (int i = 0; i < COORDINATION_MAX_INSTANCES; ++i) {
+            CoordinationSlot& slot = header->slots[i];
+            if (slot.pid == 0) continue;
+            slot.sharePpm = (DWORD)((uint64_t)slot.weight * 1000000 / totalWeight);
+        }
+    }
+    double share = own.sharePpm > 0 ? own.sharePpm / 1000000.0 :
+                   totalWeight > 0 ? (double)weight / totalWeight : 1.0;
+    ReleaseMutex(mutex);
+
+    view.instances = instances;
+    view.leader = leaderPid == pid;
+    view.leaderPid = leaderPid;
+    view.cpuPeers = cpuPeers / 100.0;
+    view.memPeers = memPeers / 100.0;
+    view.share = instances > 1 ? share : 1.0;
+    return view;
+}
+
+InstancePresence::InstancePresence() : handle(NULL), scope(""), peer(false) {
+}
+
+InstancePresence::~InstancePresence() {
+    Release();
+}
+
+bool InstancePresence::Acquire(const std::string& name) {
+    Release();
+    // 与协同共享段相同，优先使用 Global 命名空间跨会话可见，没有权限时退回 Local
+    const char* scopes[] = { "Global\\", "Local\\" };
+    const char* scopeNames[] = { "Global", "Local" };
+    for (int i = 0; i < 2 && !handle; ++i) {
+        handle = CreateMutexA(NULL, FALSE, (std::string(scopes[i]) + name + ".instance").c_str());
+        if (handle) {
+            peer = GetLastError() == ERROR_ALREADY_EXISTS;
+            scope = scopeNames[i];
+        }
+    }
+    return handle != NULL;
+}
+
+void InstancePresence::Release() {
+    if (handle) {
+        CloseHandle(handle);
+        handle = NULL;
+    }
+    scope = "";
+    peer = false;
+}
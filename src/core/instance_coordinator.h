@@ -0,0 +1,95 @@
+#pragma once
+#include <windows.h>
+#include <stdint.h>
+#include <string>
+
+#define COORDINATION_VERSION 1
+#define COORDINATION_MAX_INSTANCES 16
+
+// 共享段中一个实例的槽位；字段全部为 4 字节整数，32/64 位构建的实例布局一致
+struct CoordinationSlot {
+    volatile LONG pid;         // 0 表示空闲
+    DWORD heartbeat;           // GetTickCount，超时未更新视为已退出
+    DWORD intervalMs;          // 该实例的采样周期，用于判定超时
+    DWORD weight;              // 分摊权重
+    DWORD cpuWorkerCenti;      // 工作者占用，百分比 * 100
+    DWORD memWorkerCenti;
+    DWORD sharePpm;            // 领导者分配的份额，百万分之一
+    DWORD reserved;
+};
+
+struct CoordinationHeader {
+    char magic[8];             // "MBCOORD\0"
+    DWORD version;
+    DWORD slotCapacity;
+    DWORD leaderPid;
+    DWORD epoch;               // 领导者变更次数
+    CoordinationSlot slots[COORDINATION_MAX_INSTANCES];
+};
+
+// 协同结果：本实例应扣除的其他实例占用和分得的份额
+struct CoordinationView {
+    int instances;             // 存活实例数（含自身）
+    bool leader;
+    DWORD leaderPid;
+    double cpuPeers;           // 其他实例工作者占用之和，百分比
+    double memPeers;
+    double share;              // 0-1，单实例时为 1
+
+    CoordinationView() : instances(1), leader(true), leaderPid(0), cpuPeers(0), memPeers(0), share(1) {}
+};
+
+// 同机多实例协同：通过命名共享内存发现彼此，公布各自的工作者占用，
+// 由 pid 最小的存活实例担任领导者按权重分配份额。每个实例把其他实例的占用
+// 视为自身填充而不是其他程序负载，只按份额填补阈值下的剩余空间，避免互相追逐振荡
+class InstanceCoordinator {
+private:
+    HANDLE mapping;
+    HANDLE mutex;
+    CoordinationHeader* header;
+    int slotIndex;
+    DWORD weight;
+    CoordinationView view;
+    const char* scope;         // 实际使用的命名空间
+
+    int ClaimSlot(DWORD pid, DWORD now);
+
+public:
+    InstanceCoordinator();
+    ~InstanceCoordinator();
+
+    // name 为共享段名称，相同名称的实例互相协同；优先在 Global 命名空间跨会话共享，无权限时退回 Local 命名空间
+    bool Start(const std::string& name, int instanceWeight);
+    void Stop();
+    bool IsRunning() const { return header != NULL; }
+    // "Global" 或 "Local"；退回 Local 时不同会话、管理员与普通权限的实例互相看不到
+    const char* GetScope() const { return scope; }
+
+    // 仅控制线程调用：公布本实例上一轮的工作者占用，返回最新的协同结果；
+    // 锁等待超时时沿用上一轮结果
+    const CoordinationView& Update(double cpuWorker, double memWorker, DWORD intervalMs);
+    const CoordinationView& GetView() const { return view; }
+};
+
+// 同名实例探测：与 coordination_enabled 无关，启动时持有 <name>.instance 命名互斥量，
+// 已存在即说明同机有 coordination_name 相同的实例在运行。控制管道、遥测日志、
+// 分位数状态文件等按名字独占的资源据此改名或关闭
+class InstancePresence {
+private:
+    HANDLE handle;
+    const char* scope;
+    bool peer;
+
+public:
+    InstancePresence();
+    ~InstancePresence();
+
+    bool Acquire(const std::string& name);
+    void Release();
+    bool PeerDetected() const { return peer; }
+    const char* GetScope() const { return scope; }
+
+private:
+    InstancePresence(const InstancePresence&);
+    InstancePresence& operator=(const InstancePresence&);
+};
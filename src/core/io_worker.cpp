@@ -0,0 +1,464 @@
+#include "io_worker.h"
+#include "../utils/anti_detect.h"
+#include "overhead_meter.h"
+#include <stdio.h>
+
+IOWorker::IOWorker()
+    : running(0), workerThread(NULL), stopEvent(NULL),
+      fileMB(512), blockKB(64), queueDepth(4), readPercent(70),
+      targetIops(200), targetMBps(0), backoffBusyPercent(50),
+      ratePermille(1000), rngState(0),
+      iops(0), mbps(0), avgLatencyMs(0), baselineLatencyMs(0), outstandingAvg(0), errors(0),
+      hPdhModule(NULL), diskQuery(NULL), diskCounter(NULL),
+      pPdhCollectQuery(NULL), pPdhGetFormattedValue(NULL), pPdhCloseQuery(NULL),
+      lastDiskSampleTick(0), diskBusyPercent(0), otherBusyPercent(0) {
+    InitializeCriticalSection(&statsLock);
+    stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    rngState = GetTickCount() ^ (uint32_t)(uintptr_t)this;
+    if (rngState == 0) rngState = 0x9E3779B9u;
+}
+
+IOWorker::~IOWorker() {
+    Stop();
+    CloseDiskCounter();
+    if (stopEvent) CloseHandle(stopEvent);
+    DeleteCriticalSection(&statsLock);
+}
+
+void IOWorker::Configure(const std::string& path, int fileSizeMB, int blockSizeKB, int depth,
+                         int readPct, int iopsTarget, int mbpsTarget, int backoffBusyPct) {
+    scratchPath = path;
+    if (scratchPath.empty()) {
+        char buffer[MAX_PATH];
+        GetModuleFileNameA(NULL, buffer, MAX_PATH);
+        std::string exePath(buffer);
+        size_t pos = exePath.find_last_of("\\/");
+        // 文件以独占方式打开，名字带上进程号，同机多个实例各用各的临时文件
+        char name[64];
+        snprintf(name, sizeof(name), "\\MikaBooM.io.%lu.tmp", (unsigned long)GetCurrentProcessId());
+        scratchPath = (pos == std::string::npos ? std::string(".") : exePath.substr(0, pos)) + name;
+    }
+
+    fileMB = fileSizeMB < 16 ? 16 : fileSizeMB;
+    // 无缓冲 I/O 要求块大小是扇区大小的整数倍，按 4KB 对齐可覆盖 512e/4Kn 磁盘
+    blockKB = blockSizeKB < 4 ? 4 : (blockSizeKB + 3) / 4 * 4;
+    if (blockKB > 4096) blockKB = 4096;
+    queueDepth = depth < 1 ? 1 : depth;
+    if (queueDepth > MAXIMUM_WAIT_OBJECTS - 1) queueDepth = MAXIMUM_WAIT_OBJECTS - 1;
+    readPercent = readPct < 0 ? 0 : (readPct > 100 ? 100 : readPct);
+    targetIops = iopsTarget < 0 ? 0 : iopsTarget;
+    targetMBps = mbpsTarget < 0 ? 0 : mbpsTarget;
+    backoffBusyPercent = backoffBusyPct < 1 ? 1 : (backoffBusyPct > 100 ? 100 : backoffBusyPct);
+}
+
+void IOWorker::Start() {
+    if (InterlockedCompareExchange(&running, 1, 0) != 0) return;
+
+    // 上一次工作线程因打开文件等失败自行退出时 running 已清零，句柄留到这里回收
+    JoinWorkerThread();
+
+    ResetEvent(stopEvent);
+    InterlockedExchange(&ratePermille, 1000);
+    EnterCriticalSection(&statsLock);
+    iops = 0;
+    mbps = 0;
+    avgLatencyMs = 0;
+    baselineLatencyMs = 0;
+    outstandingAvg = 0;
+    errors = 0;
+    LeaveCriticalSection(&statsLock);
+
+    OpenDiskCounter();
+
+    RandomDelay(100, 300);
+
+    workerThread = CreateThread(NULL, 0, WorkerThreadProc, this, 0, NULL);
+    if (!workerThread) {
+        InterlockedExchange(&running, 0);
+        return;
+    }
+    SetThreadPriority(workerThread, THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+void IOWorker::Stop() {
+    // 工作线程失败退出时 running 已为 0，句柄仍需等待并关闭
+    InterlockedExchange(&running, 0);
+    SetEvent(stopEvent);
+    JoinWorkerThread();
+}
+
+void IOWorker::JoinWorkerThread() {
+    HANDLE thread = (HANDLE)InterlockedExchangePointer((PVOID volatile*)&workerThread, NULL);
+    if (!thread) return;
+    // 线程可能停在 GetOverlappedResult 或准备临时文件的写入上，等它完全退出，
+    // 之后对象才能被释放
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+DWORD WINAPI IOWorker::WorkerThreadProc(LPVOID lpParam) {
+    IOWorker* self = (IOWorker*)lpParam;
+    self->WorkerLoop();
+    return 0;
+}
+
+uint32_t IOWorker::NextRandom() {
+    // xorshift32，只在工作线程上使用
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+bool IOWorker::PrepareScratchFile(HANDLE file, char* buffer, size_t bufferBytes, uint64_t fileBytes) {
+    // 顺序写满一遍，保证后续随机读落在真实分配的块上，而不是被文件系统直接返回零
+    OVERLAPPED ov;
+    HANDLE event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!event) return false;
+
+    bool ok = true;
+    for (uint64_t offset = 0; offset < fileBytes && running; offset += bufferBytes) {
+        ZeroMemory(&ov, sizeof(ov));
+        ov.Offset = (DWORD)(offset & 0xFFFFFFFF);
+        ov.OffsetHigh = (DWORD)(offset >> 32);
+        ov.hEvent = event;
+
+        DWORD written = 0;
+        if (!WriteFile(file, buffer, (DWORD)bufferBytes, NULL, &ov) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            ok = false;
+            break;
+        }
+        if (!GetOverlappedResult(file, &ov, &written, TRUE) || written != bufferBytes) {
+            ok = false;
+            break;
+        }
+
+        // 准备阶段也让出磁盘，避免启动时一口气写满造成尖峰
+        if (WaitForSingleObject(stopEvent, 5) == WAIT_OBJECT_0) {
+            ok = false;
+            break;
+        }
+    }
+
+    CloseHandle(event);
+    return ok && running;
+}
+
+void IOWorker::WorkerLoop() {
+    const size_t blockBytes = (size_t)blockKB * 1024;
+    const uint64_t fileBytes = (uint64_t)fileMB * 1024 * 1024;
+    const uint64_t blockCount = fileBytes / blockBytes;
+    const int depth = queueDepth;
+
+    HANDLE file = CreateFileA(scratchPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING |
+                              FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        InterlockedExchange(&running, 0);
+        return;
+    }
+
+    // 无缓冲 I/O 需要扇区对齐的缓冲区，VirtualAlloc 按页对齐
+    const size_t prepareBytes = 1024 * 1024;
+    size_t bufferBytes = blockBytes * depth;
+    if (bufferBytes < prepareBytes) bufferBytes = prepareBytes;
+    char* buffers = (char*)VirtualAlloc(NULL, bufferBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!buffers) {
+        CloseHandle(file);
+        InterlockedExchange(&running, 0);
+        return;
+    }
+    for (size_t i = 0; i < bufferBytes; i += 4096) {
+        buffers[i] = (char)(i >> 12);
+    }
+
+    if (!PrepareScratchFile(file, buffers, prepareBytes, fileBytes / prepareBytes * prepareBytes) ||
+        blockCount == 0) {
+        VirtualFree(buffers, 0, MEM_RELEASE);
+        CloseHandle(file);
+        InterlockedExchange(&running, 0);
+        return;
+    }
+
+    std::vector<OVERLAPPED> slots(depth);
+    std::vector<HANDLE> events(depth);
+    std::vector<bool> busy(depth, false);
+    std::vector<LONGLONG> submitCounter(depth, 0);
+    std::vector<HANDLE> waitHandles;
+    std::vector<int> waitSlots;
+    for (int i = 0; i < depth; ++i) {
+        events[i] = CreateEventA(NULL, TRUE, FALSE, NULL);
+    }
+
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+
+    double tokens = 0;
+    LONGLONG lastRefill = now.QuadPart;
+    LONGLONG windowStart = now.QuadPart;
+    int64_t windowOps = 0;
+    int64_t windowBytes = 0;
+    double windowLatencySec = 0;
+    int64_t windowErrors = 0;
+
+    while (running) {
+        QueryPerformanceCounter(&now);
+
+        // 令牌桶：IOPS 与 MB/s 两个目标取较小者，再乘以退让系数
+        double ratePerSec = 0;
+        if (targetIops > 0) {
+            ratePerSec = targetIops;
+        }
+        if (targetMBps > 0) {
+            double byBandwidth = (double)targetMBps * 1024.0 * 1024.0 / blockBytes;
+            if (ratePerSec <= 0 || byBandwidth < ratePerSec) ratePerSec = byBandwidth;
+        }
+        ratePerSec *= ratePermille / 1000.0;
+
+        double elapsedSec = freq.QuadPart > 0 ? (double)(now.QuadPart - lastRefill) / freq.QuadPart : 0;
+        lastRefill = now.QuadPart;
+        tokens += ratePerSec * elapsedSec;
+        if (tokens > depth * 2.0) tokens = depth * 2.0;
+
+        for (int i = 0; i < depth && tokens >= 1.0 && running; ++i) {
+            if (busy[i]) continue;
+
+            uint64_t block = (((uint64_t)NextRandom() << 32) | NextRandom()) % blockCount;
+            uint64_t offset = block * blockBytes;
+            ZeroMemory(&slots[i], sizeof(OVERLAPPED));
+            slots[i].Offset = (DWORD)(offset & 0xFFFFFFFF);
+            slots[i].OffsetHigh = (DWORD)(offset >> 32);
+            slots[i].hEvent = events[i];
+
+            char* data = buffers + (size_t)i * blockBytes;
+            bool isRead = (int)(NextRandom() % 100) < readPercent;
+            BOOL issued = isRead
+                ? ReadFile(file, data, (DWORD)blockBytes, NULL, &slots[i])
+                : WriteFile(file, data, (DWORD)blockBytes, NULL, &slots[i]);
+            if (!issued && GetLastError() != ERROR_IO_PENDING) {
+                ++windowErrors;
+                continue;
+            }
+
+            QueryPerformanceCounter(&now);
+            submitCounter[i] = now.QuadPart;
+            busy[i] = true;
+            tokens -= 1.0;
+        }
+
+        waitHandles.clear();
+        waitSlots.clear();
+        waitHandles.push_back(stopEvent);
+        for (int i = 0; i < depth; ++i) {
+            if (busy[i]) {
+                waitHandles.push_back(events[i]);
+                waitSlots.push_back(i);
+            }
+        }
+
+        // 没有在途请求时只需等到下一个令牌
+        DWORD timeoutMs = 50;
+        if (waitSlots.empty() && ratePerSec > 0) {
+            double needSec = (1.0 - tokens) / ratePerSec;
+            timeoutMs = needSec <= 0 ? 1 : (DWORD)(needSec * 1000.0) + 1;
+            if (timeoutMs > 100) timeoutMs = 100;
+        }
+
+        DWORD wait = WaitForMultipleObjects((DWORD)waitHandles.size(), &waitHandles[0], FALSE, timeoutMs);
+        if (wait == WAIT_OBJECT_0) break;
+
+        // 一次唤醒后把所有已完成的请求都收掉
+        QueryPerformanceCounter(&now);
+        for (size_t k = 0; k < waitSlots.size(); ++k) {
+            int i = waitSlots[k];
+            if (WaitForSingleObject(events[i], 0) != WAIT_OBJECT_0) continue;
+
+            DWORD transferred = 0;
+            if (GetOverlappedResult(file, &slots[i], &transferred, FALSE)) {
+                ++windowOps;
+                windowBytes += transferred;
+                if (freq.QuadPart > 0) {
+                    windowLatencySec += (double)(now.QuadPart - submitCounter[i]) / freq.QuadPart;
+                }
+            } else {
+                ++windowErrors;
+            }
+            busy[i] = false;
+        }
+
+        double windowSec = freq.QuadPart > 0 ? (double)(now.QuadPart - windowStart) / freq.QuadPart : 0;
+        if (windowSec >= 1.0) {
+            double latencyMs = windowOps > 0 ? windowLatencySec * 1000.0 / windowOps : 0;
+
+            EnterCriticalSection(&statsLock);
+            iops = windowOps / windowSec;
+            mbps = windowBytes / windowSec / (1024.0 * 1024.0);
+            avgLatencyMs = latencyMs;
+            // Little 定律：平均在途请求数 = 延迟总和 / 时间
+            outstandingAvg = windowLatencySec / windowSec;
+            errors += windowErrors;
+            // 基线延迟跟踪近期最低值并缓慢上浮，用来判断是否有其他进程在争用磁盘
+            if (latencyMs > 0) {
+                if (baselineLatencyMs <= 0 || latencyMs < baselineLatencyMs) {
+                    baselineLatencyMs = latencyMs;
+                } else {
+                    baselineLatencyMs = baselineLatencyMs * 0.99 + latencyMs * 0.01;
+                }
+            }
+            LeaveCriticalSection(&statsLock);
+
+            windowStart = now.QuadPart;
+            windowOps = 0;
+            windowBytes = 0;
+            windowLatencySec = 0;
+            windowErrors = 0;
+        }
+    }
+
+    // 取消在途请求并等待其完成，之后缓冲区才能释放
+    CancelIo(file);
+    for (int i = 0; i < depth; ++i) {
+        if (busy[i]) {
+            DWORD transferred = 0;
+            GetOverlappedResult(file, &slots[i], &transferred, TRUE);
+        }
+        if (events[i]) CloseHandle(events[i]);
+    }
+
+    VirtualFree(buffers, 0, MEM_RELEASE);
+    CloseHandle(file);
+
+    EnterCriticalSection(&statsLock);
+    iops = 0;
+    mbps = 0;
+    outstandingAvg = 0;
+    LeaveCriticalSection(&statsLock);
+}
+
+bool IOWorker::OpenDiskCounter() {
+    if (diskQuery) return true;
+
+    hPdhModule = LoadLibraryA("pdh.dll");
+    if (!hPdhModule) return false;
+
+    PPdhOpenQueryA pPdhOpenQuery = (PPdhOpenQueryA)GetProcAddress(hPdhModule, "PdhOpenQueryA");
+    PPdhAddCounterA pPdhAddCounter = (PPdhAddCounterA)GetProcAddress(hPdhModule, "PdhAddCounterA");
+    pPdhCollectQuery = (PPdhCollectQueryData)GetProcAddress(hPdhModule, "PdhCollectQueryData");
+    pPdhGetFormattedValue = (PPdhGetFormattedCounterValue)GetProcAddress(hPdhModule, "PdhGetFormattedCounterValue");
+    pPdhCloseQuery = (PPdhCloseQuery)GetProcAddress(hPdhModule, "PdhCloseQuery");
+    if (!pPdhOpenQuery || !pPdhAddCounter || !pPdhCollectQuery ||
+        !pPdhGetFormattedValue || !pPdhCloseQuery) {
+        CloseDiskCounter();
+        return false;
+    }
+
+    if (pPdhOpenQuery(NULL, 0, &diskQuery) != ERROR_SUCCESS) {
+        diskQuery = NULL;
+        CloseDiskCounter();
+        return false;
+    }
+
+    // 优先使用临时文件所在分区的计数器，失败时退回所有物理磁盘的平均值
+    char counterPath[64];
+    bool added = false;
+    if (scratchPath.size() >= 2 && scratchPath[1] == ':') {
+        snprintf(counterPath, sizeof(counterPath), "\\LogicalDisk(%c:)\\%% Idle Time", scratchPath[0]);
+        added = pPdhAddCounter(diskQuery, counterPath, 0, &diskCounter) == ERROR_SUCCESS;
+    }
+    if (!added) {
+        added = pPdhAddCounter(diskQuery, "\\PhysicalDisk(_Total)\\% Idle Time", 0, &diskCounter) == ERROR_SUCCESS;
+    }
+    if (!added) {
+        diskCounter = NULL;
+        CloseDiskCounter();
+        return false;
+    }
+
+    pPdhCollectQuery(diskQuery);
+    lastDiskSampleTick = GetTickCount();
+    return true;
+}
+
+void IOWorker::CloseDiskCounter() {
+    if (diskQuery && pPdhCloseQuery) {
+        pPdhCloseQuery(diskQuery);
+    }
+    diskQuery = NULL;
+    diskCounter = NULL;
+    if (hPdhModule) {
+        FreeLibrary(hPdhModule);
+        hPdhModule = NULL;
+    }
+}
+
+void IOWorker::Update() {
+    if (!running) return;
+
+    DWORD now = GetTickCount();
+    if (now - lastDiskSampleTick < 1000) return;
+    lastDiskSampleTick = now;
+
+    double busy = -1;
+    if (diskQuery && diskCounter && pPdhCollectQuery(diskQuery) == ERROR_SUCCESS) {
+        PDH_FMT_COUNTERVALUE value;
+        if (pPdhGetFormattedValue(diskCounter, PDH_FMT_DOUBLE, NULL, &value) == ERROR_SUCCESS) {
+            busy = 100.0 - value.doubleValue;
+            if (busy < 0) busy = 0;
+            if (busy > 100) busy = 100;
+        }
+    }
+
+    EnterCriticalSection(&statsLock);
+    // 自身在途请求数不少于 1 的时间比例不超过平均在途数，以此作为自身忙碌度的上界，
+    // 剩下的才算其他进程造成的忙碌
+    double selfBusy = outstandingAvg * 100.0;
+    if (selfBusy > 100) selfBusy = 100;
+    bool contended = false;
+    if (busy >= 0) {
+        diskBusyPercent = busy;
+        otherBusyPercent = busy > selfBusy ? busy - selfBusy : 0;
+        contended = otherBusyPercent >= backoffBusyPercent;
+    }
+    // 自身占满磁盘时忙碌度看不出争用，改用延迟：明显高于基线说明有人在排队
+    if (baselineLatencyMs > 0 && avgLatencyMs > baselineLatencyMs * 3.0) {
+        contended = true;
+    }
+    LeaveCriticalSection(&statsLock);
+
+    // AIMD：争用时乘性退让，空闲时线性恢复
+    LONG permille = ratePermille;
+    if (contended) {
+        permille = permille * 7 / 10;
+        if (permille < 50) permille = 50;
+    } else if (permille < 1000) {
+        permille += 100;
+        if (permille > 1000) permille = 1000;
+    }
+    InterlockedExchange(&ratePermille, permille);
+}
+
+LONGLONG IOWorker::GetThreadCpuTime() const {
+    return OverheadMeter::GetThreadCpuTime(workerThread);
+}
+
+IOWorkerStats IOWorker::GetStats() const {
+    IOWorkerStats stats;
+
+    EnterCriticalSection((LPCRITICAL_SECTION)&statsLock);
+    stats.iops = iops;
+    stats.mbps = mbps;
+    stats.avgLatencyMs = avgLatencyMs;
+    stats.baselineLatencyMs = baselineLatencyMs;
+    stats.diskBusyPercent = diskBusyPercent;
+    stats.otherBusyPercent = otherBusyPercent;
+    stats.errors = errors;
+    LeaveCriticalSection((LPCRITICAL_SECTION)&statsLock);
+
+    stats.rateScale = ratePermille / 1000.0;
+    stats.queueDepth = queueDepth;
+    stats.diskCounterAvailable = diskCounter != NULL;
+    return stats;
+}
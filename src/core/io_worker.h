@@ -0,0 +1,89 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "resource_monitor.h"
+
+struct IOWorkerStats {
+    double iops;
+    double mbps;
+    double avgLatencyMs;
+    double baselineLatencyMs;
+    double diskBusyPercent;
+    double otherBusyPercent;
+    double rateScale;
+    int queueDepth;
+    int64_t errors;
+    bool diskCounterAvailable;
+
+    IOWorkerStats()
+        : iops(0), mbps(0), avgLatencyMs(0), baselineLatencyMs(0), diskBusyPercent(0),
+          otherBusyPercent(0), rateScale(1.0), queueDepth(0), errors(0),
+          diskCounterAvailable(false) {}
+};
+
+// 磁盘 I/O 负载 - 在预分配的临时文件上以无缓冲重叠 I/O 维持固定队列深度的随机读写，
+// 按 IOPS / MB/s 令牌桶限速；其他进程占用磁盘时（忙碌度或延迟上升）按 AIMD 退让
+class IOWorker {
+private:
+    volatile LONG running;
+    HANDLE volatile workerThread;  // Stop 和 Start 用原子交换取走，只有一个调用者等待并关闭
+    HANDLE stopEvent;
+    CRITICAL_SECTION statsLock;
+
+    std::string scratchPath;
+    int fileMB;
+    int blockKB;
+    int queueDepth;
+    int readPercent;
+    int targetIops;
+    int targetMBps;
+    int backoffBusyPercent;
+
+    volatile LONG ratePermille;  // 退让系数 ×1000，主线程调整、工作线程读取
+    uint32_t rngState;
+
+    // 工作线程每秒发布的统计
+    double iops;
+    double mbps;
+    double avgLatencyMs;
+    double baselineLatencyMs;
+    double outstandingAvg;
+    int64_t errors;
+
+    // 磁盘忙碌度（PDH，动态加载）
+    HMODULE hPdhModule;
+    PDH_HQUERY diskQuery;
+    PDH_HCOUNTER diskCounter;
+    PPdhCollectQueryData pPdhCollectQuery;
+    PPdhGetFormattedCounterValue pPdhGetFormattedValue;
+    PPdhCloseQuery pPdhCloseQuery;
+    DWORD lastDiskSampleTick;
+    double diskBusyPercent;
+    double otherBusyPercent;
+
+public:
+    IOWorker();
+    ~IOWorker();
+
+    void Configure(const std::string& path, int fileSizeMB, int blockSizeKB, int depth,
+                   int readPct, int iopsTarget, int mbpsTarget, int backoffBusyPct);
+    void Start();
+    void Stop();
+    bool IsRunning() const { return running != 0; }
+
+    void Update();
+    IOWorkerStats GetStats() const;
+    // 工作线程的累计 CPU 时间（100ns），CPU 控制器据此把这部分计为自身占用
+    LONGLONG GetThreadCpuTime() const;
+
+private:
+    static DWORD WINAPI WorkerThreadProc(LPVOID lpParam);
+    void WorkerLoop();
+    void JoinWorkerThread();
+    bool PrepareScratchFile(HANDLE file, char* buffer, size_t bufferBytes, uint64_t fileBytes);
+    uint32_t NextRandom();
+    bool OpenDiskCounter();
+    void CloseDiskCounter();
+};
@@ -0,0 +1,487 @@
+#include "load_bench.h"
+#include "resource_monitor.h"
+#include "../platform/system_compat.h"
+#include "../utils/version.h"
+#include <windows.h>
+#include <psapi.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+// 单次采样，均为百分比
+struct BenchSample {
+    double t;           // 相对竞争负载启动的秒数
+    double script;      // 脚本给出的竞争负载目标
+    double cpuTotal;
+    double cpuWorker;   // MikaBooM 子进程
+    double cpuFake;     // 竞争负载子进程
+    double memTotal;
+    double memWorker;
+};
+
+struct Distribution {
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    size_t count;
+
+    Distribution() : mean(0), p50(0), p90(0), p99(0), max(0), count(0) {}
+};
+
+struct ResponseStats {
+    Distribution seconds;
+    int timeouts;
+
+    ResponseStats() : timeouts(0) {}
+};
+
+double Percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+    if (rank > 0) rank--;
+    if (rank >= sorted.size()) rank = sorted.size() - 1;
+    return sorted[rank];
+}
+
+Distribution Summarize(std::vector<double> values) {
+    Distribution result;
+    if (values.empty()) return result;
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (size_t i = 0; i < values.size(); ++i) sum += values[i];
+    result.count = values.size();
+    result.mean = sum / values.size();
+    result.p50 = Percentile(values, 50);
+    result.p90 = Percentile(values, 90);
+    result.p99 = Percentile(values, 99);
+    result.max = values.back();
+    return result;
+}
+
+double FileTimeToSeconds(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return value.QuadPart / 10000000.0;
+}
+
+// 进程累计 CPU 时间（秒）
+double ProcessCpuSeconds(HANDLE process) {
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetProcessTimes(process, &creation, &exitTime, &kernel, &user)) return 0;
+    return FileTimeToSeconds(kernel) + FileTimeToSeconds(user);
+}
+
+double ProcessWorkingSetBytes(HANDLE process) {
+    PROCESS_MEMORY_COUNTERS counters;
+    ZeroMemory(&counters, sizeof(counters));
+    counters.cb = sizeof(counters);
+    if (!GetProcessMemoryInfo(process, &counters, sizeof(counters))) return 0;
+    return (double)counters.WorkingSetSize;
+}
+
+bool LaunchChild(const std::string& commandLine, PROCESS_INFORMATION& process) {
+    STARTUPINFOA startup;
+    ZeroMemory(&startup, sizeof(startup));
+    startup.cb = sizeof(startup);
+    ZeroMemory(&process, sizeof(process));
+
+    std::vector<char> buffer(commandLine.begin(), commandLine.end());
+    buffer.push_back('\0');
+    if (!CreateProcessA(NULL, &buffer[0], NULL, NULL, FALSE, CREATE_NO_WINDOW,
+                        NULL, NULL, &startup, &process)) {
+        return false;
+    }
+    CloseHandle(process.hThread);
+    process.hThread = NULL;
+    return true;
+}
+
+void StopChild(PROCESS_INFORMATION& process) {
+    if (!process.hProcess) return;
+    if (WaitForSingleObject(process.hProcess, 0) == WAIT_TIMEOUT) {
+        TerminateProcess(process.hProcess, 0);
+        WaitForSingleObject(process.hProcess, 5000);
+    }
+    CloseHandle(process.hProcess);
+    process.hProcess = NULL;
+}
+
+// 实际占用相对理想值的偏差：其他程序低于阈值时理想总量为阈值，否则为其他程序占用（自身完全让出）
+double TrackingError(double total, double worker, int threshold) {
+    double other = total - worker;
+    double ideal = other < threshold ? threshold : other;
+    return total - ideal;
+}
+
+// 从 start 开始找到连续 3 次满足条件的时刻，超过 limit 秒或到达 end 视为超时
+template <typename Predicate>
+bool MeasureResponse(const std::vector<BenchSample>& samples, size_t start, size_t end,
+                     double limit, Predicate settled, double& seconds) {
+    int run = 0;
+    for (size_t i = start; i < end; ++i) {
+        if (samples[i].t - samples[start].t > limit) return false;
+        run = settled(samples[i]) ? run + 1 : 0;
+        if (run >= 3) {
+            seconds = samples[i - 2].t - samples[start].t;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct YieldSettled {
+    int threshold;
+    bool operator()(const BenchSample& s) const {
+        return TrackingError(s.cpuTotal, s.cpuWorker, threshold) <= 3.0;
+    }
+};
+
+struct FillSettled {
+    int threshold;
+    bool operator()(const BenchSample& s) const {
+        return TrackingError(s.cpuTotal, s.cpuWorker, threshold) >= -3.0;
+    }
+};
+
+void WriteDistribution(FILE* file, const char* name, const Distribution& d, bool last) {
+    fprintf(file, "      \"%s\": {\"count\": %u, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}%s\n",
+            name, (unsigned)d.count, d.mean, d.p50, d.p90, d.p99, d.max, last ? "" : ",");
+}
+
+void WriteResponse(FILE* file, const char* name, const ResponseStats& r, bool last) {
+    fprintf(file, "      \"%s\": {\"count\": %u, \"timeouts\": %d, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"max\": %.3f}%s\n",
+            name, (unsigned)r.seconds.count, r.timeouts, r.seconds.mean, r.seconds.p50,
+            r.seconds.p90, r.seconds.max, last ? "" : ",");
+}
+
+// 竞争负载子进程的共享状态
+volatile LONG g_fakeTargetPermille = 0;
+volatile LONG g_fakeStop = 0;
+
+// 以 100ms 为周期忙等 target 的比例，按绝对时间推进避免 Sleep 粒度累积误差
+DWORD WINAPI FakeLoadThreadProc(LPVOID) {
+    LARGE_INTEGER frequency, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    LONGLONG period = frequency.QuadPart / 10;
+    LONGLONG cycleStart = now.QuadPart;
+    volatile unsigned int sink = 0;
+
+    while (!g_fakeStop) {
+        LONGLONG busyUntil = cycleStart + period * g_fakeTargetPermille / 1000;
+        do {
+            for (int i = 0; i < 1000; ++i) sink = sink * 1103515245 + 12345;
+            QueryPerformanceCounter(&now);
+        } while (now.QuadPart < busyUntil);
+
+        cycleStart += period;
+        if (cycleStart > now.QuadPart) {
+            Sleep((DWORD)((cycleStart - now.QuadPart) * 1000 / frequency.QuadPart));
+        } else {
+            cycleStart = now.QuadPart;
+        }
+    }
+    return 0;
+}
+
+double ProfileSteps(double t) {
+    static const double levels[] = { 10, 50, 20, 90, 5, 70 };
+    return levels[((int)(t / 60.0)) % 6];
+}
+
+double ProfileRamp(double t, double duration) {
+    double x = duration > 0 ? t / duration : 0;
+    if (x > 1) x = 1;
+    return 5 + 90 * (1.0 - fabs(2.0 * x - 1.0));
+}
+
+double ProfileBursts(double t) {
+    double phase = fmod(t, 60.0);
+    return (phase >= 30 && phase < 45) ? 90 : 15;
+}
+
+double ProfileSine(double t) {
+    return 45 + 35 * sin(6.283185307179586 * t / 120.0);
+}
+
+} // namespace
+
+double FakeLoadProfileValue(const std::string& profile, double t, double duration) {
+    if (profile == "steps") return ProfileSteps(t);
+    if (profile == "ramp") return ProfileRamp(t, duration);
+    if (profile == "bursts") return ProfileBursts(t);
+    if (profile == "sine") return ProfileSine(t);
+    if (profile == "mixed") {
+        // 四段依次为阶跃、斜坡、突发、正弦
+        double quarter = duration / 4.0;
+        int segment = quarter > 0 ? (int)(t / quarter) : 0;
+        double local = t - segment * quarter;
+        switch (segment) {
+            case 0: return ProfileSteps(local);
+            case 1: return ProfileRamp(local, quarter);
+            case 2: return ProfileBursts(local);
+            default: return ProfileSine(local);
+        }
+    }
+    return -1;
+}
+
+int RunFakeLoad(const std::string& profile, int seconds) {
+    if (FakeLoadProfileValue(profile, 0, seconds) < 0 || seconds <= 0) {
+        printf("Unknown fake load profile: %s\n", profile.c_str());
+        return 1;
+    }
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int threads = info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+
+    MemoryStatusSnapshot memory;
+    SystemCompat::QueryMemoryStatus(memory);
+
+    std::vector<HANDLE> workers;
+    for (int i = 0; i < threads; ++i) {
+        HANDLE thread = CreateThread(NULL, 0, FakeLoadThreadProc, NULL, 0, NULL);
+        if (thread) workers.push_back(thread);
+    }
+
+    // 内存按 64MB 块申请并逐页写入，保证计入工作集
+    const SIZE_T chunkBytes = 64 * 1024 * 1024;
+    std::vector<void*> chunks;
+    DWORD startTick = GetTickCount();
+
+    for (;;) {
+        double t = (GetTickCount() - startTick) / 1000.0;
+        if (t >= seconds) break;
+
+        double value = FakeLoadProfileValue(profile, t, seconds);
+        InterlockedExchange(&g_fakeTargetPermille, (LONG)(value * 10));
+
+        double memoryTarget = memory.totalPhys * (value / 4.0) / 100.0;
+        while ((chunks.size() + 1) * (double)chunkBytes <= memoryTarget) {
+            void* chunk = VirtualAlloc(NULL, chunkBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (!chunk) break;
+            for (SIZE_T offset = 0; offset < chunkBytes; offset += 4096) {
+                ((volatile char*)chunk)[offset] = 1;
+            }
+            chunks.push_back(chunk);
+        }
+        while (!chunks.empty() && chunks.size() * (double)chunkBytes > memoryTarget + chunkBytes) {
+            VirtualFree(chunks.back(), 0, MEM_RELEASE);
+            chunks.pop_back();
+        }
+
+        Sleep(100);
+    }
+
+    InterlockedExchange(&g_fakeStop, 1);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        WaitForSingleObject(workers[i], INFINITE);
+        CloseHandle(workers[i]);
+    }
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        VirtualFree(chunks[i], 0, MEM_RELEASE);
+    }
+    return 0;
+}
+
+int RunLoadBenchmark(const LoadBenchOptions& options) {
+    if (FakeLoadProfileValue(options.profile, 0, options.seconds) < 0 || options.seconds <= 0) {
+        printf("Unknown fake load profile: %s\n", options.profile.c_str());
+        return 1;
+    }
+
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(NULL, exePath, MAX_PATH);
+
+    char command[MAX_PATH * 2];
+    PROCESS_INFORMATION worker;
+    // 子进程只保留控制器本身：关闭控制管道、遥测、多实例协同、指标导出和分位数状态文件，
+    // 以无人值守模式运行（不写自启动、不检查更新）。否则在运行中的实例旁边测试时
+    // 会抢不到这些按主机唯一的资源，或加入协同只分到部分份额，测得的是协同而不是控制器
+    sprintf_s(command, sizeof(command),
+              "\"%s\" -headless -window false -control false -telemetry false -coordination false "
+              "-metrics 0 -quantile 0 -cpu %d -mem %d",
+              exePath, options.cpuThreshold, options.memoryThreshold);
+    if (!LaunchChild(command, worker)) {
+        printf("Failed to start MikaBooM (error %lu)\n", GetLastError());
+        return 1;
+    }
+
+    printf("Load benchmark: profile=%s duration=%ds warmup=%ds sample=%dHz cpu=%d%% mem=%d%%\n",
+           options.profile.c_str(), options.seconds, options.warmupSeconds, options.sampleHz,
+           options.cpuThreshold, options.memoryThreshold);
+    Sleep(options.warmupSeconds * 1000);
+
+    PROCESS_INFORMATION fake;
+    sprintf_s(command, sizeof(command), "\"%s\" -fake-load %s %d",
+              exePath, options.profile.c_str(), options.seconds);
+    if (!LaunchChild(command, fake)) {
+        printf("Failed to start fake load (error %lu)\n", GetLastError());
+        StopChild(worker);
+        return 1;
+    }
+
+    ResourceMonitor monitor;
+    MemoryStatusSnapshot memory;
+    SystemCompat::QueryMemoryStatus(memory);
+    double totalPhys = memory.totalPhys > 0 ? (double)memory.totalPhys : 1.0;
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    double processors = info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+
+    LARGE_INTEGER frequency, start, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    monitor.GetCPUUsageRaw();
+    double lastT = 0;
+    double lastWorkerCpu = ProcessCpuSeconds(worker.hProcess);
+    double lastFakeCpu = ProcessCpuSeconds(fake.hProcess);
+    double peakWorkingSet = 0;
+    DWORD interval = options.sampleHz > 0 ? 1000 / options.sampleHz : 100;
+
+    std::vector<BenchSample> samples;
+    while (WaitForSingleObject(fake.hProcess, interval) == WAIT_TIMEOUT) {
+        QueryPerformanceCounter(&now);
+        double t = (double)(now.QuadPart - start.QuadPart) / frequency.QuadPart;
+        double dt = t - lastT;
+        if (dt <= 0) continue;
+        if (t > options.seconds + 30) break;
+
+        double workerCpu = ProcessCpuSeconds(worker.hProcess);
+        double fakeCpu = ProcessCpuSeconds(fake.hProcess);
+        double workingSet = ProcessWorkingSetBytes(worker.hProcess);
+        if (workingSet > peakWorkingSet) peakWorkingSet = workingSet;
+
+        BenchSample sample;
+        sample.t = t;
+        sample.script = FakeLoadProfileValue(options.profile, t, options.seconds);
+        sample.cpuTotal = monitor.GetCPUUsageRaw();
+        sample.cpuWorker = (workerCpu - lastWorkerCpu) / (dt * processors) * 100.0;
+        sample.cpuFake = (fakeCpu - lastFakeCpu) / (dt * processors) * 100.0;
+        sample.memTotal = monitor.GetMemoryUsageRaw();
+        sample.memWorker = workingSet / totalPhys * 100.0;
+        if (sample.cpuWorker > sample.cpuTotal) sample.cpuWorker = sample.cpuTotal;
+        if (sample.memTotal >= 0) samples.push_back(sample);
+
+        lastT = t;
+        lastWorkerCpu = workerCpu;
+        lastFakeCpu = fakeCpu;
+    }
+
+    StopChild(fake);
+    StopChild(worker);
+
+    if (samples.size() < 10) {
+        printf("Too few samples collected (%u)\n", (unsigned)samples.size());
+        return 1;
+    }
+
+    std::vector<double> cpuErrors, memErrors, idleOverhead, workerCpu, fakeCpu;
+    ResponseStats yield, fill;
+    YieldSettled yieldSettled = { options.cpuThreshold };
+    FillSettled fillSettled = { options.cpuThreshold };
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const BenchSample& s = samples[i];
+        cpuErrors.push_back(fabs(TrackingError(s.cpuTotal, s.cpuWorker, options.cpuThreshold)));
+        memErrors.push_back(fabs(TrackingError(s.memTotal, s.memWorker, options.memoryThreshold)));
+        workerCpu.push_back(s.cpuWorker);
+        fakeCpu.push_back(s.cpuFake);
+
+        // 其他程序明显高于阈值时工作负载应已停止，此时自身占用即为调度开销
+        if (s.cpuTotal - s.cpuWorker >= options.cpuThreshold + 10) {
+            idleOverhead.push_back(s.cpuWorker);
+        }
+    }
+
+    // 脚本跳变 20% 以上视为事件：上跳越过阈值测让出时间，下跳落到阈值以下测补位时间
+    std::vector<double> yieldSeconds, fillSeconds;
+    for (size_t i = 1; i < samples.size(); ++i) {
+        double previous = samples[i - 1].script;
+        double current = samples[i].script;
+        bool rise = current - previous >= 20 && current >= options.cpuThreshold - 5;
+        bool drop = previous - current >= 20 && current < options.cpuThreshold;
+        if (!rise && !drop) continue;
+
+        // 响应只统计到下一次跳变之前
+        size_t end = i + 1;
+        while (end < samples.size() && fabs(samples[end].script - samples[end - 1].script) < 20) end++;
+
+        double seconds = 0;
+        if (rise) {
+            if (MeasureResponse(samples, i, end, 60.0, yieldSettled, seconds)) yieldSeconds.push_back(seconds);
+            else yield.timeouts++;
+        } else {
+            if (MeasureResponse(samples, i, end, 60.0, fillSettled, seconds)) fillSeconds.push_back(seconds);
+            else fill.timeouts++;
+        }
+    }
+    yield.seconds = Summarize(yieldSeconds);
+    fill.seconds = Summarize(fillSeconds);
+
+    Distribution cpuError = Summarize(cpuErrors);
+    Distribution memError = Summarize(memErrors);
+    Distribution overhead = Summarize(idleOverhead);
+    Distribution workerUsage = Summarize(workerCpu);
+    Distribution fakeUsage = Summarize(fakeCpu);
+
+    FILE* file = NULL;
+    if (fopen_s(&file, options.outputPath.c_str(), "w") != 0 || !file) {
+        printf("Failed to write report: %s\n", options.outputPath.c_str());
+        return 1;
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"version\": \"%s\",\n", Version::GetVersion());
+    fprintf(file, "  \"profile\": \"%s\",\n", options.profile.c_str());
+    fprintf(file, "  \"duration_sec\": %d,\n", options.seconds);
+    fprintf(file, "  \"sample_hz\": %d,\n", options.sampleHz);
+    fprintf(file, "  \"samples\": %u,\n", (unsigned)samples.size());
+    fprintf(file, "  \"processors\": %d,\n", (int)processors);
+    fprintf(file, "  \"cpu\": {\n");
+    fprintf(file, "    \"threshold\": %d,\n", options.cpuThreshold);
+    fprintf(file, "    \"tracking_error\": {\n");
+    WriteDistribution(file, "abs_percent", cpuError, true);
+    fprintf(file, "    },\n");
+    fprintf(file, "    \"response\": {\n");
+    WriteResponse(file, "time_to_yield_sec", yield, false);
+    WriteResponse(file, "time_to_fill_sec", fill, true);
+    fprintf(file, "    },\n");
+    fprintf(file, "    \"usage\": {\n");
+    WriteDistribution(file, "worker_percent", workerUsage, false);
+    WriteDistribution(file, "fake_load_percent", fakeUsage, true);
+    fprintf(file, "    }\n");
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"memory\": {\n");
+    fprintf(file, "    \"threshold\": %d,\n", options.memoryThreshold);
+    fprintf(file, "    \"tracking_error\": {\n");
+    WriteDistribution(file, "abs_percent", memError, true);
+    fprintf(file, "    }\n");
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"overhead\": {\n");
+    fprintf(file, "    \"idle_cpu_percent\": %.3f,\n", overhead.mean);
+    fprintf(file, "    \"idle_cpu_p99_percent\": %.3f,\n", overhead.p99);
+    fprintf(file, "    \"idle_samples\": %u,\n", (unsigned)overhead.count);
+    fprintf(file, "    \"peak_working_set_mb\": %.1f\n", peakWorkingSet / (1024.0 * 1024.0));
+    fprintf(file, "  }\n");
+    fprintf(file, "}\n");
+    fclose(file);
+
+    printf("  samples=%u\n", (unsigned)samples.size());
+    printf("  cpu_error p50=%.2f p90=%.2f p99=%.2f\n", cpuError.p50, cpuError.p90, cpuError.p99);
+    printf("  mem_error p50=%.2f p90=%.2f p99=%.2f\n", memError.p50, memError.p90, memError.p99);
+    printf("  time_to_yield mean=%.2fs p90=%.2fs (%u events, %d timeouts)\n",
+           yield.seconds.mean, yield.seconds.p90, (unsigned)yield.seconds.count, yield.timeouts);
+    printf("  time_to_fill mean=%.2fs p90=%.2fs (%u events, %d timeouts)\n",
+           fill.seconds.mean, fill.seconds.p90, (unsigned)fill.seconds.count, fill.timeouts);
+    printf("  idle_overhead=%.2f%% cpu, peak_working_set=%.1fMB\n",
+           overhead.mean, peakWorkingSet / (1024.0 * 1024.0));
+    printf("  report: %s\n", options.outputPath.c_str());
+    return 0;
+}
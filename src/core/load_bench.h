@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+
+// 控制精度基准参数
+struct LoadBenchOptions {
+    std::string profile;      // 竞争负载脚本：steps / ramp / bursts / sine / mixed
+    int seconds;              // 竞争负载持续时间
+    int warmupSeconds;        // 启动 MikaBooM 后等待稳定的时间
+    int sampleHz;             // 采样频率
+    int cpuThreshold;
+    int memoryThreshold;
+    std::string outputPath;   // JSON 报告
+
+    LoadBenchOptions()
+        : profile("mixed"), seconds(300), warmupSeconds(15), sampleHz(10),
+          cpuThreshold(80), memoryThreshold(60), outputPath("MikaBooM.bench-load.json") {}
+};
+
+// 按脚本生成竞争负载（子进程模式）：每个逻辑处理器一个线程按占空比忙等，
+// 内存按同一曲线的 1/4 比例占用物理内存，持续 seconds 秒后退出
+int RunFakeLoad(const std::string& profile, int seconds);
+
+// 以子进程方式启动 MikaBooM 与竞争负载，高频记录总占用、自身占用和其他程序占用，
+// 输出跟踪误差分位数、突发后的让出时间、突发结束后的补位时间和自身开销（JSON）
+int RunLoadBenchmark(const LoadBenchOptions& options);
+
+// 竞争负载脚本在 t 秒（总时长 duration 秒）时的 CPU 目标占用，未知脚本返回 -1
+double FakeLoadProfileValue(const std::string& profile, double t, double duration);
@@ -0,0 +1,147 @@
+#include "load_estimator.h"
+#include "ema_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+struct ReplayPoint {
+    double total;
+    double worker;
+    double other;   // 真实的其他程序占用
+};
+
+struct ReplayScore {
+    double rmse;
+    double avgLagTicks;     // 阶跃后到达 90% 幅度所需的平均采样次数
+    double maxOvershoot;    // 最大超调，占阶跃幅度的百分比
+};
+
+// 内置轨迹：其他程序负载两次阶跃、一次斜坡，自身负载在中途切换，叠加高斯噪声
+void BuildSyntheticTrace(std::vector<ReplayPoint>& trace) {
+    uint32_t state = 12345;
+    for (int i = 0; i < 240; ++i) {
+        double other;
+        if (i < 40) other = 20;
+        else if (i < 120) other = 60;
+        else if (i < 160) other = 30;
+        else other = 30 + (i - 160) * 0.5;
+
+        double worker = i < 80 ? 30 : (i < 180 ? 10 : 25);
+
+        // Box-Muller，标准差 3%
+        state = state * 1664525 + 1013904223;
+        double u1 = ((state >> 8) + 1.0) / 16777217.0;
+        state = state * 1664525 + 1013904223;
+        double u2 = (state >> 8) / 16777216.0;
+        double noise = sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2) * 3.0;
+
+        ReplayPoint point;
+        point.other = other;
+        point.worker = worker;
+        point.total = other + worker + noise;
+        if (point.total < 0) point.total = 0;
+        if (point.total > 100) point.total = 100;
+        trace.push_back(point);
+    }
+}
+
+bool LoadTrace(const std::string& file, std::vector<ReplayPoint>& trace) {
+    std::ifstream input(file.c_str());
+    if (!input.is_open()) return false;
+
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        ReplayPoint point;
+        if (sscanf(line.c_str(), "%lf,%lf,%lf", &point.total, &point.worker, &point.other) == 3) {
+            trace.push_back(point);
+        }
+    }
+    return !trace.empty();
+}
+
+ReplayScore Score(const std::vector<ReplayPoint>& trace, const std::vector<double>& estimate) {
+    ReplayScore score;
+    double sumSq = 0;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        double error = estimate[i] - trace[i].other;
+        sumSq += error * error;
+    }
+    score.rmse = trace.empty() ? 0 : sqrt(sumSq / trace.size());
+
+    // 真实值跳变超过 10% 视为一次阶跃，统计之后 30 次采样内的响应
+    int steps = 0;
+    double lagSum = 0;
+    score.maxOvershoot = 0;
+    for (size_t i = 1; i < trace.size(); ++i) {
+        double before = trace[i - 1].other;
+        double after = trace[i].other;
+        double amplitude = after - before;
+        if (fabs(amplitude) < 10) continue;
+
+        size_t end = i + 30 < trace.size() ? i + 30 : trace.size();
+        size_t reached = end;
+        double overshoot = 0;
+        for (size_t j = i; j < end; ++j) {
+            double progress = (estimate[j] - before) / amplitude;
+            if (reached == end && progress >= 0.9) reached = j;
+            double beyond = (progress - 1.0) * 100.0;
+            if (beyond > overshoot) overshoot = beyond;
+        }
+        lagSum += (double)(reached - i);
+        if (overshoot > score.maxOvershoot) score.maxOvershoot = overshoot;
+        steps++;
+    }
+    score.avgLagTicks = steps > 0 ? lagSum / steps : 0;
+    return score;
+}
+
+} // namespace
+
+int RunEstimatorReplay(const std::string& file, double tickSec) {
+    std::vector<ReplayPoint> trace;
+    if (file.empty()) {
+        BuildSyntheticTrace(trace);
+    } else if (!LoadTrace(file, trace)) {
+        printf("Failed to load trace: %s\n", file.c_str());
+        return 1;
+    }
+    if (tickSec <= 0) tickSec = 2.0;
+
+    // 旧链路：总量先做 EMA（与 ResourceMonitor::SmoothValue 相同的 0.3），再减去自身占用
+    std::vector<double> legacy;
+    EMAFilter totalFilter(0.3);
+    for (size_t i = 0; i < trace.size(); ++i) {
+        double other = totalFilter.Update(trace[i].total) - trace[i].worker;
+        legacy.push_back(other < 0 ? 0 : other);
+    }
+
+    std::vector<double> kalman;
+    OtherLoadEstimator estimator;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        kalman.push_back(estimator.Update(trace[i].total, trace[i].worker, tickSec));
+    }
+
+    std::vector<double> raw;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        double other = trace[i].total - trace[i].worker;
+        raw.push_back(other < 0 ? 0 : other);
+    }
+
+    ReplayScore legacyScore = Score(trace, legacy);
+    ReplayScore kalmanScore = Score(trace, kalman);
+    ReplayScore rawScore = Score(trace, raw);
+
+    printf("Estimator replay: %u samples, tick %.1fs, %s\n",
+           (unsigned)trace.size(), tickSec, file.empty() ? "synthetic trace" : file.c_str());
+    printf("  %-12s %8s %10s %12s\n", "method", "RMSE", "lag(ticks)", "overshoot%");
+    printf("  %-12s %8.2f %10.2f %12.1f\n", "raw", rawScore.rmse, rawScore.avgLagTicks, rawScore.maxOvershoot);
+    printf("  %-12s %8.2f %10.2f %12.1f\n", "ema-chain", legacyScore.rmse, legacyScore.avgLagTicks, legacyScore.maxOvershoot);
+    printf("  %-12s %8.2f %10.2f %12.1f\n", "kalman", kalmanScore.rmse, kalmanScore.avgLagTicks, kalmanScore.maxOvershoot);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+
+// 其他程序负载的卡尔曼估计器（常速度模型）。
+// 观测模型：total = other + worker + 噪声，worker 为已知输入，
+// 状态为 [other, 变化率]，直接估计其他程序占用及其变化趋势，避免“先平滑总量再相减”的滞后
+class OtherLoadEstimator {
+private:
+    double other;       // 估计的其他程序占用
+    double rate;        // 估计的变化率（每秒）
+    double p00, p01, p11;  // 协方差矩阵（对称）
+    double processNoise;   // 加速度白噪声强度 q
+    double measureNoise;   // 观测方差 r
+    double minValue;
+    double maxValue;
+    bool initialized;
+
+public:
+    OtherLoadEstimator(double q = 0.25, double r = 16.0)
+        : other(0), rate(0), p00(0), p01(0), p11(0),
+          processNoise(q), measureNoise(r), minValue(0), maxValue(100), initialized(false) {}
+
+    void SetNoise(double q, double r) {
+        processNoise = q;
+        measureNoise = r;
+    }
+
+    void SetLimits(double low, double high) {
+        minValue = low;
+        maxValue = high;
+    }
+
+    // total 为测得的总占用，worker 为同一窗口内自身占用，dt 为距上次更新的秒数
+    double Update(double total, double worker, double dt) {
+        double z = total - worker;
+
+        if (!initialized) {
+            other = Clamp(z);
+            rate = 0;
+            p00 = measureNoise;
+            p01 = 0;
+            p11 = measureNoise;
+            initialized = true;
+            return other;
+        }
+
+        if (dt <= 0) dt = 1e-3;
+        if (dt > 60) dt = 60;
+
+        // 预测：x = F x，P = F P F' + Q
+        double predicted = other + rate * dt;
+        double dt2 = dt * dt;
+        double n00 = p00 + 2 * dt * p01 + dt2 * p11 + processNoise * dt2 * dt / 3.0;
+        double n01 = p01 + dt * p11 + processNoise * dt2 / 2.0;
+        double n11 = p11 + processNoise * dt;
+
+        // 更新：观测矩阵 H = [1, 0]
+        double innovation = z - predicted;
+        double s = n00 + measureNoise;
+
+        // 新息超过 4 倍标准差视为负载突变，直接跳到观测值，避免变化率积累造成的超调
+        if (innovation * innovation > 16.0 * s) {
+            other = Clamp(z);
+            rate = 0;
+            p00 = measureNoise;
+            p01 = 0;
+            p11 = measureNoise;
+            return other;
+        }
+
+        double k0 = n00 / s;
+        double k1 = n01 / s;
+
+        other = predicted + k0 * innovation;
+        rate = rate + k1 * innovation;
+        p00 = (1 - k0) * n00;
+        p01 = (1 - k0) * n01;
+        p11 = n11 - k1 * n01;
+
+        // 越界时把状态拉回可行域，避免变化率把估计推到 0 以下或 100 以上
+        double clamped = Clamp(other);
+        if (clamped != other) {
+            other = clamped;
+            rate = 0;
+        }
+        return other;
+    }
+
+    double GetOther() const { return other; }
+    double GetRate() const { return rate; }
+    bool IsInitialized() const { return initialized; }
+
+    void Reset() {
+        other = 0;
+        rate = 0;
+        p00 = p01 = p11 = 0;
+        initialized = false;
+    }
+
+private:
+    double Clamp(double value) const {
+        if (value < minValue) return minValue;
+        if (value > maxValue) return maxValue;
+        return value;
+    }
+};
+
+// 回放对比：用记录的轨迹（或内置的阶跃轨迹）比较旧的 EMA 链与卡尔曼估计的误差、滞后和超调。
+// file 为空时使用内置轨迹；CSV 每行为 total,worker,other_true（百分比），# 开头为注释
+int RunEstimatorReplay(const std::string& file, double tickSec);
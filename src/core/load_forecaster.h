@@ -0,0 +1,110 @@
+#pragma once
+#include <deque>
+#include <math.h>
+
+// Holt 线性趋势预测（带阻尼），用于提前若干个采样周期预判其他程序负载的上升。
+// 同时记录 horizon 步之前做出的预测与实际值的误差，并与“保持当前值”的朴素预测对比，
+// 用 skill = 1 - MAE/朴素MAE 判断预测是否值得（> 0 表示优于朴素预测）
+class HoltForecaster {
+private:
+    double alpha;   // 水平平滑系数
+    double beta;    // 趋势平滑系数
+    double phi;     // 趋势阻尼，避免长步长外推过冲
+    int horizon;
+
+    double level;
+    double trend;
+    bool initialized;
+
+    std::deque<double> pendingForecasts;   // 尚未到期的预测
+    std::deque<double> pastValues;         // 朴素预测使用的历史值
+
+    double mae;
+    double mse;
+    double naiveMae;
+    int errorCount;
+
+public:
+    HoltForecaster(int steps = 3, double a = 0.5, double b = 0.3, double damping = 0.9)
+        : alpha(a), beta(b), phi(damping), horizon(steps < 0 ? 0 : steps),
+          level(0), trend(0), initialized(false),
+          mae(0), mse(0), naiveMae(0), errorCount(0) {}
+
+    void Configure(int steps, double a, double b) {
+        horizon = steps < 0 ? 0 : steps;
+        alpha = a;
+        beta = b;
+        Reset();
+    }
+
+    // 输入本周期的实际值，返回 horizon 步之后的预测
+    double Update(double value) {
+        if (horizon <= 0) return value;
+
+        // 先结算 horizon 步之前的预测
+        if ((int)pendingForecasts.size() >= horizon) {
+            double error = value - pendingForecasts.front();
+            double naiveError = value - pastValues.front();
+            pendingForecasts.pop_front();
+            pastValues.pop_front();
+            RecordError(error, naiveError);
+        }
+
+        if (!initialized) {
+            level = value;
+            trend = 0;
+            initialized = true;
+        } else {
+            double previousLevel = level;
+            level = alpha * value + (1 - alpha) * (previousLevel + phi * trend);
+            trend = beta * (level - previousLevel) + (1 - beta) * phi * trend;
+        }
+
+        double forecast = Forecast(horizon);
+        pendingForecasts.push_back(forecast);
+        pastValues.push_back(value);
+        return forecast;
+    }
+
+    double Forecast(int steps) const {
+        double damped = 0;
+        double factor = phi;
+        for (int i = 0; i < steps; ++i) {
+            damped += factor;
+            factor *= phi;
+        }
+        return level + damped * trend;
+    }
+
+    int GetHorizon() const { return horizon; }
+    double GetTrend() const { return trend; }
+    double GetMAE() const { return mae; }
+    double GetRMSE() const { return sqrt(mse); }
+    double GetNaiveMAE() const { return naiveMae; }
+    int GetErrorCount() const { return errorCount; }
+
+    double GetSkill() const {
+        if (errorCount == 0 || naiveMae <= 1e-9) return 0;
+        return 1.0 - mae / naiveMae;
+    }
+
+    void Reset() {
+        level = 0;
+        trend = 0;
+        initialized = false;
+        pendingForecasts.clear();
+        pastValues.clear();
+        mae = mse = naiveMae = 0;
+        errorCount = 0;
+    }
+
+private:
+    // 前 20 个误差用算术平均，之后按 5% 遗忘，跟随负载模式变化
+    void RecordError(double error, double naiveError) {
+        errorCount++;
+        double weight = errorCount < 20 ? 1.0 / errorCount : 0.05;
+        mae += weight * (fabs(error) - mae);
+        mse += weight * (error * error - mse);
+        naiveMae += weight * (fabs(naiveError) - naiveMae);
+    }
+};
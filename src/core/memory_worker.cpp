@@ -2,9 +2,16 @@
 #include "../utils/system_info.h"
 #include "../utils/anti_detect.h"
 #include "../platform/system_compat.h"
+#include "../platform/cpu_features.h"
+#include "trace_recorder.h"
+#include "overhead_meter.h"
 #include <algorithm>
 #include <stdlib.h>
 
+// 没有低内存通知时按内存占用轮询：超过内存阈值加余量即视为低内存，上限留给系统自身
+#define PRESSURE_POLL_MARGIN 10
+#define PRESSURE_POLL_MAX_LOAD 98
+
 MemoryWorker::MemoryWorker(int thresh, uint64_t totalMemory)
     : running(0), targetSizeMB(0),
       totalMemoryBytes(totalMemory), workerThread(NULL), lastAdjustTime(0),
@@ -13,14 +20,45 @@ MemoryWorker::MemoryWorker(int thresh, uint64_t totalMemory)
       randomMaxMB(thresh > 0 ? thresh * 256 / 100 : 512),
       randomIntervalMinSec(30), randomIntervalMaxSec(90),
       refreshEnabled(true), refreshAfterSec(60), refreshIntervalSec(30), refreshStrideKB(4),
+      refreshBudgetMBps(64), refreshBudgetPagesPerSec(16384), refreshStreaming(true),
       nextRandomizeTick(0), lastRefreshTick(0), randomTargetBytes(0), refreshCursor(0),
-      residentBytesCache(0), residentApproximate(true) {
+      refreshOffset(0), refreshTokens(0), refreshBytesPerSec(0), refreshPagesPerSec(0),
+      refreshNsPerPage(0), residentBytesCache(0), residentLowCache(0), residentHighCache(0),
+      residentSamplesCache(0), residentApproximate(true),
+      residencySamplesPerTick(256), exactScanRequested(0), lastExactScanTick(0),
+      residencyCpuMs(0), residencyCpuRemainder(0),
+      sampleRngState(0),
+      pressureReleaseEnabled(true), emergencyReleaseMB(1024), emergencyHoldSec(30),
+      wakeEvent(NULL), pressureThread(NULL), pressureStopEvent(NULL), lowMemoryNotification(NULL),
+      emergencyPendingMB(0), underPressure(0), pressureSignalCounter(0), pressureThreshold(thresh), emergencyHoldUntil(0),
+      emergencyReleaseCount(0), lastEmergencyReleasedBytes(0), lastEmergencyLatencyMs(0),
+      reclaimableFiller(false), reclaimedBytesCache(0), reclaimDetectedBytes(0), repopulatedBytes(0),
+      numaMode(MEMORY_NUMA_OFF), numaNodeCount(1), numaNextIndex(0) {
     InitializeCriticalSection(&allocLock);
+    wakeEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+    pressureStopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    // CreateMemoryResourceNotification 从 XP 开始提供，Windows 2000 上退化为轮询
+    typedef HANDLE (WINAPI *PCreateMemoryResourceNotification)(int);
+    HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
+    PCreateMemoryResourceNotification pCreateNotification = hKernel32
+        ? (PCreateMemoryResourceNotification)GetProcAddress(hKernel32, "CreateMemoryResourceNotification")
+        : NULL;
+    if (pCreateNotification) {
+        lowMemoryNotification = pCreateNotification(0);  // LowMemoryResourceNotification
+    }
+
+    sampleRngState = ((uint64_t)GetTickCount() << 32) ^ (uint64_t)(uintptr_t)this;
+    if (sampleRngState == 0) sampleRngState = 0x9E3779B97F4A7C15ULL;
     CalculateOptimalParameters();
+    ConfigureNuma("off", "");
 }
 
 MemoryWorker::~MemoryWorker() {
     Stop();
+    if (lowMemoryNotification) CloseHandle(lowMemoryNotification);
+    if (pressureStopEvent) CloseHandle(pressureStopEvent);
+    if (wakeEvent) CloseHandle(wakeEvent);
     DeleteCriticalSection(&allocLock);
 }
 
@@ -37,13 +75,18 @@ void MemoryWorker::CalculateOptimalParameters() {
         optimalChunkSize = 100LL * 1024 * 1024;
     }
 
-    maxAdjustPerCycle = (int64_t)(totalMemoryBytes * 0.02);
-    if (maxAdjustPerCycle < 256LL * 1024 * 1024) {
-        maxAdjustPerCycle = 256LL * 1024 * 1024;
+    maxAdjustPerCycle = ComputeMaxAdjustPerCycle(totalMemoryBytes);
+}
+
+int64_t MemoryWorker::ComputeMaxAdjustPerCycle(uint64_t totalBytes) {
+    int64_t maxAdjust = (int64_t)(totalBytes * 0.02);
+    if (maxAdjust < 256LL * 1024 * 1024) {
+        maxAdjust = 256LL * 1024 * 1024;
     }
-    if (maxAdjustPerCycle > 8LL * 1024 * 1024 * 1024) {
-        maxAdjustPerCycle = 8LL * 1024 * 1024 * 1024;
+    if (maxAdjust > 8LL * 1024 * 1024 * 1024) {
+        maxAdjust = 8LL * 1024 * 1024 * 1024;
     }
+    return maxAdjust;
 }
 
 void MemoryWorker::ConfigureRandomRange(int minMB, int maxMB, int intervalMinSec, int intervalMaxSec) {
@@ -65,6 +108,102 @@ void MemoryWorker::ConfigureRefresh(bool enabled, int afterSec, int intervalSec,
     refreshStrideKB = strideKB < 4 ? 4 : strideKB;
 }
 
+void MemoryWorker::ConfigureRefreshBudget(int mbPerSec, int pagesPerSec, bool streaming) {
+    refreshBudgetMBps = mbPerSec < 0 ? 0 : mbPerSec;
+    refreshBudgetPagesPerSec = pagesPerSec < 0 ? 0 : pagesPerSec;
+    refreshStreaming = streaming;
+}
+
+void MemoryWorker::ConfigureResidencySampling(int samplesPerTick) {
+    if (samplesPerTick < 0) samplesPerTick = 0;
+    if (samplesPerTick > 65536) samplesPerTick = 65536;
+    residencySamplesPerTick = samplesPerTick;
+}
+
+void MemoryWorker::ConfigureNuma(const std::string& mode, const std::string& nodes) {
+    numaNodeCount = SystemCompat::GetNumaNodeCount();
+    numaCandidates.clear();
+    numaNextIndex = 0;
+
+    if (mode == "interleave") {
+        numaMode = MEMORY_NUMA_INTERLEAVE;
+    } else if (mode == "proportional") {
+        numaMode = MEMORY_NUMA_PROPORTIONAL;
+    } else if (mode == "nodes") {
+        numaMode = MEMORY_NUMA_NODES;
+    } else {
+        numaMode = MEMORY_NUMA_OFF;
+    }
+
+    // nodes 模式使用逗号分隔的节点列表，其它模式使用全部节点
+    if (numaMode == MEMORY_NUMA_NODES) {
+        size_t start = 0;
+        while (start <= nodes.size()) {
+            size_t comma = nodes.find(',', start);
+            std::string item = nodes.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            if (!item.empty()) {
+                int node = atoi(item.c_str());
+                if (node >= 0 && node < numaNodeCount &&
+                    std::find(numaCandidates.begin(), numaCandidates.end(), node) == numaCandidates.end()) {
+                    numaCandidates.push_back(node);
+                }
+            }
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+    } else if (numaMode != MEMORY_NUMA_OFF) {
+        for (int node = 0; node < numaNodeCount; ++node) {
+            numaCandidates.push_back(node);
+        }
+    }
+
+    // 单节点机器或没有有效节点时没有放置可言
+    if (numaCandidates.empty() || (numaNodeCount <= 1 && numaMode != MEMORY_NUMA_NODES)) {
+        numaMode = MEMORY_NUMA_OFF;
+        numaCandidates.clear();
+    }
+
+    nodeSampleHits.assign(numaNodeCount, 0);
+    nodeResidency.assign(numaNodeCount, ResidencyEstimator());
+    nodeResidentCache.assign(numaNodeCount, 0);
+}
+
+int MemoryWorker::PickNumaNode() {
+    if (numaMode == MEMORY_NUMA_OFF || numaCandidates.empty()) {
+        return -1;
+    }
+
+    if (numaMode == MEMORY_NUMA_PROPORTIONAL) {
+        // 按空闲内存加权随机选择，空闲越多的节点承担越多填充
+        uint64_t totalFree = 0;
+        std::vector<uint64_t> freeBytes(numaCandidates.size(), 0);
+        for (size_t i = 0; i < numaCandidates.size(); ++i) {
+            if (SystemCompat::QueryNumaNodeFreeBytes(numaCandidates[i], freeBytes[i])) {
+                totalFree += freeBytes[i];
+            }
+        }
+        if (totalFree > 0) {
+            uint64_t pick = NextRandom() % totalFree;
+            for (size_t i = 0; i < numaCandidates.size(); ++i) {
+                if (pick < freeBytes[i]) {
+                    return numaCandidates[i];
+                }
+                pick -= freeBytes[i];
+            }
+        }
+    }
+
+    int node = numaCandidates[numaNextIndex % numaCandidates.size()];
+    numaNextIndex = (numaNextIndex + 1) % numaCandidates.size();
+    return node;
+}
+
+void MemoryWorker::ConfigurePressureRelease(bool enabled, int emergencyMB, int holdSec) {
+    pressureReleaseEnabled = enabled;
+    emergencyReleaseMB = emergencyMB < 1 ? 1 : emergencyMB;
+    emergencyHoldSec = holdSec < 0 ? 0 : holdSec;
+}
+
 void MemoryWorker::Start() {
     if (InterlockedCompareExchange(&running, 1, 0) != 0) return;
 
@@ -74,19 +213,55 @@ void MemoryWorker::Start() {
     lastRefreshTick = 0;
     randomTargetBytes = 0;
     refreshCursor = 0;
+    refreshOffset = 0;
+    refreshTokens = 0;
+    refreshBytesPerSec = 0;
+    refreshPagesPerSec = 0;
     residentBytesCache = 0;
+    residentLowCache = 0;
+    residentHighCache = 0;
+    residentSamplesCache = 0;
     residentApproximate = true;
+    residencyEstimator.Reset();
+    for (size_t i = 0; i < nodeResidency.size(); ++i) {
+        nodeResidency[i].Reset();
+        nodeResidentCache[i] = 0;
+    }
+    InterlockedExchange(&emergencyPendingMB, 0);
+    emergencyHoldUntil = 0;
+    // 新线程的 CPU 时间从 0 开始计
+    InterlockedExchange(&residencyCpuMs, 0);
+    residencyCpuRemainder = 0;
 
     RandomDelay(100, 300);
 
     workerThread = CreateThread(NULL, 0, WorkerThreadProc, this, 0, NULL);
+
+    if (pressureReleaseEnabled && pressureStopEvent) {
+        ResetEvent(pressureStopEvent);
+        pressureThread = CreateThread(NULL, 0, PressureThreadProc, this, 0, NULL);
+        if (pressureThread) {
+            SetThreadPriority(pressureThread, THREAD_PRIORITY_ABOVE_NORMAL);
+        }
+    }
 }
 
 void MemoryWorker::Stop() {
     if (InterlockedCompareExchange(&running, 0, 1) != 1) return;
 
+    if (pressureThread) {
+        SetEvent(pressureStopEvent);
+        WaitForSingleObject(pressureThread, 5000);
+        CloseHandle(pressureThread);
+        pressureThread = NULL;
+    }
+    InterlockedExchange(&underPressure, 0);
+
+    // 刷新和驻留查询遍历块列表时不持有 allocLock，必须等工作线程真正退出后才能释放；
+    // 这些循环每个批次都检查 running，不会无限期等待
     if (workerThread) {
-        WaitForSingleObject(workerThread, 5000);
+        if (wakeEvent) SetEvent(wakeEvent);
+        WaitForSingleObject(workerThread, INFINITE);
         CloseHandle(workerThread);
         workerThread = NULL;
     }
@@ -98,7 +273,14 @@ void MemoryWorker::Stop() {
     }
     allocatedMemory.clear();
     residentBytesCache = 0;
+    residentLowCache = 0;
+    residentHighCache = 0;
+    residentSamplesCache = 0;
+    residencyEstimator.Reset();
     refreshCursor = 0;
+    refreshOffset = 0;
+    refreshBytesPerSec = 0;
+    refreshPagesPerSec = 0;
 
     LeaveCriticalSection(&allocLock);
 
@@ -107,10 +289,108 @@ void MemoryWorker::Stop() {
 
 DWORD WINAPI MemoryWorker::WorkerThreadProc(LPVOID lpParam) {
     MemoryWorker* self = (MemoryWorker*)lpParam;
+    TraceRecorder::SetThreadName("memory-worker");
     self->WorkerLoop();
+    TraceRecorder::ReleaseThread();
     return 0;
 }
 
+DWORD WINAPI MemoryWorker::PressureThreadProc(LPVOID lpParam) {
+    MemoryWorker* self = (MemoryWorker*)lpParam;
+    self->PressureLoop();
+    return 0;
+}
+
+void MemoryWorker::PressureLoop() {
+    typedef BOOL (WINAPI *PQueryMemoryResourceNotification)(HANDLE, PBOOL);
+    HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
+    PQueryMemoryResourceNotification pQueryNotification = hKernel32
+        ? (PQueryMemoryResourceNotification)GetProcAddress(hKernel32, "QueryMemoryResourceNotification")
+        : NULL;
+
+    while (running) {
+        bool low = false;
+        if (lowMemoryNotification) {
+            HANDLE handles[2] = { pressureStopEvent, lowMemoryNotification };
+            DWORD wait = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            if (wait != WAIT_OBJECT_0 + 1) break;
+            low = true;
+        } else {
+            if (WaitForSingleObject(pressureStopEvent, 250) == WAIT_OBJECT_0) break;
+            low = IsPollingPressureHigh();
+        }
+
+        InterlockedExchange(&underPressure, low ? 1 : 0);
+        if (!low) continue;
+
+        TriggerEmergencyRelease();
+
+        // 低内存通知在压力解除前一直保持触发，释放后冷却 1 秒再重新等待，
+        // 压力仍在则再释放一块
+        if (WaitForSingleObject(pressureStopEvent, 1000) == WAIT_OBJECT_0) break;
+        if (lowMemoryNotification && pQueryNotification) {
+            BOOL state = FALSE;
+            if (pQueryNotification(lowMemoryNotification, &state)) {
+                InterlockedExchange(&underPressure, state ? 1 : 0);
+            }
+        }
+    }
+}
+
+bool MemoryWorker::TriggerEmergencyRelease(int releaseMB) {
+    if (!running || emergencyPendingMB != 0) return false;
+    if (releaseMB <= 0) releaseMB = emergencyReleaseMB;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    InterlockedExchange(&pressureSignalCounter, (LONG)now.LowPart);
+    // 压力线程和控制命令可能同时触发，只有一个能挂上请求
+    if (InterlockedCompareExchange(&emergencyPendingMB, releaseMB, 0) != 0) return false;
+    if (wakeEvent) SetEvent(wakeEvent);
+    return true;
+}
+
+void MemoryWorker::HandleEmergencyRelease() {
+    LONG releaseMB = InterlockedExchange(&emergencyPendingMB, 0);
+    if (releaseMB <= 0) return;
+
+    // 绕过 AdjustLoad 的步长限制和 RandomDelay，直接从尾部释放
+    int64_t before = GetAllocatedSize();
+    int64_t freed = FreeMemory((int64_t)releaseMB * 1024 * 1024, true);
+    int64_t remaining = before - freed;
+    if (remaining < 0) remaining = 0;
+    if ((int64_t)targetSizeMB * 1024 * 1024 > remaining) {
+        InterlockedExchange(&targetSizeMB, (LONG)(remaining / (1024 * 1024)));
+    }
+    emergencyHoldUntil = GetTickCount() + (DWORD)(emergencyHoldSec * 1000UL);
+    if (emergencyHoldUntil == 0) emergencyHoldUntil = 1;
+
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+
+    EnterCriticalSection(&allocLock);
+    ++emergencyReleaseCount;
+    lastEmergencyReleasedBytes = freed;
+    if (freq.QuadPart > 0) {
+        // 只比较低 32 位，按无符号回绕取差；释放延迟远小于回绕周期
+        DWORD elapsed = now.LowPart - (DWORD)pressureSignalCounter;
+        lastEmergencyLatencyMs = (double)elapsed * 1000.0 / (double)freq.QuadPart;
+    }
+    LeaveCriticalSection(&allocLock);
+}
+
+bool MemoryWorker::PauseWorker(DWORD ms) {
+    // 可被紧急释放打断的等待，返回 true 表示需要立即处理紧急释放
+    TraceScope trace("wait", NULL, ms);
+    if (wakeEvent) {
+        WaitForSingleObject(wakeEvent, ms);
+    } else {
+        Sleep(ms);
+    }
+    return emergencyPendingMB != 0 || !running;
+}
+
 DWORD MemoryWorker::PickNextRandomTick(DWORD nowTick) const {
     int interval = randomIntervalMinSec;
     if (randomIntervalMaxSec > randomIntervalMinSec) {
@@ -151,6 +431,8 @@ int64_t MemoryWorker::PickRandomTargetBytes(int64_t maxAllowedBytes, DWORD nowTi
 
 void MemoryWorker::WorkerLoop() {
     while (running) {
+        HandleEmergencyRelease();
+
         DWORD now = GetTickCount();
         int64_t targetBytes = (int64_t)targetSizeMB * 1024 * 1024;
         int64_t currentBytes = GetAllocatedSize();
@@ -162,12 +444,26 @@ void MemoryWorker::WorkerLoop() {
             FreeMemory(-diff);
         }
 
-        if (refreshEnabled && now - lastRefreshTick >= (DWORD)(refreshIntervalSec * 1000UL)) {
+        if (refreshEnabled) {
+            TraceScope trace("refresh");
             RefreshAllocatedPages(now);
         }
 
-        UpdateResidentStats();
-        Sleep(1000);
+        {
+            TraceScope trace("residency");
+            OverheadScope overhead(OVERHEAD_RESIDENCY);
+            LONGLONG residencyStart = OverheadMeter::GetThreadCpuTime();
+            UpdateResidentStats();
+            residencyCpuRemainder += OverheadMeter::GetThreadCpuTime() - residencyStart;
+            if (residencyCpuRemainder >= 10000) {
+                LONG ms = (LONG)(residencyCpuRemainder / 10000);
+                InterlockedExchangeAdd(&residencyCpuMs, ms);
+                residencyCpuRemainder -= ms * 10000LL;
+            }
+        }
+        if (emergencyPendingMB == 0) {
+            PauseWorker(1000);
+        }
     }
 }
 
@@ -188,26 +484,30 @@ void MemoryWorker::AllocateMemory(int64_t sizeBytes) {
 
     EnterCriticalSection(&allocLock);
 
-    for (int64_t i = 0; i < chunks && running; i++) {
+    for (int64_t i = 0; i < chunks && running && emergencyPendingMB == 0; i++) {
         int variation = (rand() % 40) - 20;
         int64_t variedSize = actualChunkSize + (actualChunkSize * variation / 100);
         if (variedSize < 1024 * 1024) variedSize = 1024 * 1024;
 
         RandomDelay(5, 50);
 
-        void* chunk = VirtualAlloc(NULL, (SIZE_T)variedSize,
-                                   MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        int node = PickNumaNode();
+        void* chunk = NULL;
+        {
+            TraceScope trace("VirtualAlloc", NULL, (double)variedSize);
+            chunk = SystemCompat::AllocateOnNode((size_t)variedSize, node);
+        }
 
         if (chunk) {
             size_t writeSize = (size_t)variedSize;
-            for (size_t j = 0; j < writeSize; j += 4096) {
-                DWORD tick = GetTickCount();
-                ((char*)chunk)[j] = (char)((tick + j) % 256);
+            FirstTouchPages(chunk, writeSize);
+            if (reclaimableFiller) {
+                MarkReclaimable(chunk, 0, writeSize);
             }
-            allocatedMemory.push_back(MemoryBlockInfo(chunk, variedSize, GetTickCount()));
+            allocatedMemory.push_back(MemoryBlockInfo(chunk, variedSize, GetTickCount(), node));
 
             if (i % 5 == 0 && i > 0) {
-                Sleep(100 + (rand() % 100));
+                if (PauseWorker(100 + (rand() % 100))) break;
             }
         } else {
             break;
@@ -219,24 +519,37 @@ void MemoryWorker::AllocateMemory(int64_t sizeBytes) {
     }
 
     int64_t remainder = sizeBytes % actualChunkSize;
-    if (remainder > 0 && running) {
+    if (remainder > 0 && running && emergencyPendingMB == 0) {
         RandomDelay(10, 30);
 
-        void* chunk = VirtualAlloc(NULL, (SIZE_T)remainder,
-                                   MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        int node = PickNumaNode();
+        void* chunk = NULL;
+        {
+            TraceScope trace("VirtualAlloc", NULL, (double)remainder);
+            chunk = SystemCompat::AllocateOnNode((size_t)remainder, node);
+        }
         if (chunk) {
-            for (size_t j = 0; j < (size_t)remainder; j += 4096) {
-                DWORD tick = GetTickCount();
-                ((char*)chunk)[j] = (char)((tick + j) % 256);
+            FirstTouchPages(chunk, (size_t)remainder);
+            if (reclaimableFiller) {
+                MarkReclaimable(chunk, 0, (size_t)remainder);
             }
-            allocatedMemory.push_back(MemoryBlockInfo(chunk, remainder, GetTickCount()));
+            allocatedMemory.push_back(MemoryBlockInfo(chunk, remainder, GetTickCount(), node));
         }
     }
 
     LeaveCriticalSection(&allocLock);
 }
 
-void MemoryWorker::FreeMemory(int64_t sizeBytes) {
+// 新申请的块逐页写入一次，使其立即计入工作集
+void MemoryWorker::FirstTouchPages(void* chunk, size_t sizeBytes) {
+    TraceScope trace("touch", NULL, (double)sizeBytes);
+    for (size_t j = 0; j < sizeBytes; j += 4096) {
+        DWORD tick = GetTickCount();
+        ((char*)chunk)[j] = (char)((tick + j) % 256);
+    }
+}
+
+int64_t MemoryWorker::FreeMemory(int64_t sizeBytes, bool immediate) {
     int64_t freed = 0;
 
     EnterCriticalSection(&allocLock);
@@ -247,17 +560,22 @@ void MemoryWorker::FreeMemory(int64_t sizeBytes) {
 
         freed += block.sizeBytes;
         if (block.ptr) {
+            TraceScope trace("VirtualFree", NULL, (double)block.sizeBytes);
             VirtualFree(block.ptr, 0, MEM_RELEASE);
         }
 
         if (refreshCursor >= allocatedMemory.size()) {
             refreshCursor = allocatedMemory.empty() ? 0 : allocatedMemory.size() - 1;
+            refreshOffset = 0;
         }
 
-        RandomDelay(1, 10);
+        if (!immediate) {
+            RandomDelay(1, 10);
+        }
     }
 
     LeaveCriticalSection(&allocLock);
+    return freed;
 }
 
 int64_t MemoryWorker::GetAllocatedSize() const {
@@ -272,91 +590,365 @@ int64_t MemoryWorker::GetAllocatedSize() const {
     return total;
 }
 
-int64_t MemoryWorker::CalculateResidentBytesLocked(bool& approximate) const {
-    int64_t residentTotal = 0;
-    bool anyAccurate = false;
+uint64_t MemoryWorker::NextRandom() {
+    // xorshift64*：rand() 只有 15 位，覆盖不了上百 GB 的页号范围
+    sampleRngState ^= sampleRngState >> 12;
+    sampleRngState ^= sampleRngState << 25;
+    sampleRngState ^= sampleRngState >> 27;
+    return sampleRngState * 0x2545F4914F6CDD1DULL;
+}
+
+bool MemoryWorker::CalculateResidentBytesExact(int64_t& residentBytes, bool& approximate) const {
+    residentBytes = 0;
     approximate = true;
 
-    const size_t strideBytes = (size_t)refreshStrideKB * 1024;
+    const size_t pageSize = SystemCompat::GetPageSize();
+    bool anyQueried = false;
+    bool anyApproximate = false;
     for (size_t i = 0; i < allocatedMemory.size(); ++i) {
+        // 填充量很大时整遍查询要很久，停止或紧急释放时放弃本次结果，本轮退回抽样估计
+        if (!running || emergencyPendingMB != 0) return false;
+
         uint64_t blockResident = 0;
         bool blockApproximate = true;
         if (SystemCompat::QueryRegionResidentBytes(allocatedMemory[i].ptr,
                                                    (size_t)allocatedMemory[i].sizeBytes,
-                                                   strideBytes,
+                                                   pageSize,
                                                    blockResident,
                                                    blockApproximate)) {
-            residentTotal += (int64_t)blockResident;
-            if (!blockApproximate) {
-                anyAccurate = true;
+            residentBytes += (int64_t)blockResident;
+            anyQueried = true;
+            if (blockApproximate) {
+                anyApproximate = true;
             }
         }
     }
 
-    if (!allocatedMemory.empty() && anyAccurate) {
-        approximate = false;
+    approximate = !anyQueried || anyApproximate;
+    return anyQueried;
+}
+
+bool MemoryWorker::SampleResidency(int& residentCount, int& sampleCount) {
+    residentCount = 0;
+    sampleCount = 0;
+    if (residencySamplesPerTick <= 0 || allocatedMemory.empty()) {
+        return false;
+    }
+
+    // 按页数加权在所有块中均匀抽样
+    const size_t pageSize = SystemCompat::GetPageSize();
+    blockPageEnds.resize(allocatedMemory.size());
+    uint64_t totalPages = 0;
+    for (size_t i = 0; i < allocatedMemory.size(); ++i) {
+        totalPages += ((uint64_t)allocatedMemory[i].sizeBytes + pageSize - 1) / pageSize;
+        blockPageEnds[i] = totalPages;
     }
-    return residentTotal;
+    if (totalPages == 0) {
+        return false;
+    }
+
+    const size_t count = (size_t)residencySamplesPerTick;
+    residencyQuery.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        uint64_t page = NextRandom() % totalPages;
+        size_t index = (size_t)(std::upper_bound(blockPageEnds.begin(), blockPageEnds.end(), page) -
+                                blockPageEnds.begin());
+        uint64_t firstPage = index > 0 ? blockPageEnds[index - 1] : 0;
+        residencyQuery[k].VirtualAddress =
+            (PVOID)((char*)allocatedMemory[index].ptr + (size_t)(page - firstPage) * pageSize);
+    }
+
+    if (!SystemCompat::QueryPagesResident(&residencyQuery[0], count)) {
+        return false;
+    }
+
+    std::fill(nodeSampleHits.begin(), nodeSampleHits.end(), 0);
+    for (size_t k = 0; k < count; ++k) {
+        if (residencyQuery[k].VirtualAttributes.Valid) {
+            ++residentCount;
+            // 驻留页的 Node 字段是物理页实际所在节点，可能与请求的节点不同
+            size_t node = (size_t)residencyQuery[k].VirtualAttributes.Node;
+            if (node < nodeSampleHits.size()) {
+                ++nodeSampleHits[node];
+            }
+        }
+    }
+    sampleCount = (int)count;
+    return true;
 }
 
 void MemoryWorker::UpdateResidentStats() {
-    EnterCriticalSection(&allocLock);
+    // 与刷新一样只在工作线程上执行，整个估计过程不持有 allocLock，
+    // 只在最后发布结果时短暂加锁
+    int64_t allocatedBytes = 0;
+    for (size_t i = 0; i < allocatedMemory.size(); ++i) {
+        allocatedBytes += allocatedMemory[i].sizeBytes;
+    }
 
+    int64_t residentBytes = 0;
+    int64_t lowBytes = 0;
+    int64_t highBytes = 0;
     bool approximate = true;
-    int64_t residentBytes = CalculateResidentBytesLocked(approximate);
-    if (residentBytes == 0 && !allocatedMemory.empty()) {
+    bool measured = false;
+    DWORD exactTick = lastExactScanTick;
+
+    if (allocatedMemory.empty()) {
+        residencyEstimator.Reset();
+    } else {
+        if (InterlockedExchange(&exactScanRequested, 0) != 0) {
+            int64_t exactBytes = 0;
+            bool exactApproximate = true;
+            if (CalculateResidentBytesExact(exactBytes, exactApproximate)) {
+                residencyEstimator.SetExact(allocatedBytes > 0 ? (double)exactBytes / allocatedBytes : 0);
+                residentBytes = exactBytes;
+                lowBytes = exactBytes;
+                highBytes = exactBytes;
+                approximate = exactApproximate;
+                measured = true;
+                exactTick = GetTickCount();
+            } else if (running && emergencyPendingMB != 0) {
+                // 被紧急释放打断，释放完成后重新扫描
+                InterlockedExchange(&exactScanRequested, 1);
+            }
+        }
+
+        if (!measured) {
+            int residentCount = 0;
+            int sampleCount = 0;
+            if (SampleResidency(residentCount, sampleCount)) {
+                residencyEstimator.AddSamples(residentCount, sampleCount);
+                for (size_t n = 0; n < nodeResidency.size(); ++n) {
+                    nodeResidency[n].AddSamples(nodeSampleHits[n], sampleCount);
+                }
+            }
+            if (residencyEstimator.HasData()) {
+                double lower = 0;
+                double upper = 1;
+                residencyEstimator.GetInterval(lower, upper);
+                residentBytes = (int64_t)(residencyEstimator.GetFraction() * allocatedBytes);
+                lowBytes = (int64_t)(lower * allocatedBytes);
+                highBytes = (int64_t)(upper * allocatedBytes);
+                measured = true;
+            }
+        }
+
+        // 进程工作集是最便宜的上界：填充内存的驻留量不可能超过整个进程的工作集
         ProcessMemorySnapshot snapshot;
         if (SystemCompat::QueryCurrentProcessMemory(snapshot)) {
-            residentBytes = (int64_t)snapshot.workingSetBytes;
-            approximate = true;
+            int64_t workingSet = (int64_t)snapshot.workingSetBytes;
+            if (!measured) {
+                residentBytes = workingSet < allocatedBytes ? workingSet : allocatedBytes;
+                lowBytes = 0;
+                highBytes = residentBytes;
+                approximate = true;
+            } else {
+                if (highBytes > workingSet) highBytes = workingSet;
+                if (residentBytes > highBytes) residentBytes = highBytes;
+                if (lowBytes > residentBytes) lowBytes = residentBytes;
+            }
         }
     }
 
+    // 可回收模式下不在工作集的部分即被系统丢弃的页面，不会占用页面文件
+    int64_t reclaimedBytes = 0;
+    if (reclaimableFiller && allocatedBytes > residentBytes) {
+        reclaimedBytes = allocatedBytes - residentBytes;
+    }
+
+    EnterCriticalSection(&allocLock);
     residentBytesCache = residentBytes;
+    reclaimedBytesCache = reclaimedBytes;
+    for (size_t n = 0; n < nodeResidency.size(); ++n) {
+        nodeResidentCache[n] = allocatedMemory.empty()
+            ? 0 : (int64_t)(nodeResidency[n].GetFraction() * allocatedBytes);
+    }
+    residentLowCache = lowBytes;
+    residentHighCache = highBytes;
+    residentSamplesCache = residencyEstimator.GetEffectiveSamples();
     residentApproximate = approximate;
-
+    lastExactScanTick = exactTick;
     LeaveCriticalSection(&allocLock);
 }
 
-void MemoryWorker::RefreshAllocatedPages(DWORD nowTick) {
-    if (!refreshEnabled) return;
+int64_t MemoryWorker::TouchRange(char* base, size_t beginOffset, size_t endOffset,
+                                 size_t strideBytes, DWORD nowTick, bool streaming) {
+    int64_t pages = 0;
+    for (size_t offset = beginOffset; offset < endOffset; offset += strideBytes) {
+        const uint32_t value = (uint32_t)(nowTick + offset);
+        if (streaming) {
+            CpuFeatures::StreamStore32(base + offset, value);
+        } else {
+            // 只写不读：省掉一次读缺失，页面照样被置脏
+            *(volatile uint32_t*)(base + offset) = value;
+        }
+        ++pages;
+    }
+    return pages;
+}
 
-    EnterCriticalSection(&allocLock);
+void MemoryWorker::MarkReclaimable(void* base, size_t beginOffset, size_t endOffset) {
+    // MEM_RESET 只作用于整页：起点向上、终点向下对齐。页面仍留在工作集里占用内存，
+    // 但内容不再需要写入页面文件，系统换出时可直接丢弃
+    const size_t pageSize = SystemCompat::GetPageSize();
+    size_t first = (beginOffset + pageSize - 1) / pageSize * pageSize;
+    size_t last = endOffset / pageSize * pageSize;
+    if (last <= first) return;
+    VirtualAlloc((char*)base + first, (SIZE_T)(last - first), MEM_RESET, PAGE_READWRITE);
+}
 
-    if (allocatedMemory.empty()) {
-        lastRefreshTick = nowTick;
-        LeaveCriticalSection(&allocLock);
-        return;
+bool MemoryWorker::IsPressureHigh() const {
+    if (pressureThread) {
+        return underPressure != 0;
     }
+    return IsPollingPressureHigh();
+}
+
+bool MemoryWorker::IsPollingPressureHigh() const {
+    LONG level = pressureThreshold + PRESSURE_POLL_MARGIN;
+    if (level > PRESSURE_POLL_MAX_LOAD) level = PRESSURE_POLL_MAX_LOAD;
+    MemoryStatusSnapshot status;
+    return SystemCompat::QueryMemoryStatus(status) && (LONG)status.memoryLoad >= level;
+}
+
+int64_t MemoryWorker::RefreshReclaimableRange(char* base, size_t beginOffset, size_t endOffset,
+                                              size_t strideBytes, DWORD nowTick, bool allowRepopulate,
+                                              int64_t& reclaimedPages, int64_t& repopulatedPages) {
+    // 可回收模式下刷新不能直接写页面（写入会让页面重新变脏），
+    // 先查询工作集找出已被系统回收的页，压力解除后才重新写入并再次标记
+    const size_t batchSize = 256;
+    PSAPI_WORKING_SET_EX_INFORMATION entries[batchSize];
+    int64_t visited = 0;
+
+    size_t offset = beginOffset;
+    while (offset < endOffset) {
+        const size_t batchBegin = offset;
+        size_t count = 0;
+        for (; count < batchSize && offset < endOffset; ++count, offset += strideBytes) {
+            entries[count].VirtualAddress = (PVOID)(base + offset);
+        }
+        visited += (int64_t)count;
+
+        // QueryWorkingSetEx 不可用时无法区分，全部视为已回收
+        bool queried = SystemCompat::QueryPagesResident(entries, count);
+        int64_t written = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (queried && entries[i].VirtualAttributes.Valid) continue;
+            if (queried) ++reclaimedPages;
+            if (!allowRepopulate) continue;
+            *(volatile uint32_t*)entries[i].VirtualAddress = (uint32_t)(nowTick + i);
+            ++written;
+        }
 
-    if (refreshCursor >= allocatedMemory.size()) {
-        refreshCursor = 0;
+        if (written > 0) {
+            repopulatedPages += written;
+            MarkReclaimable(base, batchBegin, offset < endOffset ? offset : endOffset);
+        }
     }
+    return visited;
+}
+
+void MemoryWorker::RefreshAllocatedPages(DWORD nowTick) {
+    if (!refreshEnabled) return;
+
+    // allocatedMemory 只在工作线程上增删，刷新也在工作线程上执行，
+    // 因此遍历块列表无需持有 allocLock，GetStats/GetAllocatedSize 不会被刷新阻塞
+    DWORD elapsedMs = lastRefreshTick ? nowTick - lastRefreshTick : 1000;
+    if (elapsedMs == 0) return;
+    if (elapsedMs > 2000) elapsedMs = 2000;
 
     const size_t strideBytes = (size_t)refreshStrideKB * 1024;
-    size_t refreshedBlocks = 0;
-    const size_t maxBlocksPerCycle = allocatedMemory.size() < 4 ? allocatedMemory.size() : 4;
 
-    while (refreshedBlocks < maxBlocksPerCycle && !allocatedMemory.empty()) {
-        if (refreshCursor >= allocatedMemory.size()) {
+    // 令牌桶：MB/s 与 页/s 两个预算取较小者，0 表示该维度不限
+    double ratePerSec = 0;
+    if (refreshBudgetMBps > 0) {
+        ratePerSec = (double)refreshBudgetMBps * 1024.0 * 1024.0;
+    }
+    if (refreshBudgetPagesPerSec > 0) {
+        double pageRate = (double)refreshBudgetPagesPerSec * (double)strideBytes;
+        if (ratePerSec <= 0 || pageRate < ratePerSec) {
+            ratePerSec = pageRate;
+        }
+    }
+    if (ratePerSec <= 0) {
+        ratePerSec = (double)totalMemoryBytes;
+    }
+
+    refreshTokens += ratePerSec * elapsedMs / 1000.0;
+    if (refreshTokens > ratePerSec * 2.0) {
+        refreshTokens = ratePerSec * 2.0;
+    }
+
+    const DWORD afterMs = (DWORD)(refreshAfterSec * 1000UL);
+    const DWORD intervalMs = (DWORD)(refreshIntervalSec * 1000UL);
+    const bool streaming = refreshStreaming && CpuFeatures::HasStreamingStores() && !reclaimableFiller;
+    const bool allowRepopulate = reclaimableFiller && !IsPressureHigh();
+    const size_t blockCount = allocatedMemory.size();
+    int64_t reclaimedPages = 0;
+    int64_t repopulatedPages = 0;
+
+    LARGE_INTEGER freq, begin, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&begin);
+
+    int64_t touchedPages = 0;
+    size_t visitedBlocks = 0;
+    while (running && emergencyPendingMB == 0 && blockCount > 0 && visitedBlocks <= blockCount &&
+           refreshTokens >= (double)strideBytes) {
+        if (refreshCursor >= blockCount) {
             refreshCursor = 0;
+            refreshOffset = 0;
         }
 
         MemoryBlockInfo& block = allocatedMemory[refreshCursor];
-        DWORD heldMs = nowTick - block.allocatedTick;
-        if (heldMs >= (DWORD)(refreshAfterSec * 1000UL) && block.ptr && block.sizeBytes > 0) {
-            for (size_t offset = 0; offset < (size_t)block.sizeBytes; offset += strideBytes) {
-                volatile char* p = ((volatile char*)block.ptr) + offset;
-                *p = (char)((*p + 1) & 0xFF);
-            }
+        const size_t blockBytes = (size_t)block.sizeBytes;
+        bool eligible = block.ptr && blockBytes > 0 &&
+                        nowTick - block.allocatedTick >= afterMs &&
+                        (refreshOffset > 0 ||
+                         block.lastTouchTick == block.allocatedTick ||
+                         nowTick - block.lastTouchTick >= intervalMs);
+        if (!eligible) {
+            ++refreshCursor;
+            refreshOffset = 0;
+            ++visitedBlocks;
+            continue;
+        }
+
+        size_t allowed = (size_t)(refreshTokens / strideBytes) * strideBytes;
+        size_t stop = blockBytes - refreshOffset > allowed ? refreshOffset + allowed : blockBytes;
+        int64_t pages = reclaimableFiller
+            ? RefreshReclaimableRange((char*)block.ptr, refreshOffset, stop, strideBytes, nowTick,
+                                      allowRepopulate, reclaimedPages, repopulatedPages)
+            : TouchRange((char*)block.ptr, refreshOffset, stop, strideBytes, nowTick, streaming);
+        touchedPages += pages;
+        refreshTokens -= (double)pages * strideBytes;
+
+        if (stop >= blockBytes) {
             block.lastTouchTick = nowTick;
+            ++refreshCursor;
+            refreshOffset = 0;
+            ++visitedBlocks;
+        } else {
+            refreshOffset = stop;
+            break;
         }
+    }
 
-        ++refreshCursor;
-        ++refreshedBlocks;
+    if (streaming && touchedPages > 0) {
+        CpuFeatures::StreamFence();
     }
 
+    QueryPerformanceCounter(&end);
+
+    EnterCriticalSection(&allocLock);
     lastRefreshTick = nowTick;
+    reclaimDetectedBytes += reclaimedPages * (int64_t)strideBytes;
+    repopulatedBytes += repopulatedPages * (int64_t)strideBytes;
+    refreshPagesPerSec = touchedPages * 1000 / elapsedMs;
+    refreshBytesPerSec = refreshPagesPerSec * (int64_t)strideBytes;
+    if (touchedPages > 0 && freq.QuadPart > 0) {
+        refreshNsPerPage = (double)(end.QuadPart - begin.QuadPart) * 1e9 /
+                           (double)freq.QuadPart / (double)touchedPages;
+    }
     LeaveCriticalSection(&allocLock);
 }
 
@@ -381,10 +973,7 @@ void MemoryWorker::AdjustLoad(double currentWorkerUsage, double targetWorkerUsag
 
     lastAdjustTime = now;
 
-    int64_t maxTargetBytes = (int64_t)(totalMemoryBytes * targetWorkerUsage / 100.0);
-    int64_t hardMaxBytes = (int64_t)(totalMemoryBytes * 0.95);
-    if (maxTargetBytes > hardMaxBytes) maxTargetBytes = hardMaxBytes;
-    if (maxTargetBytes < 0) maxTargetBytes = 0;
+    int64_t maxTargetBytes = UsageToTargetBytes(totalMemoryBytes, targetWorkerUsage);
 
     int64_t policyTargetBytes = maxTargetBytes;
     if (now >= nextRandomizeTick || randomTargetBytes <= 0 || randomTargetBytes > maxTargetBytes) {
@@ -393,27 +982,51 @@ void MemoryWorker::AdjustLoad(double currentWorkerUsage, double targetWorkerUsag
         policyTargetBytes = randomTargetBytes;
     }
 
-    int64_t currentBytes = GetAllocatedSize();
+    // 紧急释放后的保持期内不允许回涨，避免刚让出的内存被立即重新占用
+    bool holding = underPressure != 0 ||
+                   (emergencyHoldUntil != 0 && (LONG)(now - emergencyHoldUntil) < 0);
+    policyTargetBytes = StepTargetBytes(GetAllocatedSize(), policyTargetBytes, totalMemoryBytes,
+                                        maxAdjustPerCycle, holding);
+
+    InterlockedExchange(&targetSizeMB, (LONG)(policyTargetBytes / (1024 * 1024)));
+    (void)currentWorkerUsage;
+}
+
+int64_t MemoryWorker::UsageToTargetBytes(uint64_t totalBytes, double targetWorkerUsage) {
+    int64_t maxTargetBytes = (int64_t)(totalBytes * targetWorkerUsage / 100.0);
+    int64_t hardMaxBytes = (int64_t)(totalBytes * 0.95);
+    if (maxTargetBytes > hardMaxBytes) maxTargetBytes = hardMaxBytes;
+    if (maxTargetBytes < 0) maxTargetBytes = 0;
+    return maxTargetBytes;
+}
+
+int64_t MemoryWorker::StepTargetBytes(int64_t currentBytes, int64_t policyTargetBytes, uint64_t totalBytes,
+                                      int64_t maxAdjust, bool holding) {
     int64_t diff = policyTargetBytes - currentBytes;
 
     int64_t adjustStep;
     int64_t absDiff = diff >= 0 ? diff : -diff;
-    double diffPercent = (double)absDiff / totalMemoryBytes * 100.0;
+    double diffPercent = totalBytes > 0 ? (double)absDiff / totalBytes * 100.0 : 0;
 
     if (diffPercent > 10.0) {
-        adjustStep = maxAdjustPerCycle;
+        adjustStep = maxAdjust;
     } else if (diffPercent > 5.0) {
-        adjustStep = maxAdjustPerCycle / 2;
+        adjustStep = maxAdjust / 2;
     } else if (diffPercent > 2.0) {
-        adjustStep = maxAdjustPerCycle / 4;
+        adjustStep = maxAdjust / 4;
     } else {
-        adjustStep = maxAdjustPerCycle / 8;
+        adjustStep = maxAdjust / 8;
     }
 
     if (adjustStep < 64LL * 1024 * 1024) {
         adjustStep = 64LL * 1024 * 1024;
     }
 
+    if (holding &&
+        policyTargetBytes > currentBytes) {
+        policyTargetBytes = currentBytes;
+    }
+
     if (policyTargetBytes > currentBytes + adjustStep) {
         policyTargetBytes = currentBytes + adjustStep;
     } else if (policyTargetBytes < currentBytes - adjustStep) {
@@ -421,9 +1034,12 @@ void MemoryWorker::AdjustLoad(double currentWorkerUsage, double targetWorkerUsag
     }
 
     if (policyTargetBytes < 0) policyTargetBytes = 0;
+    return policyTargetBytes;
+}
 
-    InterlockedExchange(&targetSizeMB, (LONG)(policyTargetBytes / (1024 * 1024)));
-    (void)currentWorkerUsage;
+LONGLONG MemoryWorker::GetThreadCpuTime() const {
+    LONGLONG cpuTime = OverheadMeter::GetThreadCpuTime(workerThread) - (LONGLONG)residencyCpuMs * 10000;
+    return cpuTime > 0 ? cpuTime : 0;
 }
 
 MemoryWorkerStats MemoryWorker::GetStats() const {
@@ -440,6 +1056,33 @@ MemoryWorkerStats MemoryWorker::GetStats() const {
     stats.blockCount = allocatedMemory.size();
     stats.lastRefreshTick = lastRefreshTick;
     stats.residentApproximate = residentApproximate;
+    stats.refreshBytesPerSec = refreshBytesPerSec;
+    stats.refreshPagesPerSec = refreshPagesPerSec;
+    stats.refreshNsPerPage = refreshNsPerPage;
+    stats.refreshStreaming = refreshStreaming && CpuFeatures::HasStreamingStores();
+    stats.residentLowBytes = residentLowCache;
+    stats.residentHighBytes = residentHighCache;
+    stats.residentSamples = residentSamplesCache;
+    stats.lastExactScanTick = lastExactScanTick;
+    stats.underPressure = underPressure != 0;
+    stats.emergencyReleaseCount = emergencyReleaseCount;
+    stats.lastEmergencyReleasedBytes = lastEmergencyReleasedBytes;
+    stats.lastEmergencyLatencyMs = lastEmergencyLatencyMs;
+    stats.reclaimable = reclaimableFiller;
+    stats.committedBytes = stats.allocatedBytes;
+    stats.reclaimedBytes = reclaimedBytesCache;
+    stats.reclaimDetectedBytes = reclaimDetectedBytes;
+    stats.repopulatedBytes = repopulatedBytes;
+    stats.numaMode = numaMode;
+    stats.numaNodeCount = numaNodeCount;
+    stats.nodeAllocatedBytes.assign(numaNodeCount > 0 ? numaNodeCount : 1, 0);
+    for (size_t i = 0; i < allocatedMemory.size(); ++i) {
+        int node = allocatedMemory[i].node;
+        if (node >= 0 && node < (int)stats.nodeAllocatedBytes.size()) {
+            stats.nodeAllocatedBytes[node] += allocatedMemory[i].sizeBytes;
+        }
+    }
+    stats.nodeResidentBytes = nodeResidentCache;
     LeaveCriticalSection((LPCRITICAL_SECTION)&allocLock);
 
     return stats;
@@ -1,17 +1,29 @@
 #pragma once
 #include <windows.h>
 #include <vector>
+#include <string>
 #include <stdint.h>
+#include "residency_estimator.h"
+#include "../platform/system_compat.h"
+
+// NUMA 放置策略：关闭 / 按块轮流分布到各节点 / 按各节点空闲内存比例 / 仅指定节点
+enum MemoryNumaMode {
+    MEMORY_NUMA_OFF = 0,
+    MEMORY_NUMA_INTERLEAVE,
+    MEMORY_NUMA_PROPORTIONAL,
+    MEMORY_NUMA_NODES
+};
 
 struct MemoryBlockInfo {
     void* ptr;
     int64_t sizeBytes;
     DWORD allocatedTick;
     DWORD lastTouchTick;
+    int node;  // 请求放置的 NUMA 节点，-1 表示由系统决定
 
-    MemoryBlockInfo() : ptr(NULL), sizeBytes(0), allocatedTick(0), lastTouchTick(0) {}
-    MemoryBlockInfo(void* p, int64_t size, DWORD tick)
-        : ptr(p), sizeBytes(size), allocatedTick(tick), lastTouchTick(tick) {}
+    MemoryBlockInfo() : ptr(NULL), sizeBytes(0), allocatedTick(0), lastTouchTick(0), node(-1) {}
+    MemoryBlockInfo(void* p, int64_t size, DWORD tick, int nodeIndex = -1)
+        : ptr(p), sizeBytes(size), allocatedTick(tick), lastTouchTick(tick), node(nodeIndex) {}
 };
 
 struct MemoryWorkerStats {
@@ -23,12 +35,51 @@ struct MemoryWorkerStats {
     bool refreshEnabled;
     bool residentApproximate;
 
+    // 页面刷新实际达到的速率（按步长覆盖的字节/页计）与单页耗时
+    int64_t refreshBytesPerSec;
+    int64_t refreshPagesPerSec;
+    double refreshNsPerPage;
+    bool refreshStreaming;
+
+    // 抽样估计的 95% 置信区间、等效样本数与最近一次精确扫描时间
+    int64_t residentLowBytes;
+    int64_t residentHighBytes;
+    double residentSamples;
+    DWORD lastExactScanTick;
+
+    // 内存压力紧急释放：次数、最近一次释放量与从收到信号到释放完成的耗时
+    bool underPressure;
+    LONG emergencyReleaseCount;
+    int64_t lastEmergencyReleasedBytes;
+    double lastEmergencyLatencyMs;
+
+    // 可回收模式：已提交、被系统回收（不在工作集）的字节，以及刷新累计发现/重新填充的字节
+    bool reclaimable;
+    int64_t committedBytes;
+    int64_t reclaimedBytes;
+    int64_t reclaimDetectedBytes;
+    int64_t repopulatedBytes;
+
+    // 每个 NUMA 节点上请求放置的字节数，以及按抽样页面实际所在节点估计的驻留字节数
+    int numaMode;
+    int numaNodeCount;
+    std::vector<int64_t> nodeAllocatedBytes;
+    std::vector<int64_t> nodeResidentBytes;
+
     MemoryWorkerStats()
         : targetBytes(0), allocatedBytes(0), residentBytes(0), blockCount(0),
-          lastRefreshTick(0), refreshEnabled(false), residentApproximate(false) {}
+          lastRefreshTick(0), refreshEnabled(false), residentApproximate(false),
+          refreshBytesPerSec(0), refreshPagesPerSec(0), refreshNsPerPage(0),
+          refreshStreaming(false), residentLowBytes(0), residentHighBytes(0),
+          residentSamples(0), lastExactScanTick(0), underPressure(false),
+          emergencyReleaseCount(0), lastEmergencyReleasedBytes(0), lastEmergencyLatencyMs(0),
+          reclaimable(false), committedBytes(0), reclaimedBytes(0), reclaimDetectedBytes(0),
+          repopulatedBytes(0), numaMode(MEMORY_NUMA_OFF), numaNodeCount(1) {}
 };
 
 class MemoryWorker {
+    friend class MicroBenchmark;
+
 private:
     volatile LONG running;
     std::vector<MemoryBlockInfo> allocatedMemory;
@@ -49,14 +100,64 @@ private:
     int refreshAfterSec;
     int refreshIntervalSec;
     int refreshStrideKB;
+    int refreshBudgetMBps;
+    int refreshBudgetPagesPerSec;
+    bool refreshStreaming;
 
     DWORD nextRandomizeTick;
     DWORD lastRefreshTick;
     int64_t randomTargetBytes;
     size_t refreshCursor;
+    size_t refreshOffset;
+    double refreshTokens;
+    int64_t refreshBytesPerSec;
+    int64_t refreshPagesPerSec;
+    double refreshNsPerPage;
     int64_t residentBytesCache;
+    int64_t residentLowCache;
+    int64_t residentHighCache;
+    double residentSamplesCache;
     bool residentApproximate;
 
+    int residencySamplesPerTick;
+    volatile LONG exactScanRequested;
+    DWORD lastExactScanTick;
+    volatile LONG residencyCpuMs;       // 驻留查询累计 CPU 时间（毫秒），已计入控制面开销
+    LONGLONG residencyCpuRemainder;     // 不足 1 毫秒的部分，仅工作线程读写
+    uint64_t sampleRngState;
+    ResidencyEstimator residencyEstimator;
+    std::vector<PSAPI_WORKING_SET_EX_INFORMATION> residencyQuery;
+    std::vector<uint64_t> blockPageEnds;
+
+    bool pressureReleaseEnabled;
+    int emergencyReleaseMB;
+    int emergencyHoldSec;
+    HANDLE wakeEvent;
+    HANDLE pressureThread;
+    HANDLE pressureStopEvent;
+    HANDLE lowMemoryNotification;
+    volatile LONG emergencyPendingMB;
+    volatile LONG underPressure;
+    volatile LONG pressureSignalCounter;  // 压力信号时刻的 QPC 低 32 位，由压力线程写、工作线程读
+    volatile LONG pressureThreshold;      // 内存阈值，轮询模式下超过阈值加余量视为低内存
+    DWORD emergencyHoldUntil;
+    LONG emergencyReleaseCount;
+    int64_t lastEmergencyReleasedBytes;
+    double lastEmergencyLatencyMs;
+
+    bool reclaimableFiller;
+    int64_t reclaimedBytesCache;
+    int64_t reclaimDetectedBytes;
+    int64_t repopulatedBytes;
+
+    int numaMode;
+    int numaNodeCount;
+    std::vector<int> numaCandidates;
+    size_t numaNextIndex;
+    std::vector<int> nodeSampleHits;
+    std::vector<ResidencyEstimator> nodeResidency;
+    std::vector<int64_t> nodeResidentCache;
+
 public:
     MemoryWorker(int threshold, uint64_t totalMemory);
     ~MemoryWorker();
@@ -66,23 +167,57 @@ public:
     bool IsRunning() const { return running != 0; }
 
     void AdjustLoad(double currentWorkerUsage, double targetWorkerUsage);
+    // 以下为 AdjustLoad 的纯计算部分，离线仿真直接调用：
+    // 目标占用换算为字节（上限为物理内存的 95%）、单次调整上限、按差距分档限制步长后的下一步目标
+    static int64_t UsageToTargetBytes(uint64_t totalBytes, double targetWorkerUsage);
+    static int64_t ComputeMaxAdjustPerCycle(uint64_t totalBytes);
+    static int64_t StepTargetBytes(int64_t currentBytes, int64_t policyTargetBytes, uint64_t totalBytes,
+                                   int64_t maxAdjust, bool holding);
     int64_t GetAllocatedSize() const;
     int64_t GetTargetSize() const { return targetSizeMB * 1024LL * 1024LL; }
     double GetUsage() const;
     void SetTotalMemory(uint64_t total) { totalMemoryBytes = total; }
     void ConfigureRandomRange(int minMB, int maxMB, int intervalMinSec, int intervalMaxSec);
     void ConfigureRefresh(bool enabled, int afterSec, int intervalSec, int strideKB);
+    void ConfigureRefreshBudget(int mbPerSec, int pagesPerSec, bool streaming);
+    void ConfigureResidencySampling(int samplesPerTick);
+    void RequestExactResidentScan() { InterlockedExchange(&exactScanRequested, 1); }
+    void ConfigurePressureRelease(bool enabled, int emergencyMB, int holdSec);
+    // releaseMB 为 0 时按 emergency_release_mb 释放；已有请求未处理时丢弃并返回 false
+    bool TriggerEmergencyRelease(int releaseMB = 0);
+    bool IsUnderPressure() const { return underPressure != 0; }
+    void SetPressureThreshold(int percent) { InterlockedExchange(&pressureThreshold, percent); }
+    void ConfigureReclaimable(bool enabled) { reclaimableFiller = enabled; }
+    void ConfigureNuma(const std::string& mode, const std::string& nodes);
     MemoryWorkerStats GetStats() const;
+    // 工作线程的累计 CPU 时间（100ns），扣除已按控制面开销统计的驻留查询
+    LONGLONG GetThreadCpuTime() const;
 
 private:
     static DWORD WINAPI WorkerThreadProc(LPVOID lpParam);
+    static DWORD WINAPI PressureThreadProc(LPVOID lpParam);
     void WorkerLoop();
+    void PressureLoop();
+    void HandleEmergencyRelease();
+    bool PauseWorker(DWORD ms);
+    bool IsPollingPressureHigh() const;
     void AllocateMemory(int64_t sizeBytes);
-    void FreeMemory(int64_t sizeBytes);
+    void FirstTouchPages(void* chunk, size_t sizeBytes);
+    int64_t FreeMemory(int64_t sizeBytes, bool immediate = false);
     void CalculateOptimalParameters();
+    int PickNumaNode();
     void RefreshAllocatedPages(DWORD nowTick);
+    int64_t TouchRange(char* base, size_t beginOffset, size_t endOffset,
+                       size_t strideBytes, DWORD nowTick, bool streaming);
+    void MarkReclaimable(void* base, size_t beginOffset, size_t endOffset);
+    int64_t RefreshReclaimableRange(char* base, size_t beginOffset, size_t endOffset,
+                                    size_t strideBytes, DWORD nowTick, bool allowRepopulate,
+                                    int64_t& reclaimedPages, int64_t& repopulatedPages);
+    bool IsPressureHigh() const;
     void UpdateResidentStats();
-    int64_t CalculateResidentBytesLocked(bool& approximate) const;
+    bool CalculateResidentBytesExact(int64_t& residentBytes, bool& approximate) const;
+    bool SampleResidency(int& residentCount, int& sampleCount);
+    uint64_t NextRandom();
     int64_t PickRandomTargetBytes(int64_t maxAllowedBytes, DWORD nowTick);
     DWORD PickNextRandomTick(DWORD nowTick) const;
 };
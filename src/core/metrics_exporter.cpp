@@ -0,0 +1,297 @@
+#include "metrics_exporter.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+namespace {
+
+void AppendFormat(std::string& out, const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0) out.append(buffer, length < (int)sizeof(buffer) ? length : (int)sizeof(buffer) - 1);
+}
+
+void AppendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    AppendFormat(out, "# HELP %s %s\n", name, help);
+    AppendFormat(out, "# TYPE %s %s\n", name, type);
+}
+
+bool SendAll(SOCKET client, const char* data, size_t length) {
+    while (length > 0) {
+        int sent = send(client, data, (int)length, 0);
+        if (sent <= 0) return false;
+        data += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+void SendResponse(SOCKET client, const char* status, const std::string& body) {
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.0 %s\r\n"
+                          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                          "Content-Length: %u\r\n"
+                          "Connection: close\r\n\r\n",
+                          status, (unsigned)body.size());
+    if (length <= 0) return;
+    if (SendAll(client, header, length)) {
+        SendAll(client, body.data(), body.size());
+    }
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter()
+    : running(0), serverThread(NULL), listenSocket(INVALID_SOCKET), winsockReady(false),
+      port(0), scrapes(0) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    Stop();
+}
+
+bool MetricsExporter::Start(const std::string& bind, int listenPort) {
+    if (running) return true;
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return false;
+    winsockReady = true;
+
+    bindAddress = bind;
+    port = listenPort;
+
+    sockaddr_in address;
+    ZeroMemory(&address, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)listenPort);
+    address.sin_addr.s_addr = inet_addr(bind.c_str());
+    if (address.sin_addr.s_addr == INADDR_NONE && bind != "255.255.255.255") {
+        // 不是数字地址时按主机名解析（如 localhost），取第一个 IPv4 地址；
+        // gethostbyname 在所有目标系统上都可用
+        hostent* host = gethostbyname(bind.c_str());
+        if (!host || host->h_addrtype != AF_INET || !host->h_addr_list[0]) {
+            Stop();
+            return false;
+        }
+        memcpy(&address.sin_addr, host->h_addr_list[0], sizeof(address.sin_addr));
+    }
+
+    listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket == INVALID_SOCKET ||
+        ::bind(listenSocket, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        listen(listenSocket, SOMAXCONN) == SOCKET_ERROR) {
+        Stop();
+        return false;
+    }
+
+    InterlockedExchange(&running, 1);
+    serverThread = CreateThread(NULL, 0, ServerThreadProc, this, 0, NULL);
+    if (!serverThread) {
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter::Stop() {
+    InterlockedExchange(&running, 0);
+
+    if (serverThread) {
+        WaitForSingleObject(serverThread, 5000);
+        CloseHandle(serverThread);
+        serverThread = NULL;
+    }
+    if (listenSocket != INVALID_SOCKET) {
+        closesocket(listenSocket);
+        listenSocket = INVALID_SOCKET;
+    }
+    if (winsockReady) {
+        WSACleanup();
+        winsockReady = false;
+    }
+}
+
+DWORD WINAPI MetricsExporter::ServerThreadProc(LPVOID lpParam) {
+    MetricsExporter* self = (MetricsExporter*)lpParam;
+    self->ServerLoop();
+    return 0;
+}
+
+void MetricsExporter::ServerLoop() {
+    std::vector<MetricsConnection> connections;
+    while (running) {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        // 连接数已满时暂不接受新连接，留在监听队列里等待
+        if (connections.size() < METRICS_MAX_CONNECTIONS) FD_SET(listenSocket, &readSet);
+        for (size_t i = 0; i < connections.size(); ++i) {
+            FD_SET(connections[i].socket, &readSet);
+        }
+        timeval timeout = { 0, 200 * 1000 };
+        int ready = select(0, &readSet, NULL, NULL, &timeout);
+
+        DWORD now = GetTickCount();
+        if (ready > 0 && FD_ISSET(listenSocket, &readSet)) {
+            SOCKET client = accept(listenSocket, NULL, NULL);
+            if (client != INVALID_SOCKET) {
+                // 发送同样限时，不读取响应的客户端最多占用线程 1 秒
+                DWORD sendTimeout = 1000;
+                setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char*)&sendTimeout, sizeof(sendTimeout));
+                MetricsConnection connection;
+                connection.socket = client;
+                connection.deadline = now + METRICS_REQUEST_TIMEOUT_MS;
+                connection.received = 0;
+                connection.request[0] = '\0';
+                connections.push_back(connection);
+            }
+        }
+
+        for (size_t i = 0; i < connections.size();) {
+            MetricsConnection& connection = connections[i];
+            bool done = false;
+            if (ready > 0 && FD_ISSET(connection.socket, &readSet)) {
+                done = ReadClient(connection);
+            }
+            // 超过总时限仍未读完请求头的连接直接关闭，不再等待
+            if (!done && (LONG)(now - connection.deadline) >= 0) done = true;
+            if (done) {
+                closesocket(connection.socket);
+                connections.erase(connections.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+    }
+    for (size_t i = 0; i < connections.size(); ++i) {
+        closesocket(connections[i].socket);
+    }
+}
+
+bool MetricsExporter::ReadClient(MetricsConnection& connection) {
+    OverheadScope overhead(OVERHEAD_EXPORT);
+    // select 报告可读，recv 不会阻塞
+    int capacity = (int)sizeof(connection.request) - 1 - connection.received;
+    int count = recv(connection.socket, connection.request + connection.received, capacity, 0);
+    if (count <= 0) return true;
+    connection.received += count;
+    connection.request[connection.received] = '\0';
+
+    // 只需要请求行和头部；缓冲区写满时按已收到的内容处理
+    if (!strstr(connection.request, "\r\n\r\n") && !strstr(connection.request, "\n\n") &&
+        connection.received < (int)sizeof(connection.request) - 1) {
+        return false;
+    }
+    ServeClient(connection.socket, connection.request);
+    return true;
+}
+
+void MetricsExporter::ServeClient(SOCKET client, const char* request) {
+    // 路径必须正好是 /metrics 或 /（允许带查询串），/metricsfoo 之类返回 404
+    bool metricsPath = strncmp(request, "GET /metrics", 12) == 0 &&
+                       (request[12] == ' ' || request[12] == '?');
+    bool rootPath = strncmp(request, "GET /", 5) == 0 && (request[5] == ' ' || request[5] == '?');
+    if (!metricsPath && !rootPath) {
+        SendResponse(client, "404 Not Found", "not found\n");
+        return;
+    }
+
+    MetricsSnapshot snapshot;
+    bool ok = false;
+    for (int attempt = 0; attempt < 3 && !ok; ++attempt) {
+        ok = snapshots.ReadLatest(snapshot);
+        if (!ok) Sleep(1);
+    }
+    if (!ok) {
+        SendResponse(client, "503 Service Unavailable", "no snapshot yet\n");
+        return;
+    }
+
+    InterlockedIncrement(&scrapes);
+    SendResponse(client, "200 OK", Render(snapshot));
+}
+
+std::string MetricsExporter::Render(const MetricsSnapshot& s) const {
+    std::string out;
+    out.reserve(8192);
+
+    AppendHeader(out, "mikaboom_uptime_seconds", "gauge", "Seconds since MikaBooM started.");
+    AppendFormat(out, "mikaboom_uptime_seconds %.1f\n", s.uptimeSec);
+    AppendHeader(out, "mikaboom_snapshot_age_seconds", "gauge", "Age of the served controller snapshot.");
+    AppendFormat(out, "mikaboom_snapshot_age_seconds %.3f\n", (GetTickCount() - s.tick) / 1000.0);
+    AppendHeader(out, "mikaboom_scrapes_total", "counter", "Successful metrics scrapes.");
+    AppendFormat(out, "mikaboom_scrapes_total %ld\n", (long)scrapes);
+
+    AppendHeader(out, "mikaboom_cpu_usage_percent", "gauge", "CPU usage by source (other is the filtered estimate).");
+    AppendFormat(out, "mikaboom_cpu_usage_percent{kind=\"total\"} %.2f\n", s.cpuTotal);
+    AppendFormat(out, "mikaboom_cpu_usage_percent{kind=\"other\"} %.2f\n", s.cpuOther);
+    AppendFormat(out, "mikaboom_cpu_usage_percent{kind=\"worker\"} %.2f\n", s.cpuWorker);
+    AppendHeader(out, "mikaboom_cpu_core_usage_percent", "gauge", "Per logical processor CPU usage.");
+    for (int i = 0; i < s.coreCount && i < METRICS_MAX_CORES; ++i) {
+        AppendFormat(out, "mikaboom_cpu_core_usage_percent{core=\"%d\"} %.2f\n", i, s.coreUsage[i]);
+    }
+    AppendHeader(out, "mikaboom_cpu_threshold_percent", "gauge", "Configured CPU threshold.");
+    AppendFormat(out, "mikaboom_cpu_threshold_percent %d\n", s.cpuThreshold);
+    AppendHeader(out, "mikaboom_cpu_intensity", "gauge", "CPU worker duty-cycle intensity.");
+    AppendFormat(out, "mikaboom_cpu_intensity %d\n", s.cpuIntensity);
+
+    AppendHeader(out, "mikaboom_memory_usage_percent", "gauge", "Memory usage by source (other is the filtered estimate).");
+    AppendFormat(out, "mikaboom_memory_usage_percent{kind=\"total\"} %.2f\n", s.memTotal);
+    AppendFormat(out, "mikaboom_memory_usage_percent{kind=\"other\"} %.2f\n", s.memOther);
+    AppendFormat(out, "mikaboom_memory_usage_percent{kind=\"worker\"} %.2f\n", s.memWorker);
+    AppendHeader(out, "mikaboom_memory_threshold_percent", "gauge", "Configured memory threshold.");
+    AppendFormat(out, "mikaboom_memory_threshold_percent %d\n", s.memThreshold);
+    AppendHeader(out, "mikaboom_memory_bytes", "gauge", "Memory worker sizes.");
+    AppendFormat(out, "mikaboom_memory_bytes{kind=\"allocated\"} %lld\n", (long long)s.allocatedBytes);
+    AppendFormat(out, "mikaboom_memory_bytes{kind=\"resident\"} %lld\n", (long long)s.residentBytes);
+    AppendFormat(out, "mikaboom_memory_bytes{kind=\"target\"} %lld\n", (long long)s.targetBytes);
+    AppendFormat(out, "mikaboom_memory_bytes{kind=\"committed\"} %lld\n", (long long)s.committedBytes);
+    AppendFormat(out, "mikaboom_memory_bytes{kind=\"reclaimed\"} %lld\n", (long long)s.reclaimedBytes);
+    AppendHeader(out, "mikaboom_memory_blocks", "gauge", "Allocated memory blocks.");
+    AppendFormat(out, "mikaboom_memory_blocks %lld\n", (long long)s.blockCount);
+    AppendHeader(out, "mikaboom_memory_refresh_bytes_per_second", "gauge", "Page refresh rate.");
+    AppendFormat(out, "mikaboom_memory_refresh_bytes_per_second %lld\n", (long long)s.refreshBytesPerSec);
+    AppendHeader(out, "mikaboom_memory_refresh_pages_per_second", "gauge", "Page refresh rate in pages.");
+    AppendFormat(out, "mikaboom_memory_refresh_pages_per_second %lld\n", (long long)s.refreshPagesPerSec);
+    AppendHeader(out, "mikaboom_memory_refresh_ns_per_page", "gauge", "Page refresh cost.");
+    AppendFormat(out, "mikaboom_memory_refresh_ns_per_page %.1f\n", s.refreshNsPerPage);
+    AppendHeader(out, "mikaboom_memory_emergency_releases_total", "counter", "Memory pressure emergency releases.");
+    AppendFormat(out, "mikaboom_memory_emergency_releases_total %ld\n", s.emergencyReleases);
+
+    AppendHeader(out, "mikaboom_worker_active", "gauge", "Controller gate state (1 = filling).");
+    AppendFormat(out, "mikaboom_worker_active{resource=\"cpu\"} %d\n", s.cpuActive ? 1 : 0);
+    AppendFormat(out, "mikaboom_worker_active{resource=\"memory\"} %d\n", s.memActive ? 1 : 0);
+    AppendHeader(out, "mikaboom_worker_running", "gauge", "Worker running state.");
+    AppendFormat(out, "mikaboom_worker_running{resource=\"cpu\"} %d\n", s.cpuRunning ? 1 : 0);
+    AppendFormat(out, "mikaboom_worker_running{resource=\"memory\"} %d\n", s.memRunning ? 1 : 0);
+    AppendHeader(out, "mikaboom_worker_starts_total", "counter", "Worker starts issued by the controller.");
+    AppendFormat(out, "mikaboom_worker_starts_total{resource=\"cpu\"} %d\n", s.cpuStarts);
+    AppendFormat(out, "mikaboom_worker_starts_total{resource=\"memory\"} %d\n", s.memStarts);
+    AppendHeader(out, "mikaboom_worker_stops_total", "counter", "Worker stops issued by the controller.");
+    AppendFormat(out, "mikaboom_worker_stops_total{resource=\"cpu\"} %d\n", s.cpuStops);
+    AppendFormat(out, "mikaboom_worker_stops_total{resource=\"memory\"} %d\n", s.memStops);
+    AppendHeader(out, "mikaboom_controller_error_percent", "gauge", "Total usage minus max(threshold, other).");
+    AppendFormat(out, "mikaboom_controller_error_percent{resource=\"cpu\"} %.2f\n", s.cpuError);
+    AppendFormat(out, "mikaboom_controller_error_percent{resource=\"memory\"} %.2f\n", s.memError);
+
+    AppendHeader(out, "mikaboom_loop_wakeups_per_second", "gauge", "Control loop wakeups.");
+    AppendFormat(out, "mikaboom_loop_wakeups_per_second %.2f\n", s.loopWakeupsPerSec);
+
+    AppendHeader(out, "mikaboom_overhead_core_percent", "gauge", "Control-plane CPU time as percent of one core, by subsystem.");
+    for (int i = 0; i < OVERHEAD_SUBSYSTEM_COUNT; ++i) {
+        AppendFormat(out, "mikaboom_overhead_core_percent{subsystem=\"%s\"} %.3f\n",
+                     OverheadMeter::GetSubsystemName(i), s.overheadCore[i]);
+    }
+    AppendHeader(out, "mikaboom_overhead_core_average_percent", "gauge", "Smoothed control-plane CPU compared against the budget.");
+    AppendFormat(out, "mikaboom_overhead_core_average_percent %.3f\n", s.overheadCoreAverage);
+    AppendHeader(out, "mikaboom_overhead_budget_percent", "gauge", "Configured control-plane budget (percent of one core, 0 = off).");
+    AppendFormat(out, "mikaboom_overhead_budget_percent %d\n", s.overheadBudget);
+    AppendHeader(out, "mikaboom_overhead_over_budget", "gauge", "1 while the control plane exceeds its budget.");
+    AppendFormat(out, "mikaboom_overhead_over_budget %d\n", s.overheadOverBudget ? 1 : 0);
+    AppendHeader(out, "mikaboom_overhead_rss_bytes", "gauge", "Process working set excluding the memory worker's resident filler.");
+    AppendFormat(out, "mikaboom_overhead_rss_bytes %lld\n", (long long)s.overheadRssBytes);
+    return out;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "sample_ring.h"
+#include "overhead_meter.h"
+
+#define METRICS_MAX_CORES 64
+#define METRICS_MAX_CONNECTIONS 16     // 同时保持的抓取连接数，受 select 的 FD_SETSIZE 限制
+#define METRICS_REQUEST_TIMEOUT_MS 2000 // 从接受连接到读完请求头的总时限
+
+// 控制线程每轮发布的一份状态快照，导出线程只读快照，不触碰工作线程的锁
+struct MetricsSnapshot {
+    DWORD tick;
+    double uptimeSec;
+
+    double cpuTotal;
+    double cpuOther;
+    double cpuWorker;
+    double cpuError;       // 总占用相对 max(阈值, 其他程序占用) 的偏差
+    int cpuThreshold;
+    int cpuIntensity;
+    bool cpuActive;
+    bool cpuRunning;
+    int cpuStarts;
+    int cpuStops;
+    int coreCount;
+    double coreUsage[METRICS_MAX_CORES];
+
+    double memTotal;
+    double memOther;
+    double memWorker;
+    double memError;
+    int memThreshold;
+    bool memActive;
+    bool memRunning;
+    int memStarts;
+    int memStops;
+
+    int64_t allocatedBytes;
+    int64_t residentBytes;
+    int64_t targetBytes;
+    int64_t committedBytes;
+    int64_t reclaimedBytes;
+    int64_t blockCount;
+    int64_t refreshBytesPerSec;
+    int64_t refreshPagesPerSec;
+    double refreshNsPerPage;
+    long emergencyReleases;
+
+    double loopWakeupsPerSec;
+
+    double overheadCore[OVERHEAD_SUBSYSTEM_COUNT];  // 控制面各子系统占单个核心的百分比
+    double overheadCoreAverage;
+    int overheadBudget;
+    bool overheadOverBudget;
+    int64_t overheadRssBytes;
+};
+
+// 一个尚未读完请求头的抓取连接
+struct MetricsConnection {
+    SOCKET socket;
+    DWORD deadline;
+    int received;
+    char request[1024];
+};
+
+// Prometheus 文本格式导出：独立线程监听 bind:port，GET /metrics 返回最近一次快照。
+// 监听套接字和各连接在同一个 select 里多路复用，每个连接有总时限，
+// 慢速或空闲的客户端不会挡住其他抓取
+class MetricsExporter {
+private:
+    volatile LONG running;
+    HANDLE serverThread;
+    SOCKET listenSocket;
+    bool winsockReady;
+    std::string bindAddress;
+    int port;
+    SampleRing<MetricsSnapshot, 4> snapshots;
+    volatile LONG scrapes;
+
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    bool Start(const std::string& bind, int listenPort);
+    void Stop();
+    bool IsRunning() const { return running != 0; }
+
+    // 仅控制线程调用
+    void Publish(const MetricsSnapshot& snapshot) { snapshots.Publish(snapshot); }
+
+    const std::string& GetBindAddress() const { return bindAddress; }
+    int GetPort() const { return port; }
+    LONG GetScrapeCount() const { return scrapes; }
+
+private:
+    static DWORD WINAPI ServerThreadProc(LPVOID lpParam);
+    void ServerLoop();
+    // 读取已就绪连接上的数据，返回 true 表示连接已处理完毕可以关闭
+    bool ReadClient(MetricsConnection& connection);
+    void ServeClient(SOCKET client, const char* request);
+    std::string Render(const MetricsSnapshot& snapshot) const;
+};
@@ -0,0 +1,394 @@
+#include "micro_bench.h"
+#include "cpu_worker.h"
+#include "memory_worker.h"
+#include "resource_monitor.h"
+#include "ema_filter.h"
+#include "pid_controller.h"
+#include "../platform/system_compat.h"
+#include "../utils/version.h"
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+namespace {
+
+double NowSeconds() {
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)frequency.QuadPart;
+}
+
+// 先倍增批量直到单批超过 50ms，再重复 5 批取中位数，返回每次调用的纳秒数
+template <typename Op>
+double MeasureNsPerOp(Op& op, long long& iterations) {
+    long long batch = 1;
+    for (;;) {
+        double begin = NowSeconds();
+        for (long long i = 0; i < batch; ++i) op();
+        if (NowSeconds() - begin >= 0.05 || batch >= (1LL << 30)) break;
+        batch *= 2;
+    }
+
+    double trials[5];
+    for (int t = 0; t < 5; ++t) {
+        double begin = NowSeconds();
+        for (long long i = 0; i < batch; ++i) op();
+        trials[t] = (NowSeconds() - begin) * 1e9 / (double)batch;
+    }
+    std::sort(trials, trials + 5);
+    iterations = batch * 5;
+    return trials[2];
+}
+
+void AddResult(std::vector<MicroBenchResult>& results, const std::string& name,
+               const char* unit, double value, bool lowerIsBetter, long long iterations) {
+    MicroBenchResult result;
+    result.name = name;
+    result.unit = unit;
+    result.value = value;
+    result.lowerIsBetter = lowerIsBetter;
+    result.iterations = iterations;
+    results.push_back(result);
+    printf("  %-36s %14.3f %s\n", name.c_str(), value, unit);
+}
+
+double ThreadCpuSeconds(HANDLE thread) {
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetThreadTimes(thread, &creation, &exitTime, &kernel, &user)) return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 10000000.0;
+}
+
+std::string Format(const char* pattern, int value) {
+    char buffer[64];
+    sprintf_s(buffer, sizeof(buffer), pattern, value);
+    return buffer;
+}
+
+struct EmaOp {
+    EMAFilter filter;
+    double input;
+    volatile double sink;
+    EmaOp() : filter(0.3), input(0), sink(0) {}
+    void operator()() {
+        input = input > 100 ? 0 : input + 0.7;
+        sink = filter.Update(input);
+    }
+};
+
+struct PidOp {
+    PIDController pid;
+    double input;
+    volatile double sink;
+    PidOp() : pid(0.5, 0.1, 0.05), input(0), sink(0) { pid.SetTarget(50); }
+    void operator()() {
+        input = input > 100 ? 0 : input + 0.7;
+        sink = pid.Compute(input, 0.5);
+    }
+};
+
+struct CpuRawOp {
+    ResourceMonitor* monitor;
+    volatile double sink;
+    void operator()() { sink = monitor->GetCPUUsageRaw(); }
+};
+
+struct MemRawOp {
+    ResourceMonitor* monitor;
+    volatile double sink;
+    void operator()() { sink = monitor->GetMemoryUsageRaw(); }
+};
+
+// DoWork 是私有函数，由友元类取得函数指针后交给计时循环调用
+struct DoWorkOp {
+    void (*invoke)(CPUWorker*, int);
+    CPUWorker* worker;
+    int level;
+    void operator()() { invoke(worker, level); }
+};
+
+struct AllocatedSizeOp {
+    MemoryWorker* worker;
+    volatile long long sink;
+    void operator()() { sink = worker->GetAllocatedSize(); }
+};
+
+} // namespace
+
+void MicroBenchmark::InvokeDoWork(CPUWorker* worker, int level) {
+    worker->DoWork(level);
+}
+
+void MicroBenchmark::BenchDoWork(std::vector<MicroBenchResult>& results) {
+    CPUWorker worker(0);
+    for (int level = 0; level <= 100; level += 25) {
+        DoWorkOp op = { InvokeDoWork, &worker, level };
+        long long iterations = 0;
+        double ns = MeasureNsPerOp(op, iterations);
+        AddResult(results, Format("cpu_dowork_level_%d", level), "ns/op", ns, true, iterations);
+    }
+}
+
+// 在单个线程上运行真实的 WorkerThread，用线程 CPU 时间与墙钟时间之比衡量实际占空比
+void MicroBenchmark::BenchDutyCycle(std::vector<MicroBenchResult>& results) {
+    for (int level = 10; level <= 90; level += 20) {
+        CPUWorker worker(0);
+        InterlockedExchange(&worker.intensity, level);
+        InterlockedExchange(&worker.running, 1);
+
+        HANDLE thread = CreateThread(NULL, 0, CPUWorker::WorkerThreadProc, &worker, 0, NULL);
+        if (!thread) {
+            InterlockedExchange(&worker.running, 0);
+            continue;
+        }
+
+        // 跳过线程启动时的随机延迟
+        Sleep(300);
+        double cpuBegin = ThreadCpuSeconds(thread);
+        double wallBegin = NowSeconds();
+        Sleep(2000);
+        double cpuEnd = ThreadCpuSeconds(thread);
+        double wallEnd = NowSeconds();
+
+        InterlockedExchange(&worker.running, 0);
+        WaitForSingleObject(thread, 5000);
+        CloseHandle(thread);
+
+        double duty = (cpuEnd - cpuBegin) / (wallEnd - wallBegin) * 100.0;
+        AddResult(results, Format("cpu_duty_overshoot_level_%d", level), "pct",
+                  duty - level, true, 1);
+    }
+}
+
+void MicroBenchmark::BenchMemory(std::vector<MicroBenchResult>& results, int memoryMB) {
+    const int64_t blockBytes = 64LL * 1024 * 1024;
+    int blocks = memoryMB / 64;
+    if (blocks < 1) blocks = 1;
+    double regionGB = blocks * (double)blockBytes / (1024.0 * 1024.0 * 1024.0);
+
+    MemoryStatusSnapshot memory;
+    SystemCompat::QueryMemoryStatus(memory);
+    MemoryWorker worker(0, memory.totalPhys);
+
+    // 首次触页吞吐：与 AllocateMemory 相同的逐页写入
+    double touchSeconds = 0;
+    for (int i = 0; i < blocks; ++i) {
+        void* chunk = VirtualAlloc(NULL, (SIZE_T)blockBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!chunk) break;
+        double begin = NowSeconds();
+        worker.FirstTouchPages(chunk, (size_t)blockBytes);
+        touchSeconds += NowSeconds() - begin;
+        worker.allocatedMemory.push_back(MemoryBlockInfo(chunk, blockBytes, GetTickCount()));
+    }
+    if (worker.allocatedMemory.empty()) {
+        printf("  memory benchmarks skipped: allocation failed\n");
+        return;
+    }
+    blocks = (int)worker.allocatedMemory.size();
+    regionGB = blocks * (double)blockBytes / (1024.0 * 1024.0 * 1024.0);
+    AddResult(results, "mem_first_touch", "MB/s",
+              touchSeconds > 0 ? blocks * 64.0 / touchSeconds : 0, false, blocks);
+
+    // 页面刷新：不限预算、无延迟，每轮从头刷新整个区域
+    InterlockedExchange(&worker.running, 1);
+    worker.refreshEnabled = true;
+    worker.refreshAfterSec = 0;
+    worker.refreshIntervalSec = 0;
+    worker.refreshBudgetMBps = 0;
+    worker.refreshBudgetPagesPerSec = 0;
+    worker.totalMemoryBytes = memory.totalPhys > (uint64_t)blocks * blockBytes
+                              ? memory.totalPhys : (uint64_t)blocks * blockBytes * 2;
+
+    double refreshTrials[5];
+    for (int t = 0; t < 5; ++t) {
+        worker.lastRefreshTick = 0;
+        worker.refreshTokens = 0;
+        worker.refreshCursor = 0;
+        worker.refreshOffset = 0;
+        double begin = NowSeconds();
+        worker.RefreshAllocatedPages(GetTickCount());
+        refreshTrials[t] = (NowSeconds() - begin) * 1000.0 / regionGB;
+    }
+    std::sort(refreshTrials, refreshTrials + 5);
+    AddResult(results, "mem_refresh_per_gb", "ms", refreshTrials[2], true, 5);
+
+    // 驻留查询：逐页精确查询整个区域
+    double queryTrials[5];
+    size_t pageSize = SystemCompat::GetPageSize();
+    for (int t = 0; t < 5; ++t) {
+        double begin = NowSeconds();
+        for (int i = 0; i < blocks; ++i) {
+            uint64_t resident = 0;
+            bool approximate = false;
+            SystemCompat::QueryRegionResidentBytes(worker.allocatedMemory[i].ptr, (size_t)blockBytes,
+                                                   pageSize, resident, approximate);
+        }
+        queryTrials[t] = (NowSeconds() - begin) * 1000.0 / regionGB;
+    }
+    std::sort(queryTrials, queryTrials + 5);
+    AddResult(results, "mem_query_resident_per_gb", "ms", queryTrials[2], true, 5);
+
+    // Stop 会释放全部块
+    worker.Stop();
+}
+
+void MicroBenchmark::BenchAllocatedSize(std::vector<MicroBenchResult>& results) {
+    MemoryWorker worker(0, 0);
+    worker.allocatedMemory.reserve(10000);
+    for (int i = 0; i < 10000; ++i) {
+        worker.allocatedMemory.push_back(MemoryBlockInfo(NULL, 10LL * 1024 * 1024, 0));
+    }
+
+    AllocatedSizeOp op = { &worker, 0 };
+    long long iterations = 0;
+    double ns = MeasureNsPerOp(op, iterations);
+    AddResult(results, "mem_get_allocated_size_10k_blocks", "ns/op", ns, true, iterations);
+    worker.allocatedMemory.clear();
+}
+
+void MicroBenchmark::BenchFilters(std::vector<MicroBenchResult>& results) {
+    long long iterations = 0;
+    EmaOp ema;
+    double ns = MeasureNsPerOp(ema, iterations);
+    AddResult(results, "ema_filter_update", "ns/op", ns, true, iterations);
+
+    PidOp pid;
+    ns = MeasureNsPerOp(pid, iterations);
+    AddResult(results, "pid_controller_compute", "ns/op", ns, true, iterations);
+}
+
+void MicroBenchmark::BenchMonitor(std::vector<MicroBenchResult>& results) {
+    ResourceMonitor monitor;
+    long long iterations = 0;
+
+    CpuRawOp cpu = { &monitor, 0 };
+    double ns = MeasureNsPerOp(cpu, iterations);
+    AddResult(results, "monitor_cpu_sample", "ns/op", ns, true, iterations);
+
+    MemRawOp mem = { &monitor, 0 };
+    ns = MeasureNsPerOp(mem, iterations);
+    AddResult(results, "monitor_memory_sample", "ns/op", ns, true, iterations);
+}
+
+bool MicroBenchmark::WriteResults(const std::string& path, const std::vector<MicroBenchResult>& results) {
+    FILE* file = NULL;
+    if (fopen_s(&file, path.c_str(), "w") != 0 || !file) return false;
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    fprintf(file, "{\n");
+    fprintf(file, "  \"version\": \"%s\",\n", Version::GetVersion());
+    fprintf(file, "  \"processors\": %lu,\n", (unsigned long)info.dwNumberOfProcessors);
+    fprintf(file, "  \"results\": [\n");
+    // 每行一个用例，基线对比按行解析
+    for (size_t i = 0; i < results.size(); ++i) {
+        const MicroBenchResult& r = results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.6f, \"lower_is_better\": %s, \"iterations\": %lld}%s\n",
+                r.name.c_str(), r.unit.c_str(), r.value, r.lowerIsBetter ? "true" : "false",
+                r.iterations, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+    fclose(file);
+    return true;
+}
+
+bool MicroBenchmark::LoadBaseline(const std::string& path, std::vector<MicroBenchResult>& baseline) {
+    FILE* file = NULL;
+    if (fopen_s(&file, path.c_str(), "r") != 0 || !file) return false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        const char* name = strstr(line, "\"name\": \"");
+        const char* value = strstr(line, "\"value\": ");
+        if (!name || !value) continue;
+
+        name += 9;
+        const char* end = strchr(name, '"');
+        if (!end) continue;
+
+        MicroBenchResult result;
+        result.name.assign(name, end - name);
+        result.value = atof(value + 9);
+        result.lowerIsBetter = strstr(line, "\"lower_is_better\": false") == NULL;
+        baseline.push_back(result);
+    }
+    fclose(file);
+    return !baseline.empty();
+}
+
+int MicroBenchmark::Run(const MicroBenchOptions& options) {
+    std::vector<MicroBenchResult> results;
+    printf("Microbenchmarks (%s)\n", Version::GetVersion());
+
+    // 基准期间提高优先级，减少调度噪声
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+    BenchDoWork(results);
+    BenchDutyCycle(results);
+    BenchMemory(results, options.memoryMB);
+    BenchAllocatedSize(results);
+    BenchFilters(results);
+    BenchMonitor(results);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
+
+    if (!WriteResults(options.outputPath, results)) {
+        printf("Failed to write results: %s\n", options.outputPath.c_str());
+        return 1;
+    }
+    printf("Results written to %s\n", options.outputPath.c_str());
+
+    if (options.baselinePath.empty()) return 0;
+
+    std::vector<MicroBenchResult> baseline;
+    if (!LoadBaseline(options.baselinePath, baseline)) {
+        printf("Failed to load baseline: %s\n", options.baselinePath.c_str());
+        return 1;
+    }
+
+    // 占空比偏差本身接近 0，按绝对值的百分点比较；其余按相对变化比较
+    int regressions = 0;
+    printf("\nComparison with %s (tolerance %.1f%%)\n", options.baselinePath.c_str(), options.tolerancePercent);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const MicroBenchResult& current = results[i];
+        const MicroBenchResult* base = NULL;
+        for (size_t j = 0; j < baseline.size(); ++j) {
+            if (baseline[j].name == current.name) {
+                base = &baseline[j];
+                break;
+            }
+        }
+        if (!base) {
+            printf("  %-36s %14.3f  (new)\n", current.name.c_str(), current.value);
+            continue;
+        }
+
+        bool regressed;
+        double change;
+        if (current.unit == "pct") {
+            change = fabs(current.value) - fabs(base->value);
+            regressed = change > 2.0;
+            printf("  %-36s %14.3f  base %10.3f  %+7.2f pts", current.name.c_str(),
+                   current.value, base->value, change);
+        } else {
+            change = fabs(base->value) > 1e-12 ? (current.value - base->value) / fabs(base->value) * 100.0 : 0;
+            regressed = current.lowerIsBetter ? change > options.tolerancePercent
+                                              : change < -options.tolerancePercent;
+            printf("  %-36s %14.3f  base %10.3f  %+7.2f%%", current.name.c_str(),
+                   current.value, base->value, change);
+        }
+        printf("%s\n", regressed ? "  REGRESSION" : "");
+        if (regressed) regressions++;
+    }
+
+    printf("%d regression(s)\n", regressions);
+    return regressions > 0 ? 2 : 0;
+}
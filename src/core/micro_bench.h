@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class CPUWorker;
+
+struct MicroBenchOptions {
+    std::string outputPath;     // JSON 结果
+    std::string baselinePath;   // 非空时与之前的结果对比
+    double tolerancePercent;    // 超过该比例的变差视为回退
+    int memoryMB;               // 内存相关用例使用的区域大小
+
+    MicroBenchOptions()
+        : outputPath("MikaBooM.bench.json"), tolerancePercent(10), memoryMB(512) {}
+};
+
+struct MicroBenchResult {
+    std::string name;
+    std::string unit;
+    double value;
+    bool lowerIsBetter;
+    long long iterations;
+
+    MicroBenchResult() : value(0), lowerIsBetter(true), iterations(0) {}
+};
+
+// 核心热点路径的微基准：不依赖外部框架，通过友元直接调用工作线程的内部函数。
+// 结果写成每行一个用例的 JSON，给出基线文件时逐项对比并在回退时返回 2
+class MicroBenchmark {
+public:
+    static int Run(const MicroBenchOptions& options);
+
+private:
+    static void InvokeDoWork(CPUWorker* worker, int level);
+    static void BenchDoWork(std::vector<MicroBenchResult>& results);
+    static void BenchDutyCycle(std::vector<MicroBenchResult>& results);
+    static void BenchMemory(std::vector<MicroBenchResult>& results, int memoryMB);
+    static void BenchAllocatedSize(std::vector<MicroBenchResult>& results);
+    static void BenchFilters(std::vector<MicroBenchResult>& results);
+    static void BenchMonitor(std::vector<MicroBenchResult>& results);
+
+    static bool WriteResults(const std::string& path, const std::vector<MicroBenchResult>& results);
+    static bool LoadBaseline(const std::string& path, std::vector<MicroBenchResult>& baseline);
+};
@@ -0,0 +1,502 @@
+#include "network_worker.h"
+#include "../utils/anti_detect.h"
+#include "overhead_meter.h"
+#include <mswsock.h>
+#include <iphlpapi.h>
+#include <stdlib.h>
+
+// 每次发送的最小/最大块，最小块保证小速率下也不会退化成大量小包
+#define NETWORK_MIN_CHUNK_BYTES (64 * 1024)
+#define NETWORK_PAYLOAD_BYTES (1024 * 1024)
+// 连接超时；发送超时限定对端停止接收时单次 send 的阻塞时间
+#define NETWORK_CONNECT_TIMEOUT_MS 5000
+#define NETWORK_SEND_TIMEOUT_MS 2000
+
+typedef BOOL (PASCAL *PTransmitFile)(SOCKET, HANDLE, DWORD, DWORD, LPOVERLAPPED,
+                                     LPTRANSMIT_FILE_BUFFERS, DWORD);
+
+NetworkWorker::NetworkWorker()
+    : running(0), senderThread(NULL), sinkThread(NULL), stopEvent(NULL), winsockReady(false),
+      targetMbps(100), subtractOther(true), localSink(true),
+      listenSocket(INVALID_SOCKET), sinkPort(0), senderSocket(INVALID_SOCKET),
+      sendRateKBps(0), sentKB(0), connected(0), zeroCopy(false), totalBytes(0),
+      hIphlpapi(NULL), pGetIfTable(NULL), lastSampleTick(0),
+      currentMbps(0), otherMbps(0), sendMbps(0) {
+    InitializeCriticalSection(&statsLock);
+    InitializeCriticalSection(&socketLock);
+    stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    // GetIfTable 在 Windows 2000 上即可用；GetIfTable2 的 64 位计数器要 Vista，
+    // 这里每秒采样一次，32 位计数器回绕可以按差值处理
+    hIphlpapi = LoadLibraryA("iphlpapi.dll");
+    if (hIphlpapi) {
+        pGetIfTable = (PGetIfTable)GetProcAddress(hIphlpapi, "GetIfTable");
+    }
+}
+
+NetworkWorker::~NetworkWorker() {
+    Stop();
+    if (hIphlpapi) FreeLibrary(hIphlpapi);
+    if (stopEvent) CloseHandle(stopEvent);
+    DeleteCriticalSection(&socketLock);
+    DeleteCriticalSection(&statsLock);
+}
+
+void NetworkWorker::Configure(const std::string& target, double mbps, bool subtractOtherTraffic) {
+    endpoint = target;
+    targetMbps = mbps < 0 ? 0 : mbps;
+    subtractOther = subtractOtherTraffic;
+    localSink = endpoint.empty();
+}
+
+void NetworkWorker::Start() {
+    if (InterlockedCompareExchange(&running, 1, 0) != 0) return;
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        InterlockedExchange(&running, 0);
+        return;
+    }
+    winsockReady = true;
+
+    ResetEvent(stopEvent);
+    InterlockedExchange(&sentKB, 0);
+    InterlockedExchange(&connected, 0);
+    InterlockedExchange(&sendRateKBps, (LONG)(targetMbps * 1000000.0 / 8.0 / 1024.0));
+    lastIfOctets.clear();
+    lastSampleTick = GetTickCount();
+    uint64_t ignored = 0;
+    SampleInterfaceOctets(ignored);
+
+    if (localSink && !StartLocalSink()) {
+        WSACleanup();
+        winsockReady = false;
+        InterlockedExchange(&running, 0);
+        return;
+    }
+
+    RandomDelay(100, 300);
+
+    senderThread = CreateThread(NULL, 0, SenderThreadProc, this, 0, NULL);
+    if (senderThread) {
+        SetThreadPriority(senderThread, THREAD_PRIORITY_BELOW_NORMAL);
+    }
+}
+
+void NetworkWorker::Stop() {
+    if (InterlockedCompareExchange(&running, 0, 1) != 1) return;
+
+    SetEvent(stopEvent);
+
+    // 关闭监听套接字让 accept/select 立即返回
+    if (listenSocket != INVALID_SOCKET) {
+        closesocket(listenSocket);
+        listenSocket = INVALID_SOCKET;
+    }
+
+    // 同样关闭发送套接字，对端停止接收时阻塞的 send/TransmitFile 也会立即返回
+    EnterCriticalSection(&socketLock);
+    if (senderSocket != INVALID_SOCKET) {
+        closesocket(senderSocket);
+        senderSocket = INVALID_SOCKET;
+    }
+    LeaveCriticalSection(&socketLock);
+
+    // 两个线程都会很快退出；必须等它们结束后才能 WSACleanup，调用方随后会释放对象
+    if (senderThread) {
+        WaitForSingleObject(senderThread, INFINITE);
+        CloseHandle(senderThread);
+        senderThread = NULL;
+    }
+    if (sinkThread) {
+        WaitForSingleObject(sinkThread, INFINITE);
+        CloseHandle(sinkThread);
+        sinkThread = NULL;
+    }
+
+    if (winsockReady) {
+        WSACleanup();
+        winsockReady = false;
+    }
+    InterlockedExchange(&connected, 0);
+}
+
+bool NetworkWorker::StartLocalSink() {
+    listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket == INVALID_SOCKET) return false;
+
+    sockaddr_in address;
+    ZeroMemory(&address, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;  // 由系统分配端口
+
+    int length = sizeof(address);
+    if (bind(listenSocket, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        listen(listenSocket, 1) == SOCKET_ERROR ||
+        getsockname(listenSocket, (sockaddr*)&address, &length) == SOCKET_ERROR) {
+        closesocket(listenSocket);
+        listenSocket = INVALID_SOCKET;
+        return false;
+    }
+    sinkPort = ntohs(address.sin_port);
+
+    sinkThread = CreateThread(NULL, 0, SinkThreadProc, this, 0, NULL);
+    if (!sinkThread) {
+        closesocket(listenSocket);
+        listenSocket = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+}
+
+DWORD WINAPI NetworkWorker::SinkThreadProc(LPVOID lpParam) {
+    NetworkWorker* self = (NetworkWorker*)lpParam;
+    self->SinkLoop();
+    return 0;
+}
+
+void NetworkWorker::SinkLoop() {
+    std::vector<char> buffer(64 * 1024);
+
+    while (running) {
+        SOCKET listener = listenSocket;
+        if (listener == INVALID_SOCKET) break;
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(listener, &readSet);
+        timeval timeout = { 0, 200 * 1000 };
+        if (select(0, &readSet, NULL, NULL, &timeout) <= 0) continue;
+
+        SOCKET client = accept(listener, NULL, NULL);
+        if (client == INVALID_SOCKET) continue;
+
+        // 接收端只负责读走并丢弃数据
+        while (running) {
+            fd_set clientSet;
+            FD_ZERO(&clientSet);
+            FD_SET(client, &clientSet);
+            timeval wait = { 0, 200 * 1000 };
+            int ready = select(0, &clientSet, NULL, NULL, &wait);
+            if (ready < 0) break;
+            if (ready == 0) continue;
+
+            int received = recv(client, &buffer[0], (int)buffer.size(), 0);
+            if (received <= 0) break;
+        }
+        closesocket(client);
+    }
+}
+
+bool NetworkWorker::ResolveEndpoint(sockaddr_in& address) const {
+    ZeroMemory(&address, sizeof(address));
+    address.sin_family = AF_INET;
+
+    if (localSink) {
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(sinkPort);
+        return sinkPort != 0;
+    }
+
+    size_t colon = endpoint.rfind(':');
+    if (colon == std::string::npos || colon == 0) return false;
+    std::string host = endpoint.substr(0, colon);
+    int port = atoi(endpoint.c_str() + colon + 1);
+    if (port <= 0 || port > 65535) return false;
+    address.sin_port = htons((unsigned short)port);
+
+    // getaddrinfo 要 XP，这里沿用 Windows 2000 就有的 inet_addr/gethostbyname
+    unsigned long ip = inet_addr(host.c_str());
+    if (ip == 0xFFFFFFFF) {
+        hostent* entry = gethostbyname(host.c_str());
+        if (!entry || !entry->h_addr_list || !entry->h_addr_list[0]) return false;
+        memcpy(&ip, entry->h_addr_list[0], sizeof(ip));
+    }
+    address.sin_addr.s_addr = ip;
+    return true;
+}
+
+SOCKET NetworkWorker::OpenSenderSocket() {
+    SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == INVALID_SOCKET) return sock;
+
+    // 登记后 Stop 才能关闭它；Stop 已经开始时不再登记
+    EnterCriticalSection(&socketLock);
+    if (running) {
+        senderSocket = sock;
+    } else {
+        closesocket(sock);
+        sock = INVALID_SOCKET;
+    }
+    LeaveCriticalSection(&socketLock);
+    return sock;
+}
+
+bool NetworkWorker::ConnectSender(SOCKET sock, const sockaddr_in& address) {
+    // 非阻塞连接，每 100ms 检查一次停止事件，对端无响应时不会卡住发送线程
+    u_long nonBlocking = 1;
+    if (ioctlsocket(sock, FIONBIO, &nonBlocking) == SOCKET_ERROR) return false;
+
+    if (connect(sock, (const sockaddr*)&address, sizeof(address)) == SOCKET_ERROR) {
+        if (WSAGetLastError() != WSAEWOULDBLOCK) return false;
+
+        DWORD begin = GetTickCount();
+        while (true) {
+            if (WaitForSingleObject(stopEvent, 0) == WAIT_OBJECT_0) return false;
+            if (GetTickCount() - begin >= NETWORK_CONNECT_TIMEOUT_MS) return false;
+
+            // 连接成功时可写，失败时出现在异常集合中
+            fd_set writeSet;
+            fd_set errorSet;
+            FD_ZERO(&writeSet);
+            FD_ZERO(&errorSet);
+            FD_SET(sock, &writeSet);
+            FD_SET(sock, &errorSet);
+            timeval wait = { 0, 100 * 1000 };
+            int ready = select(0, NULL, &writeSet, &errorSet, &wait);
+            if (ready < 0 || FD_ISSET(sock, &errorSet)) return false;
+            if (ready > 0) break;
+        }
+    }
+
+    // 恢复阻塞模式发送，单次发送最多阻塞 NETWORK_SEND_TIMEOUT_MS
+    u_long blocking = 0;
+    if (ioctlsocket(sock, FIONBIO, &blocking) == SOCKET_ERROR) return false;
+    DWORD sendTimeout = NETWORK_SEND_TIMEOUT_MS;
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&sendTimeout, sizeof(sendTimeout));
+    return true;
+}
+
+void NetworkWorker::CloseSenderSocket(SOCKET& sock, bool graceful) {
+    if (sock == INVALID_SOCKET) return;
+    // Stop 已经关闭过时 senderSocket 不再是它，不能重复关闭
+    EnterCriticalSection(&socketLock);
+    if (senderSocket == sock) {
+        if (graceful) shutdown(sock, SD_BOTH);
+        closesocket(sock);
+        senderSocket = INVALID_SOCKET;
+    }
+    LeaveCriticalSection(&socketLock);
+    sock = INVALID_SOCKET;
+}
+
+HANDLE NetworkWorker::CreatePayloadFile(DWORD sizeBytes, std::vector<char>& payload) {
+    // 伪随机内容，避免链路上的压缩让实际流量偏低
+    payload.resize(sizeBytes);
+    uint32_t state = GetTickCount() | 1;
+    for (DWORD i = 0; i < sizeBytes; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        payload[i] = (char)state;
+    }
+
+    char tempDir[MAX_PATH];
+    char tempFile[MAX_PATH];
+    if (!GetTempPathA(MAX_PATH, tempDir) || !GetTempFileNameA(tempDir, "mkb", 0, tempFile)) {
+        return INVALID_HANDLE_VALUE;
+    }
+
+    HANDLE file = CreateFileA(tempFile, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE |
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        DeleteFileA(tempFile);
+        return INVALID_HANDLE_VALUE;
+    }
+
+    DWORD written = 0;
+    if (!WriteFile(file, &payload[0], sizeBytes, &written, NULL) || written != sizeBytes) {
+        CloseHandle(file);
+        return INVALID_HANDLE_VALUE;
+    }
+    return file;
+}
+
+DWORD WINAPI NetworkWorker::SenderThreadProc(LPVOID lpParam) {
+    NetworkWorker* self = (NetworkWorker*)lpParam;
+    self->SenderLoop();
+    return 0;
+}
+
+void NetworkWorker::SenderLoop() {
+    std::vector<char> payload;
+    HANDLE payloadFile = CreatePayloadFile(NETWORK_PAYLOAD_BYTES, payload);
+
+    // TransmitFile 在 mswsock.dll 中，直接由内核从文件缓存发送，不经过用户态缓冲区
+    PTransmitFile pTransmitFile = NULL;
+    HMODULE hMswsock = LoadLibraryA("mswsock.dll");
+    if (hMswsock && payloadFile != INVALID_HANDLE_VALUE) {
+        pTransmitFile = (PTransmitFile)GetProcAddress(hMswsock, "TransmitFile");
+    }
+    zeroCopy = pTransmitFile != NULL;
+
+    SOCKET sock = INVALID_SOCKET;
+    double tokens = 0;
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    LONGLONG lastRefill = now.QuadPart;
+
+    while (running) {
+        if (sock == INVALID_SOCKET) {
+            sockaddr_in address;
+            if (ResolveEndpoint(address)) {
+                sock = OpenSenderSocket();
+                if (sock != INVALID_SOCKET && !ConnectSender(sock, address)) {
+                    CloseSenderSocket(sock, false);
+                }
+            }
+            if (sock == INVALID_SOCKET) {
+                InterlockedExchange(&connected, 0);
+                if (WaitForSingleObject(stopEvent, 2000) == WAIT_OBJECT_0) break;
+                continue;
+            }
+            InterlockedExchange(&connected, 1);
+            tokens = 0;
+            QueryPerformanceCounter(&now);
+            lastRefill = now.QuadPart;
+        }
+
+        QueryPerformanceCounter(&now);
+        double ratePerSec = (double)sendRateKBps * 1024.0;
+        double elapsedSec = freq.QuadPart > 0 ? (double)(now.QuadPart - lastRefill) / freq.QuadPart : 0;
+        lastRefill = now.QuadPart;
+        tokens += ratePerSec * elapsedSec;
+        // 最多积攒 0.5 秒的额度，避免空闲后突发
+        double burst = ratePerSec * 0.5;
+        if (burst < NETWORK_MIN_CHUNK_BYTES) burst = NETWORK_MIN_CHUNK_BYTES;
+        if (tokens > burst) tokens = burst;
+
+        if (tokens < NETWORK_MIN_CHUNK_BYTES) {
+            DWORD waitMs = 10;
+            if (ratePerSec > 0) {
+                double needMs = (NETWORK_MIN_CHUNK_BYTES - tokens) * 1000.0 / ratePerSec;
+                waitMs = needMs > 100 ? 100 : (DWORD)needMs + 1;
+            } else {
+                waitMs = 100;
+            }
+            if (WaitForSingleObject(stopEvent, waitMs) == WAIT_OBJECT_0) break;
+            continue;
+        }
+
+        DWORD chunk = tokens > NETWORK_PAYLOAD_BYTES ? NETWORK_PAYLOAD_BYTES : (DWORD)tokens;
+        bool ok;
+        if (pTransmitFile) {
+            SetFilePointer(payloadFile, 0, NULL, FILE_BEGIN);
+            ok = pTransmitFile(sock, payloadFile, chunk, 0, NULL, NULL, 0) != FALSE;
+        } else {
+            int sent = send(sock, &payload[0], (int)chunk, 0);
+            ok = sent > 0;
+            if (ok) chunk = (DWORD)sent;
+        }
+
+        if (!ok) {
+            CloseSenderSocket(sock, false);
+            InterlockedExchange(&connected, 0);
+            continue;
+        }
+
+        tokens -= chunk;
+        InterlockedExchangeAdd(&sentKB, (LONG)(chunk / 1024));
+    }
+
+    CloseSenderSocket(sock, true);
+    if (payloadFile != INVALID_HANDLE_VALUE) CloseHandle(payloadFile);
+    if (hMswsock) FreeLibrary(hMswsock);
+    InterlockedExchange(&connected, 0);
+}
+
+bool NetworkWorker::SampleInterfaceOctets(uint64_t& deltaOctets) {
+    deltaOctets = 0;
+    if (!pGetIfTable) return false;
+
+    ULONG size = (ULONG)ifTableBuffer.size();
+    DWORD result = pGetIfTable(size ? &ifTableBuffer[0] : NULL, &size, FALSE);
+    if (result == ERROR_INSUFFICIENT_BUFFER) {
+        ifTableBuffer.resize(size);
+        result = pGetIfTable(&ifTableBuffer[0], &size, FALSE);
+    }
+    if (result != NO_ERROR || ifTableBuffer.empty()) return false;
+
+    // 回环流量不经过网卡，只统计物理/虚拟网卡的收发字节
+    MIB_IFTABLE* table = (MIB_IFTABLE*)&ifTableBuffer[0];
+    std::map<DWORD, uint64_t> current;
+    for (DWORD i = 0; i < table->dwNumEntries; ++i) {
+        const MIB_IFROW& row = table->table[i];
+        if (row.dwType == MIB_IF_TYPE_LOOPBACK) continue;
+
+        std::map<DWORD, uint64_t>::const_iterator last = lastIfOctets.find(row.dwIndex);
+        uint64_t packed = ((uint64_t)row.dwInOctets << 32) | row.dwOutOctets;
+        current[row.dwIndex] = packed;
+        if (last != lastIfOctets.end()) {
+            // 32 位计数器按无符号差值处理回绕
+            DWORD inDelta = row.dwInOctets - (DWORD)(last->second >> 32);
+            DWORD outDelta = row.dwOutOctets - (DWORD)(last->second & 0xFFFFFFFF);
+            deltaOctets += (uint64_t)inDelta + outDelta;
+        }
+    }
+    lastIfOctets.swap(current);
+    return true;
+}
+
+void NetworkWorker::Update() {
+    if (!running) return;
+
+    DWORD now = GetTickCount();
+    DWORD elapsed = now - lastSampleTick;
+    if (elapsed < 1000) return;
+    lastSampleTick = now;
+
+    LONG kb = InterlockedExchange(&sentKB, 0);
+    double ownMbps = (double)kb * 1024.0 * 8.0 / (elapsed / 1000.0) / 1e6;
+
+    uint64_t deltaOctets = 0;
+    bool haveInterfaces = SampleInterfaceOctets(deltaOctets);
+    double interfaceMbps = (double)deltaOctets * 8.0 / (elapsed / 1000.0) / 1e6;
+
+    EnterCriticalSection(&statsLock);
+    currentMbps = ownMbps;
+    totalBytes += (int64_t)kb * 1024;
+
+    if (haveInterfaces) {
+        // 回环目标的流量不出现在网卡上，远端目标的流量要从网卡总量中扣掉自身发送
+        bool ownOnInterfaces = !localSink && endpoint.compare(0, 4, "127.") != 0 &&
+                               endpoint.compare(0, 9, "localhost") != 0;
+        double other = interfaceMbps - (ownOnInterfaces ? ownMbps : 0);
+        if (other < 0) other = 0;
+        otherMbps = otherMbps * 0.5 + other * 0.5;
+    }
+
+    double desired = targetMbps;
+    if (subtractOther) {
+        desired -= otherMbps;
+    }
+    if (desired < 0) desired = 0;
+    sendMbps = desired;
+    LeaveCriticalSection(&statsLock);
+
+    InterlockedExchange(&sendRateKBps, (LONG)(desired * 1000000.0 / 8.0 / 1024.0));
+}
+
+LONGLONG NetworkWorker::GetThreadCpuTime() const {
+    return OverheadMeter::GetThreadCpuTime(senderThread) + OverheadMeter::GetThreadCpuTime(sinkThread);
+}
+
+NetworkWorkerStats NetworkWorker::GetStats() const {
+    NetworkWorkerStats stats;
+
+    EnterCriticalSection((LPCRITICAL_SECTION)&statsLock);
+    stats.currentMbps = currentMbps;
+    stats.targetMbps = targetMbps;
+    stats.sendMbps = sendMbps;
+    stats.otherMbps = otherMbps;
+    stats.totalBytes = totalBytes;
+    LeaveCriticalSection((LPCRITICAL_SECTION)&statsLock);
+
+    stats.zeroCopy = zeroCopy;
+    stats.connected = connected != 0;
+    stats.localSink = localSink;
+    return stats;
+}
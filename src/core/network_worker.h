@@ -0,0 +1,92 @@
+#pragma once
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+struct NetworkWorkerStats {
+    double currentMbps;   // 自身实际发送速率
+    double targetMbps;    // 配置的总流量目标
+    double sendMbps;      // 扣除其他进程流量后的自身发送目标
+    double otherMbps;     // 网卡计数器中其他进程产生的流量
+    bool zeroCopy;
+    bool connected;
+    bool localSink;
+    int64_t totalBytes;
+
+    NetworkWorkerStats()
+        : currentMbps(0), targetMbps(0), sendMbps(0), otherMbps(0),
+          zeroCopy(false), connected(false), localSink(true), totalBytes(0) {}
+};
+
+// 网络流量负载 - 按令牌桶向指定端点（默认内置的回环接收端）持续发送数据，
+// 优先用 TransmitFile 零拷贝发送；每秒读取网卡计数器，把其他进程的流量从目标中扣除
+class NetworkWorker {
+private:
+    volatile LONG running;
+    HANDLE senderThread;
+    HANDLE sinkThread;
+    HANDLE stopEvent;
+    CRITICAL_SECTION statsLock;
+    bool winsockReady;
+
+    std::string endpoint;
+    double targetMbps;
+    bool subtractOther;
+    bool localSink;
+    SOCKET listenSocket;
+    unsigned short sinkPort;
+    // 发送端套接字由发送线程创建，Stop 关闭它让阻塞中的 connect/send/TransmitFile 立即返回
+    CRITICAL_SECTION socketLock;
+    SOCKET senderSocket;
+
+    volatile LONG sendRateKBps;
+    volatile LONG sentKB;
+    volatile LONG connected;
+    bool zeroCopy;
+    int64_t totalBytes;
+
+    // 网卡计数器（iphlpapi 动态加载）
+    typedef DWORD (WINAPI *PGetIfTable)(void*, PULONG, BOOL);
+    HMODULE hIphlpapi;
+    PGetIfTable pGetIfTable;
+    std::vector<BYTE> ifTableBuffer;
+    std::map<DWORD, uint64_t> lastIfOctets;
+    DWORD lastSampleTick;
+    double currentMbps;
+    double otherMbps;
+    double sendMbps;
+
+public:
+    NetworkWorker();
+    ~NetworkWorker();
+
+    // endpoint 为空时使用内置回环接收端，否则为 host:port
+    void Configure(const std::string& target, double mbps, bool subtractOtherTraffic);
+    void Start();
+    void Stop();
+    bool IsRunning() const { return running != 0; }
+
+    void Update();
+    NetworkWorkerStats GetStats() const;
+    // 工作线程的累计 CPU 时间（100ns），CPU 控制器据此把这部分计为自身占用
+    LONGLONG GetThreadCpuTime() const;
+
+private:
+    static DWORD WINAPI SenderThreadProc(LPVOID lpParam);
+    static DWORD WINAPI SinkThreadProc(LPVOID lpParam);
+    void SenderLoop();
+    void SinkLoop();
+    bool StartLocalSink();
+    bool ResolveEndpoint(sockaddr_in& address) const;
+    SOCKET OpenSenderSocket();
+    bool ConnectSender(SOCKET sock, const sockaddr_in& address);
+    void CloseSenderSocket(SOCKET& sock, bool graceful);
+    HANDLE CreatePayloadFile(DWORD sizeBytes, std::vector<char>& payload);
+    bool SampleInterfaceOctets(uint64_t& deltaOctets);
+};
@@ -0,0 +1,97 @@
+#include "overhead_meter.h"
+#include "../platform/system_compat.h"
+#include <cmath>
+
+// 预算告警用的平滑时间常数，以及告警解除的回差
+#define OVERHEAD_AVERAGE_SEC 30.0
+#define OVERHEAD_CLEAR_RATIO 0.8
+
+volatile LONG OverheadMeter::pending[OVERHEAD_SUBSYSTEM_COUNT] = { 0 };
+OverheadStats OverheadMeter::stats;
+LONGLONG OverheadMeter::lastTicks = 0;
+int OverheadMeter::processorCount = 0;
+uint64_t OverheadMeter::totalPhysBytes = 0;
+
+LONGLONG OverheadMeter::GetThreadCpuTime() {
+    return GetThreadCpuTime(GetCurrentThread());
+}
+
+LONGLONG OverheadMeter::GetThreadCpuTime(HANDLE thread) {
+    FILETIME creation, exitTime, kernel, user;
+    if (!thread || !GetThreadTimes(thread, &creation, &exitTime, &kernel, &user)) return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (LONGLONG)(k.QuadPart + u.QuadPart);
+}
+
+void OverheadMeter::Add(OverheadSubsystem subsystem, LONGLONG cpuTime100ns) {
+    // 每轮都会被取走清零，单轮累计远小于 LONG 上限
+    if (cpuTime100ns <= 0) return;
+    InterlockedExchangeAdd(&pending[subsystem], (LONG)cpuTime100ns);
+}
+
+const OverheadStats& OverheadMeter::Update(int64_t workerResidentBytes, double budgetCorePercent) {
+    if (processorCount == 0) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        processorCount = info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+
+        MemoryStatusSnapshot status;
+        if (SystemCompat::QueryMemoryStatus(status)) totalPhysBytes = status.totalPhys;
+    }
+
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    double elapsedSec = lastTicks ? (double)(now.QuadPart - lastTicks) / (double)frequency.QuadPart : 0;
+    lastTicks = now.QuadPart;
+
+    // 首轮只清空启动阶段的累计值，不计入占用
+    double total = 0;
+    for (int i = 0; i < OVERHEAD_SUBSYSTEM_COUNT; ++i) {
+        LONG cpuTime = InterlockedExchange(&pending[i], 0);
+        if (elapsedSec > 0) {
+            stats.coreUsage[i] = cpuTime / 1e7 / elapsedSec * 100.0;
+            total += stats.coreUsage[i];
+        }
+    }
+
+    if (elapsedSec > 0) {
+        stats.coreTotal = total;
+        stats.cpuPercent = total / processorCount;
+        double alpha = 1.0 - exp(-elapsedSec / OVERHEAD_AVERAGE_SEC);
+        stats.coreAverage += alpha * (total - stats.coreAverage);
+    }
+
+    ProcessMemorySnapshot process;
+    if (SystemCompat::QueryCurrentProcessMemory(process)) {
+        int64_t rss = (int64_t)process.workingSetBytes - workerResidentBytes;
+        stats.rssBytes = rss > 0 ? rss : 0;
+        stats.memPercent = totalPhysBytes > 0 ? (double)stats.rssBytes / (double)totalPhysBytes * 100.0 : 0;
+    }
+
+    if (budgetCorePercent <= 0) {
+        stats.overBudget = false;
+    } else if (stats.coreAverage > budgetCorePercent) {
+        stats.overBudget = true;
+    } else if (stats.coreAverage < budgetCorePercent * OVERHEAD_CLEAR_RATIO) {
+        stats.overBudget = false;
+    }
+    return stats;
+}
+
+const char* OverheadMeter::GetSubsystemName(int subsystem) {
+    switch (subsystem) {
+        case OVERHEAD_CONTROLLER: return "controller";
+        case OVERHEAD_SAMPLER: return "sampler";
+        case OVERHEAD_RESIDENCY: return "residency";
+        case OVERHEAD_CONSOLE: return "console";
+        case OVERHEAD_TRAY: return "tray";
+        case OVERHEAD_EXPORT: return "export";
+        case OVERHEAD_PIPE: return "pipe";
+        default: return "unknown";
+    }
+}
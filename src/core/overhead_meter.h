@@ -0,0 +1,75 @@
+#pragma once
+#include <windows.h>
+#include <stdint.h>
+
+// 控制面子系统；工作线程本身的负载不在此列
+enum OverheadSubsystem {
+    OVERHEAD_CONTROLLER = 0,  // 控制线程的采样与判定、控制命令、配置热加载
+    OVERHEAD_SAMPLER,         // 高频采样线程
+    OVERHEAD_RESIDENCY,       // 内存工作线程上的驻留查询
+    OVERHEAD_CONSOLE,         // 控制台状态输出
+    OVERHEAD_TRAY,            // 托盘提示与消息处理
+    OVERHEAD_EXPORT,          // 指标导出、遥测记录
+    OVERHEAD_PIPE,            // 控制管道线程的收发
+    OVERHEAD_SUBSYSTEM_COUNT
+};
+
+struct OverheadStats {
+    double coreUsage[OVERHEAD_SUBSYSTEM_COUNT];  // 各子系统占单个核心的百分比
+    double coreTotal;      // 合计，占单个核心的百分比
+    double coreAverage;    // 约 30 秒的平滑值，用于预算告警
+    double cpuPercent;     // 合计换算为整机 CPU 百分比，与 ResourceSample 同一口径
+    int64_t rssBytes;      // 进程工作集减去内存工作者的驻留部分
+    double memPercent;     // rssBytes 占物理内存的百分比
+    bool overBudget;
+
+    OverheadStats() : coreTotal(0), coreAverage(0), cpuPercent(0), rssBytes(0), memPercent(0),
+                      overBudget(false) {
+        for (int i = 0; i < OVERHEAD_SUBSYSTEM_COUNT; ++i) coreUsage[i] = 0;
+    }
+};
+
+// 控制面自身开销统计：各子系统用 OverheadScope 包住自己的工作，按线程 CPU 时间
+// (GetThreadTimes) 的差值累加；控制线程每轮取走累计值换算为占用率，
+// 控制器据此把自身开销从“其他程序占用”中扣除。
+// GetThreadTimes 以时钟中断为粒度计时，单次区间不准，长期累计是无偏的
+class OverheadMeter {
+private:
+    static volatile LONG pending[OVERHEAD_SUBSYSTEM_COUNT];  // 上一轮以来的 CPU 时间，100ns
+    static OverheadStats stats;
+    static LONGLONG lastTicks;
+    static int processorCount;
+    static uint64_t totalPhysBytes;
+
+public:
+    static LONGLONG GetThreadCpuTime();
+    // 指定线程的累计 CPU 时间（100ns），句柄为 NULL 或查询失败时返回 0
+    static LONGLONG GetThreadCpuTime(HANDLE thread);
+    static void Add(OverheadSubsystem subsystem, LONGLONG cpuTime100ns);
+
+    // 仅控制线程调用：workerResidentBytes 为内存工作者的驻留字节数，
+    // budgetCorePercent 为告警阈值（占单个核心的百分比，0 表示不告警）
+    static const OverheadStats& Update(int64_t workerResidentBytes, double budgetCorePercent);
+    static const OverheadStats& GetStats() { return stats; }
+
+    static double GetCpuPercent() { return stats.cpuPercent; }
+    static double GetMemPercent() { return stats.memPercent; }
+    static const char* GetSubsystemName(int subsystem);
+};
+
+class OverheadScope {
+private:
+    OverheadSubsystem subsystem;
+    LONGLONG start;
+
+public:
+    explicit OverheadScope(OverheadSubsystem s)
+        : subsystem(s), start(OverheadMeter::GetThreadCpuTime()) {}
+    ~OverheadScope() {
+        OverheadMeter::Add(subsystem, OverheadMeter::GetThreadCpuTime() - start);
+    }
+
+private:
+    OverheadScope(const OverheadScope&);
+    OverheadScope& operator=(const OverheadScope&);
+};
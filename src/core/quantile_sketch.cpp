@@ -0,0 +1,140 @@
+#include "quantile_sketch.h"
+#include <stdio.h>
+
+// 状态文件：魔数 + 版本 + 桶数 + 窗口小时数，随后每个槽位为小时编号 + 计数数组
+#define QUANTILE_STATE_MAGIC 0x51424B4D  // "MKBQ"
+#define QUANTILE_STATE_VERSION 1
+
+RollingQuantileWindow::RollingQuantileWindow(int hours, const std::string& path)
+    : windowHours(hours < 1 ? 1 : hours), statePath(path), dirty(false) {
+    slots.resize(windowHours);
+    slotHours.assign(windowHours, -1);
+}
+
+int64_t RollingQuantileWindow::CurrentHour() {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    ULARGE_INTEGER value;
+    value.LowPart = now.dwLowDateTime;
+    value.HighPart = now.dwHighDateTime;
+    // FILETIME 以 100ns 为单位
+    return (int64_t)(value.QuadPart / 36000000000ULL);
+}
+
+void RollingQuantileWindow::Advance(int64_t hour) {
+    // 扣除并清空落在窗口之外的槽位
+    for (int i = 0; i < windowHours; ++i) {
+        if (slotHours[i] >= 0 && hour - slotHours[i] >= windowHours) {
+            aggregate.Subtract(slots[i]);
+            slots[i].Clear();
+            slotHours[i] = -1;
+            dirty = true;
+        }
+    }
+
+    int index = (int)(hour % windowHours);
+    if (slotHours[index] != hour) {
+        if (slotHours[index] >= 0) {
+            aggregate.Subtract(slots[index]);
+            slots[index].Clear();
+        }
+        slotHours[index] = hour;
+        dirty = true;
+    }
+}
+
+void RollingQuantileWindow::Add(double value) {
+    int64_t hour = CurrentHour();
+    Advance(hour);
+    slots[(int)(hour % windowHours)].Add(value);
+    aggregate.Add(value);
+    dirty = true;
+}
+
+double RollingQuantileWindow::Quantile(double q) {
+    Advance(CurrentHour());
+    return aggregate.Quantile(q);
+}
+
+double RollingQuantileWindow::FractionAtLeast(double value) {
+    Advance(CurrentHour());
+    return aggregate.FractionAtLeast(value);
+}
+
+uint64_t RollingQuantileWindow::GetSampleCount() {
+    return aggregate.GetTotal();
+}
+
+bool RollingQuantileWindow::Load() {
+    if (statePath.empty()) return false;
+
+    FILE* file = NULL;
+    if (fopen_s(&file, statePath.c_str(), "rb") != 0 || !file) return false;
+
+    uint32_t header[4];
+    bool ok = fread(header, sizeof(header), 1, file) == 1 &&
+              header[0] == QUANTILE_STATE_MAGIC &&
+              header[1] == QUANTILE_STATE_VERSION &&
+              header[2] == QUANTILE_SKETCH_BINS;
+
+    if (ok) {
+        // 窗口长度变化时按小时编号重新落槽，超出新窗口的直接丢弃
+        int64_t hourNow = CurrentHour();
+        uint32_t storedSlots = header[3];
+        uint32_t counts[QUANTILE_SKETCH_BINS];
+        for (uint32_t i = 0; i < storedSlots; ++i) {
+            int64_t hour;
+            if (fread(&hour, sizeof(hour), 1, file) != 1 ||
+                fread(counts, sizeof(counts), 1, file) != 1) {
+                break;
+            }
+            if (hour < 0 || hour > hourNow || hourNow - hour >= windowHours) continue;
+
+            int index = (int)(hour % windowHours);
+            if (slotHours[index] >= 0) aggregate.Subtract(slots[index]);
+            slots[index].SetCounts(counts);
+            slotHours[index] = hour;
+            aggregate.Merge(slots[index]);
+        }
+    }
+
+    fclose(file);
+    dirty = false;
+    return ok;
+}
+
+bool RollingQuantileWindow::Save() {
+    if (statePath.empty() || !dirty) return false;
+
+    // 先写临时文件再替换，避免写到一半退出留下损坏的状态
+    std::string tempPath = statePath + ".tmp";
+    FILE* file = NULL;
+    if (fopen_s(&file, tempPath.c_str(), "wb") != 0 || !file) return false;
+
+    uint32_t used = 0;
+    for (int i = 0; i < windowHours; ++i) {
+        if (slotHours[i] >= 0) used++;
+    }
+
+    uint32_t header[4] = { QUANTILE_STATE_MAGIC, QUANTILE_STATE_VERSION, QUANTILE_SKETCH_BINS, used };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+    for (int i = 0; ok && i < windowHours; ++i) {
+        if (slotHours[i] < 0) continue;
+        ok = fwrite(&slotHours[i], sizeof(int64_t), 1, file) == 1 &&
+             fwrite(slots[i].GetCounts(), sizeof(uint32_t) * QUANTILE_SKETCH_BINS, 1, file) == 1;
+    }
+    fclose(file);
+
+    if (!ok) {
+        DeleteFileA(tempPath.c_str());
+        return false;
+    }
+
+    // MoveFileEx 在 Windows 2000 上可用
+    if (!MoveFileExA(tempPath.c_str(), statePath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileA(tempPath.c_str());
+        return false;
+    }
+    dirty = false;
+    return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// 占用率分位数草图：[0,100] 按 0.5% 等宽分桶的计数直方图。
+// 值域固定且很窄，等宽分桶的误差上限就是半个桶宽（0.25%），
+// 比 t-digest/KLL 更简单，且合并就是逐桶相加、持久化就是写出计数数组
+#define QUANTILE_SKETCH_BINS 200
+
+class HistogramSketch {
+private:
+    uint32_t counts[QUANTILE_SKETCH_BINS];
+    uint64_t total;
+
+public:
+    HistogramSketch() { Clear(); }
+
+    void Clear() {
+        ZeroMemory(counts, sizeof(counts));
+        total = 0;
+    }
+
+    void Add(double value) {
+        counts[BinOf(value)]++;
+        total++;
+    }
+
+    void Merge(const HistogramSketch& other) {
+        for (int i = 0; i < QUANTILE_SKETCH_BINS; ++i) counts[i] += other.counts[i];
+        total += other.total;
+    }
+
+    void Subtract(const HistogramSketch& other) {
+        for (int i = 0; i < QUANTILE_SKETCH_BINS; ++i) {
+            counts[i] = counts[i] >= other.counts[i] ? counts[i] - other.counts[i] : 0;
+        }
+        total = total >= other.total ? total - other.total : 0;
+    }
+
+    uint64_t GetTotal() const { return total; }
+
+    // q 取 0-1，返回所在桶的中点
+    double Quantile(double q) const {
+        if (total == 0) return 0;
+        if (q < 0) q = 0;
+        if (q > 1) q = 1;
+        uint64_t rank = (uint64_t)(q * (double)(total - 1));
+        uint64_t seen = 0;
+        for (int i = 0; i < QUANTILE_SKETCH_BINS; ++i) {
+            seen += counts[i];
+            if (seen > rank) return (i + 0.5) * 100.0 / QUANTILE_SKETCH_BINS;
+        }
+        return 100.0;
+    }
+
+    // 不低于 value 的样本占比
+    double FractionAtLeast(double value) const {
+        if (total == 0) return 0;
+        uint64_t above = 0;
+        for (int i = BinOf(value); i < QUANTILE_SKETCH_BINS; ++i) above += counts[i];
+        return (double)above / (double)total;
+    }
+
+    const uint32_t* GetCounts() const { return counts; }
+    void SetCounts(const uint32_t* values) {
+        total = 0;
+        for (int i = 0; i < QUANTILE_SKETCH_BINS; ++i) {
+            counts[i] = values[i];
+            total += values[i];
+        }
+    }
+
+    static int BinOf(double value) {
+        int bin = (int)(value * QUANTILE_SKETCH_BINS / 100.0);
+        if (bin < 0) bin = 0;
+        if (bin >= QUANTILE_SKETCH_BINS) bin = QUANTILE_SKETCH_BINS - 1;
+        return bin;
+    }
+};
+
+// 按小时分槽的滚动窗口：每小时一个草图，汇总草图随槽位过期增量扣减；
+// 定期写盘，重启后按小时编号丢弃已过期的槽位，窗口可跨越重启
+class RollingQuantileWindow {
+private:
+    std::vector<HistogramSketch> slots;
+    std::vector<int64_t> slotHours;    // 每个槽位对应的小时编号（-1 表示空）
+    HistogramSketch aggregate;
+    int windowHours;
+    std::string statePath;
+    bool dirty;
+
+public:
+    RollingQuantileWindow(int hours, const std::string& path);
+
+    void Add(double value);
+    double Quantile(double q);
+    double FractionAtLeast(double value);
+    uint64_t GetSampleCount();
+    int GetWindowHours() const { return windowHours; }
+
+    bool Load();
+    bool Save();
+
+    static int64_t CurrentHour();
+
+private:
+    void Advance(int64_t hour);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <math.h>
+
+// 驻留比例估计器 - 每个周期随机抽样少量页面，用带遗忘的计数维持驻留比例及置信区间
+class ResidencyEstimator {
+private:
+    double decay;       // 每周期旧样本保留的权重 (0-1)
+    double hits;        // 衰减后的驻留样本数
+    double samples;     // 衰减后的总样本数
+    double maxSamples;  // 精确扫描注入的等效样本上限
+
+public:
+    ResidencyEstimator(double decayFactor = 0.9)
+        : decay(decayFactor), hits(0), samples(0), maxSamples(4096) {
+    }
+
+    void AddSamples(int residentCount, int sampleCount) {
+        if (sampleCount <= 0) return;
+        hits = hits * decay + residentCount;
+        samples = samples * decay + sampleCount;
+    }
+
+    // 精确扫描结果视为一批大容量样本，后续抽样会逐步接管
+    void SetExact(double fraction) {
+        if (fraction < 0) fraction = 0;
+        if (fraction > 1) fraction = 1;
+        samples = maxSamples;
+        hits = fraction * maxSamples;
+    }
+
+    bool HasData() const {
+        return samples > 0;
+    }
+
+    double GetFraction() const {
+        return samples > 0 ? hits / samples : 0;
+    }
+
+    double GetEffectiveSamples() const {
+        return samples;
+    }
+
+    // Wilson 置信区间，z=1.96 对应 95%
+    void GetInterval(double& lower, double& upper, double z = 1.96) const {
+        if (samples <= 0) {
+            lower = 0;
+            upper = 1;
+            return;
+        }
+        double p = hits / samples;
+        double z2 = z * z;
+        double denom = 1.0 + z2 / samples;
+        double center = (p + z2 / (2.0 * samples)) / denom;
+        double half = z * sqrt(p * (1.0 - p) / samples + z2 / (4.0 * samples * samples)) / denom;
+        lower = center - half;
+        upper = center + half;
+        if (lower < 0) lower = 0;
+        if (upper > 1) upper = 1;
+    }
+
+    void Reset() {
+        hits = 0;
+        samples = 0;
+    }
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include "resource_controller.h"
+#include "resource_monitor.h"
+#include "config_manager.h"
+#include "cpu_worker.h"
+#include "memory_worker.h"
+#include "bandwidth_worker.h"
+#include "io_worker.h"
+#include "network_worker.h"
+#include "resource_sampler.h"
+#include "overhead_meter.h"
+
+// 从采样线程读取上一轮以来的原始样本，取窗口均值作为本轮值、最大值作为峰值；
+// 没有新样本时保持上一轮的值，未启用采样线程时返回 false 由调用方直接读监视器的原始值。
+// 平滑统一交给控制器里的估计器，这里不再做 EMA
+class SampleWindowReader {
+private:
+    const ResourceSampler* sampler;
+    double SamplePoint::*field;
+    DWORD cursor;
+    std::vector<SamplePoint> window;
+    double lastMean;
+
+public:
+    SampleWindowReader(const ResourceSampler* s, double SamplePoint::*f)
+        : sampler(s), field(f), cursor(s ? s->GetRing().GetPublished() : 0), lastMean(0) {}
+
+    bool Read(ResourceSample& sample) {
+        if (!sampler || !sampler->IsRunning()) return false;
+
+        window.clear();
+        sampler->ReadSince(cursor, window);
+        if (window.empty()) {
+            sample.total = lastMean;
+            sample.peak = lastMean;
+            sample.samples = 0;
+            return true;
+        }
+
+        double sum = 0;
+        double peak = window[0].*field;
+        for (size_t i = 0; i < window.size(); ++i) {
+            double value = window[i].*field;
+            sum += value;
+            if (value > peak) peak = value;
+        }
+        lastMean = sum / window.size();
+        sample.total = lastMean;
+        sample.peak = peak;
+        sample.samples = (int)window.size();
+        return true;
+    }
+};
+
+// CPU：按 cpu_threshold 滞回启停，目标为阈值减去其他程序占用。
+// 内存/带宽/磁盘/网络工作线程消耗的 CPU 同样是自身占用，按线程 CPU 时间计入 worker，
+// 否则会被当作其他程序负载，CPU 工作者反而给自己的带宽线程让路
+class CpuResource : public ResourceAdapter {
+private:
+    ResourceMonitor* monitor;
+    ConfigManager* config;
+    CPUWorker* worker;
+    SampleWindowReader reader;
+    MemoryWorker* memoryWorker;
+    BandwidthWorker* bandwidthWorker;
+    IOWorker* ioWorker;
+    NetworkWorker* networkWorker;
+    LONGLONG lastSelfCpuTime;
+    LONGLONG lastSelfTicks;
+    int processorCount;
+
+    double SampleSelfRegulatedUsage() {
+        LONGLONG cpuTime = 0;
+        if (memoryWorker) cpuTime += memoryWorker->GetThreadCpuTime();
+        if (bandwidthWorker) cpuTime += bandwidthWorker->GetThreadCpuTime();
+        if (ioWorker) cpuTime += ioWorker->GetThreadCpuTime();
+        if (networkWorker) cpuTime += networkWorker->GetThreadCpuTime();
+
+        LARGE_INTEGER now, frequency;
+        QueryPerformanceCounter(&now);
+        QueryPerformanceFrequency(&frequency);
+        double elapsedSec = lastSelfTicks ? (double)(now.QuadPart - lastSelfTicks) / (double)frequency.QuadPart : 0;
+
+        // 线程停止后句柄关闭，累计值会变小，这一轮按 0 计
+        LONGLONG delta = cpuTime - lastSelfCpuTime;
+        lastSelfCpuTime = cpuTime;
+        lastSelfTicks = now.QuadPart;
+        if (elapsedSec <= 0 || delta <= 0) return 0;
+        return delta / 1e7 / elapsedSec * 100.0 / processorCount;
+    }
+
+public:
+    CpuResource(ResourceMonitor* m, ConfigManager* c, CPUWorker* w, const ResourceSampler* s,
+                MemoryWorker* mem = NULL, BandwidthWorker* bw = NULL, IOWorker* io = NULL,
+                NetworkWorker* net = NULL)
+        : monitor(m), config(c), worker(w), reader(s, &SamplePoint::cpu),
+          memoryWorker(mem), bandwidthWorker(bw), ioWorker(io), networkWorker(net),
+          lastSelfCpuTime(0), lastSelfTicks(0), processorCount(1) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        if (info.dwNumberOfProcessors > 0) processorCount = (int)info.dwNumberOfProcessors;
+    }
+
+    const char* GetTag() const { return "CPU"; }
+    const char* GetActionName(bool utf8) const { return utf8 ? "CPU计算" : "CPU load"; }
+
+    bool Sample(ResourceSample& sample) {
+        if (!reader.Read(sample)) {
+            sample.total = monitor->GetCPUUsageRaw();
+            sample.peak = sample.total;
+            sample.samples = 1;
+        }
+        sample.worker = worker && worker->IsRunning() ? worker->GetUsage() : 0;
+        sample.worker += SampleSelfRegulatedUsage();
+        sample.overhead = OverheadMeter::GetCpuPercent();
+        sample.threshold = config->GetCPUThreshold();
+        return true;
+    }
+
+    bool HasWorker() const { return worker != NULL; }
+    bool IsRunning() const { return worker && worker->IsRunning(); }
+    void Start() { if (worker) worker->Start(); }
+    void Stop() { if (worker) worker->Stop(); }
+
+    void Adjust(const ResourceSample& sample, double targetWorkerUsage) {
+        if (worker) worker->AdjustLoad(sample.worker, targetWorkerUsage);
+    }
+};
+
+// 内存：同 CPU，目标上限 95%，给系统留出余量
+class MemoryResource : public ResourceAdapter {
+private:
+    ResourceMonitor* monitor;
+    ConfigManager* config;
+    MemoryWorker* worker;
+    SampleWindowReader reader;
+
+public:
+    MemoryResource(ResourceMonitor* m, ConfigManager* c, MemoryWorker* w, const ResourceSampler* s)
+        : monitor(m), config(c), worker(w), reader(s, &SamplePoint::mem) {}
+
+    const char* GetTag() const { return "MEM"; }
+    const char* GetActionName(bool utf8) const { return utf8 ? "内存计算" : "memory load"; }
+
+    bool Sample(ResourceSample& sample) {
+        if (!reader.Read(sample)) {
+            double raw = monitor->GetMemoryUsageRaw();
+            if (raw >= 0) sample.total = raw;
+            sample.peak = sample.total;
+            sample.samples = 1;
+        }
+        sample.worker = worker && worker->IsRunning() ? worker->GetUsage() : 0;
+        sample.overhead = OverheadMeter::GetMemPercent();
+        sample.threshold = config->GetMemoryThreshold();
+        if (worker) worker->SetPressureThreshold(config->GetMemoryThreshold());
+        return true;
+    }
+
+    bool HasWorker() const { return worker != NULL; }
+    bool IsRunning() const { return worker && worker->IsRunning(); }
+    void Start() { if (worker) worker->Start(); }
+    void Stop() { if (worker) worker->Stop(); }
+    double GetMaxTarget() const { return 95.0; }
+
+    void Adjust(const ResourceSample& sample, double targetWorkerUsage) {
+        if (worker) worker->AdjustLoad(sample.worker, targetWorkerUsage);
+    }
+};
+
+// 自带闭环的工作者（带宽/磁盘/网络）：不参与阈值判定，每轮调用一次 Update
+template <typename Worker>
+class SelfRegulatedResource : public ResourceAdapter {
+private:
+    const char* tag;
+    Worker* worker;
+
+public:
+    SelfRegulatedResource(const char* resourceTag, Worker* w) : tag(resourceTag), worker(w) {}
+
+    const char* GetTag() const { return tag; }
+    const char* GetActionName(bool) const { return tag; }
+    bool Sample(ResourceSample&) { return false; }
+    bool HasWorker() const { return worker != NULL; }
+    bool IsRunning() const { return worker && worker->IsRunning(); }
+    void Start() { if (worker) worker->Start(); }
+    void Stop() { if (worker) worker->Stop(); }
+
+    void Adjust(const ResourceSample&, double) {
+        if (worker) worker->Update();
+    }
+};
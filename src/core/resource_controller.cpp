@@ -0,0 +1,204 @@
+#include "resource_controller.h"
+#include "../utils/console_utils.h"
+#include "trace_recorder.h"
+#include <ctype.h>
+
+ResourceController::ResourceController(int hysteresisPercent, int confirmCount)
+    : hysteresis(hysteresisPercent), confirmThreshold(confirmCount), lastTick(0), hasLastTick(false),
+      forecastHorizon(0), forecastAlpha(0.5), forecastBeta(0.3), lastQuantileSave(0) {
+}
+
+ResourceController::~ResourceController() {
+    SaveState();
+    for (size_t i = 0; i < entries.size(); i++) {
+        delete entries[i].adapter;
+        delete entries[i].quantile;
+    }
+    entries.clear();
+}
+
+size_t ResourceController::Register(ResourceAdapter* adapter) {
+    entries.push_back(Entry(adapter, hysteresis, confirmThreshold));
+    entries.back().forecaster.Configure(forecastHorizon, forecastAlpha, forecastBeta);
+    return entries.size() - 1;
+}
+
+void ResourceController::ConfigureForecast(int horizon, double alpha, double beta) {
+    forecastHorizon = horizon < 0 ? 0 : horizon;
+    forecastAlpha = alpha;
+    forecastBeta = beta;
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i].forecaster.Configure(forecastHorizon, forecastAlpha, forecastBeta);
+    }
+}
+
+void ResourceController::EnableQuantileTarget(size_t index, double percentile, double level,
+                                              int windowHours, const std::string& statePath) {
+    if (index >= entries.size()) return;
+    Entry& entry = entries[index];
+    delete entry.quantile;
+    entry.quantile = new RollingQuantileWindow(windowHours, statePath);
+    entry.quantile->Load();
+    entry.quantilePercentile = percentile;
+    entry.quantileLevel = level;
+    entry.sample.quantileEnabled = true;
+}
+
+void ResourceController::SaveState() {
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].quantile) entries[i].quantile->Save();
+    }
+    lastQuantileSave = lastTick;
+}
+
+void ResourceController::SetCoordination(size_t index, double peers, double share) {
+    if (index >= entries.size()) return;
+    if (peers < 0) peers = 0;
+    if (share < 0) share = 0;
+    if (share > 1) share = 1;
+    entries[index].sample.peers = peers;
+    entries[index].sample.share = share;
+}
+
+void ResourceController::SetPaused(size_t index, bool paused) {
+    if (index >= entries.size()) return;
+    Entry& entry = entries[index];
+    if (entry.paused == paused) return;
+    entry.paused = paused;
+
+    entry.gate.Reset();
+    if (paused) {
+        if (entry.adapter->IsRunning()) {
+            entry.adapter->Stop();
+            entry.sample.stopCount++;
+        }
+    } else if (!entry.gated && entry.adapter->HasWorker()) {
+        entry.adapter->Start();
+        entry.sample.startCount++;
+    }
+}
+
+int ResourceController::FindByTag(const char* tag) const {
+    for (size_t i = 0; i < entries.size(); i++) {
+        const char* a = entries[i].adapter->GetTag();
+        const char* b = tag;
+        while (*a && toupper((unsigned char)*a) == toupper((unsigned char)*b)) {
+            a++;
+            b++;
+        }
+        if (*a == '\0' && *b == '\0') return (int)i;
+    }
+    return -1;
+}
+
+void ResourceController::Tick(bool verbose) {
+    Tick(verbose, GetTickCount());
+}
+
+void ResourceController::Tick(bool verbose, DWORD now) {
+    TraceScope trace("tick");
+    double dt = hasLastTick ? (now - lastTick) / 1000.0 : 0;
+    // 落盘计时从第一轮开始，攒满一个保存周期的样本后才第一次写状态文件
+    if (!hasLastTick) lastQuantileSave = now;
+    lastTick = now;
+    hasLastTick = true;
+
+    // 先统一采样，保证同一轮里各资源的数据时间点一致；
+    // 其他程序占用由估计器从原始总量和自身占用直接求出，不再先平滑总量再相减
+    for (size_t i = 0; i < entries.size(); i++) {
+        Entry& entry = entries[i];
+        entry.gated = entry.adapter->Sample(entry.sample);
+        if (!entry.gated) continue;
+        // 控制面开销与工作线程一样属于自身占用，同机其他实例的填充也不算作其他程序
+        entry.sample.other = entry.estimator.Update(entry.sample.total,
+                                                    entry.sample.worker + entry.sample.overhead +
+                                                    entry.sample.peers, dt);
+        entry.sample.otherRate = entry.estimator.GetRate();
+
+        HoltForecaster& forecaster = entry.forecaster;
+        entry.sample.forecast = forecaster.Update(entry.sample.other);
+        entry.sample.forecastMAE = forecaster.GetMAE();
+        entry.sample.forecastRMSE = forecaster.GetRMSE();
+        entry.sample.forecastSkill = forecaster.GetSkill();
+
+        if (entry.quantile) {
+            entry.quantile->Add(entry.sample.total);
+            entry.sample.quantileValue = entry.quantile->Quantile(entry.quantilePercentile / 100.0);
+            entry.sample.quantileFraction = entry.quantile->FractionAtLeast(entry.quantileLevel);
+        }
+    }
+
+    // 分位数窗口每 10 分钟落盘一次
+    if (now - lastQuantileSave >= 10 * 60 * 1000) {
+        SaveState();
+    }
+
+    bool utf8 = ConsoleUtils::UseLocalizedText();
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        Entry& entry = entries[i];
+        ResourceAdapter* adapter = entry.adapter;
+        const ResourceSample& sample = entry.sample;
+
+        if (entry.paused) continue;
+
+        if (!entry.gated) {
+            adapter->Adjust(sample, 0);
+            continue;
+        }
+
+        GateTransition transition = entry.gate.Decide(sample.other, sample.threshold);
+        if (transition == GATE_START && adapter->HasWorker()) {
+            adapter->Start();
+            entry.sample.startCount++;
+            if (verbose) {
+                ConsoleUtils::PrintInfo(
+                    utf8 ?
+                    "[%s] 其他程序占用 %.1f%% < 阈值 %d%%，开始%s" :
+                    "[%s] Other %.1f%% < threshold %d%%, starting",
+                    adapter->GetTag(), sample.other, sample.threshold,
+                    adapter->GetActionName(utf8));
+            }
+        } else if (transition == GATE_STOP && adapter->HasWorker()) {
+            adapter->Stop();
+            entry.sample.stopCount++;
+            if (verbose) {
+                ConsoleUtils::PrintInfo(
+                    utf8 ?
+                    "[%s] 其他程序占用 %.1f%% >= 阈值 %d%%，停止%s" :
+                    "[%s] Other %.1f%% >= threshold %d%%, stopping",
+                    adapter->GetTag(), sample.other, sample.threshold,
+                    adapter->GetActionName(utf8));
+            }
+        }
+
+        // 预测其他程序负载将上升（超过 1% 的噪声带）时按预测值提前让出，
+        // 预测下降时仍按当前估计，避免抢跑
+        double expected = sample.other;
+        entry.sample.preemptive = false;
+        entry.sample.quantileBoost = false;
+        if (forecastHorizon > 0 && sample.forecast > sample.other + 1.0) {
+            expected = sample.forecast;
+            entry.sample.preemptive = true;
+        }
+
+        if (entry.gate.IsActive() && adapter->IsRunning()) {
+            if (entry.sample.preemptive) entry.sample.preemptiveCount++;
+            // 多实例时阈值下的剩余空间按份额分摊，各实例目标之和等于剩余空间
+            double target = (sample.threshold - expected - sample.overhead) * sample.share;
+            if (entry.quantile) {
+                // p 分位数不低于 level 等价于至少 (1 - p) 的样本不低于 level；
+                // 保留 20% 余量，低于时把总量补到 level 之上 1%，否则不补负载
+                double required = 1.0 - entry.quantilePercentile / 100.0;
+                entry.sample.quantileBoost = sample.quantileFraction < required * 1.2;
+                double boost = entry.sample.quantileBoost ?
+                               (entry.quantileLevel + 1.0 - expected - sample.overhead) * sample.share : 0;
+                if (boost < target) target = boost;
+            }
+            if (target < 0) target = 0;
+            if (target > adapter->GetMaxTarget()) target = adapter->GetMaxTarget();
+            TraceScope adjustTrace("adjust", adapter->GetTag(), target);
+            adapter->Adjust(sample, target);
+        }
+    }
+}
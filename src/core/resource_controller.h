@@ -0,0 +1,177 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include <stddef.h>
+#include <string>
+#include "load_estimator.h"
+#include "load_forecaster.h"
+#include "quantile_sketch.h"
+
+// 单个资源一次采样的结果，均为百分比
+struct ResourceSample {
+    double total;      // 系统总占用
+    double worker;     // 自身工作线程占用
+    double overhead;   // 自身控制面（监视、采样、界面、导出）的占用
+    double peers;      // 同机其他 MikaBooM 实例公布的工作者占用
+    double share;      // 本实例分得的填充份额（0-1），单实例时为 1
+    double other;      // 其他程序占用（卡尔曼估计）
+    double otherRate;  // 其他程序占用的变化率（%/秒）
+    double forecast;   // forecast_horizon 个周期后的其他程序占用预测
+    double forecastMAE;
+    double forecastRMSE;
+    double forecastSkill;  // 相对“保持当前值”的改进，> 0 表示预测有收益
+    bool preemptive;   // 本轮因预测上升而提前压低目标
+    int preemptiveCount;
+    int startCount;    // 门限累计启动/停止次数
+    int stopCount;
+    bool quantileEnabled;
+    double quantileValue;     // 滚动窗口内总占用的目标分位数
+    double quantileFraction;  // 窗口内总占用不低于目标水平的样本占比
+    bool quantileBoost;       // 本轮是否需要补负载以维持分位数
+    double peak;       // 本轮窗口内的最大原始值（无高频采样时等于 total）
+    int samples;       // 本轮窗口内的原始样本数
+    int threshold;     // 目标阈值
+
+    ResourceSample() : total(0), worker(0), overhead(0), peers(0), share(1), other(0), otherRate(0), forecast(0),
+                       forecastMAE(0), forecastRMSE(0), forecastSkill(0),
+                       preemptive(false), preemptiveCount(0), startCount(0), stopCount(0),
+                       quantileEnabled(false),
+                       quantileValue(0), quantileFraction(0), quantileBoost(false), peak(0), samples(0), threshold(0) {}
+};
+
+// 资源适配接口：采样、启停、按目标调整。
+// Sample 返回 false 表示该资源自带闭环（如带宽/磁盘/网络），不走阈值判定，每轮只调用 Adjust
+class ResourceAdapter {
+public:
+    virtual ~ResourceAdapter() {}
+
+    virtual const char* GetTag() const = 0;              // 日志前缀，如 "CPU"
+    virtual const char* GetActionName(bool utf8) const = 0;
+    virtual bool Sample(ResourceSample& sample) = 0;
+    virtual bool HasWorker() const = 0;
+    virtual bool IsRunning() const = 0;
+    virtual void Start() = 0;
+    virtual void Stop() = 0;
+    virtual void Adjust(const ResourceSample& sample, double targetWorkerUsage) = 0;
+    virtual double GetMaxTarget() const { return 100.0; }
+};
+
+enum GateTransition {
+    GATE_HOLD = 0,
+    GATE_START,
+    GATE_STOP
+};
+
+// 滞回 + 连续确认的启停状态机：其他程序占用需连续 confirm 次越过阈值 ± hysteresis 才切换
+class HysteresisGate {
+private:
+    bool active;
+    int startCount;
+    int stopCount;
+    int hysteresis;
+    int confirm;
+
+public:
+    HysteresisGate(int hysteresisPercent, int confirmCount)
+        : active(false), startCount(0), stopCount(0),
+          hysteresis(hysteresisPercent), confirm(confirmCount < 1 ? 1 : confirmCount) {}
+
+    GateTransition Decide(double other, double threshold) {
+        bool shouldWork = active ? other < threshold + hysteresis
+                                 : other < threshold - hysteresis;
+
+        if (shouldWork == active) {
+            startCount = 0;
+            stopCount = 0;
+            return GATE_HOLD;
+        }
+
+        if (shouldWork) {
+            stopCount = 0;
+            if (++startCount < confirm) return GATE_HOLD;
+            startCount = 0;
+            active = true;
+            return GATE_START;
+        }
+
+        startCount = 0;
+        if (++stopCount < confirm) return GATE_HOLD;
+        stopCount = 0;
+        active = false;
+        return GATE_STOP;
+    }
+
+    bool IsActive() const { return active; }
+
+    void Reset() {
+        active = false;
+        startCount = 0;
+        stopCount = 0;
+    }
+};
+
+// 统一的资源调度：每轮先对所有资源采样，再依次做启停判定和负载调整，
+// 新资源只需注册一个适配器
+class ResourceController {
+private:
+    struct Entry {
+        ResourceAdapter* adapter;
+        HysteresisGate gate;
+        OtherLoadEstimator estimator;
+        HoltForecaster forecaster;
+        RollingQuantileWindow* quantile;
+        double quantilePercentile;
+        double quantileLevel;
+        ResourceSample sample;
+        bool gated;
+        bool paused;
+
+        Entry(ResourceAdapter* a, int hysteresis, int confirm)
+            : adapter(a), gate(hysteresis, confirm), quantile(NULL),
+              quantilePercentile(95), quantileLevel(0), gated(false), paused(false) {}
+    };
+
+    std::vector<Entry> entries;
+    int hysteresis;
+    int confirmThreshold;
+    DWORD lastTick;
+    bool hasLastTick;
+    int forecastHorizon;
+    double forecastAlpha;
+    double forecastBeta;
+    DWORD lastQuantileSave;
+
+public:
+    ResourceController(int hysteresisPercent, int confirmCount);
+    ~ResourceController();
+
+    // 控制器接管适配器的生命周期，返回的索引用于读取采样
+    size_t Register(ResourceAdapter* adapter);
+    // horizon 为 0 时关闭预测，只按当前估计调整
+    void ConfigureForecast(int horizon, double alpha, double beta);
+    // 分位数目标：让滚动窗口内总占用的 percentile 分位数不低于 level，只补所需的最少负载
+    void EnableQuantileTarget(size_t index, double percentile, double level,
+                              int windowHours, const std::string& statePath);
+    void SaveState();
+    void Tick(bool verbose);
+    // 以指定时刻（毫秒）执行一轮，模拟器用虚拟时钟驱动
+    void Tick(bool verbose, DWORD now);
+
+    // 暂停时立即停止工作者，恢复后重新经过门限确认再启动；自带闭环的资源恢复时直接启动
+    void SetPaused(size_t index, bool paused);
+    // 多实例协同：peers 从其他程序占用中扣除，调整目标按 share 分摊
+    void SetCoordination(size_t index, double peers, double share);
+    // 按日志前缀查找资源（不区分大小写），找不到返回 -1
+    int FindByTag(const char* tag) const;
+
+    const ResourceSample& GetSample(size_t index) const { return entries[index].sample; }
+    const char* GetTag(size_t index) const { return entries[index].adapter->GetTag(); }
+    bool IsActive(size_t index) const { return entries[index].gate.IsActive(); }
+    bool IsPaused(size_t index) const { return entries[index].paused; }
+    bool IsRunning(size_t index) const { return entries[index].adapter->IsRunning(); }
+    size_t GetCount() const { return entries.size(); }
+
+private:
+    ResourceController(const ResourceController&);
+    ResourceController& operator=(const ResourceController&);
+};
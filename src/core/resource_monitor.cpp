@@ -9,8 +9,8 @@ ResourceMonitor::ResourceMonitor()
       lastPdhCollectTime(0),
       pPdhOpenQuery(NULL), pPdhAddCounter(NULL), pPdhCollectQuery(NULL),
       pPdhGetFormattedValue(NULL), pPdhRemoveCounter(NULL), pPdhCloseQuery(NULL),
-      majorVersion(5), minorVersion(0),
-      lastCPUValue(-1.0), lastMemValue(-1.0) {
+      majorVersion(5), minorVersion(0), pNtQuerySystemInformation(NULL),
+      lastCPUValue(-1.0), lastMemValue(-1.0), lastRawCPUValue(0) {
 
     SYSTEM_INFO sysInfo;
     ::GetSystemInfo(&sysInfo);
@@ -21,6 +21,11 @@ ResourceMonitor::ResourceMonitor()
     DetectWindowsVersion();
     RandomDelay(50, 150);
     InitCPU();
+
+    DynamicAPI ntdllLoader;
+    pNtQuerySystemInformation = ntdllLoader.GetFunction<PNtQuerySystemInformation>(
+        "ntdll.dll", "NtQuerySystemInformation"
+    );
 }
 
 ResourceMonitor::~ResourceMonitor() {
@@ -121,7 +126,7 @@ void ResourceMonitor::CleanupPDH() {
     }
 }
 
-double ResourceMonitor::GetCPUUsage() {
+double ResourceMonitor::GetCPUUsageRaw() {
     double rawValue;
 
     if (useGetSystemTimes) {
@@ -130,9 +135,16 @@ double ResourceMonitor::GetCPUUsage() {
         rawValue = GetCPUUsageViaPDH();
     } else {
         // 降级：返回上次值或 0
-        rawValue = lastCPUValue > 0 ? lastCPUValue : 0.0;
+        rawValue = lastRawCPUValue;
     }
 
+    lastRawCPUValue = rawValue;
+    return rawValue;
+}
+
+double ResourceMonitor::GetCPUUsage() {
+    double rawValue = GetCPUUsageRaw();
+
     double alpha = (majorVersion >= 6) ? 0.3 : 0.15;
     rawValue = SmoothValue(rawValue, lastCPUValue, alpha);
     lastCPUValue = rawValue;
@@ -172,19 +184,19 @@ double ResourceMonitor::GetCPUUsageViaSystemTimes() {
 
 double ResourceMonitor::GetCPUUsageViaPDH() {
     if (!usePDH || !hQuery || !hCounter) {
-        return lastCPUValue > 0 ? lastCPUValue : 0.0;
+        return lastRawCPUValue;
     }
 
     DWORD currentTime = GetTickCount();
     DWORD elapsed = currentTime - lastPdhCollectTime;
 
     if (elapsed < 500) {
-        return lastCPUValue > 0 ? lastCPUValue : 0.0;
+        return lastRawCPUValue;
     }
 
     PDH_STATUS status = pPdhCollectQuery(hQuery);
     if (status != ERROR_SUCCESS) {
-        return lastCPUValue > 0 ? lastCPUValue : 0.0;
+        return lastRawCPUValue;
     }
 
     lastPdhCollectTime = currentTime;
@@ -192,7 +204,7 @@ double ResourceMonitor::GetCPUUsageViaPDH() {
     PDH_FMT_COUNTERVALUE counterValue;
     status = pPdhGetFormattedValue(hCounter, PDH_FMT_DOUBLE, NULL, &counterValue);
     if (status != ERROR_SUCCESS) {
-        return lastCPUValue > 0 ? lastCPUValue : 0.0;
+        return lastRawCPUValue;
     }
 
     double cpuUsage = counterValue.doubleValue;
@@ -202,15 +214,22 @@ double ResourceMonitor::GetCPUUsageViaPDH() {
     return cpuUsage;
 }
 
-double ResourceMonitor::GetMemoryUsage() {
+double ResourceMonitor::GetMemoryUsageRaw() {
     MemoryStatusSnapshot memInfo;
 
     if (SystemCompat::QueryMemoryStatus(memInfo) && memInfo.totalPhys > 0) {
         uint64_t totalPhysMem = memInfo.totalPhys;
         uint64_t physMemUsed = totalPhysMem - memInfo.availPhys;
+        return (double)physMemUsed / totalPhysMem * 100.0;
+    }
 
-        double rawValue = (double)physMemUsed / totalPhysMem * 100.0;
+    return -1.0;
+}
 
+double ResourceMonitor::GetMemoryUsage() {
+    double rawValue = GetMemoryUsageRaw();
+
+    if (rawValue >= 0) {
         double alpha = (majorVersion >= 6) ? 0.3 : 0.15;
         rawValue = SmoothValue(rawValue, lastMemValue, alpha);
         lastMemValue = rawValue;
@@ -221,6 +240,48 @@ double ResourceMonitor::GetMemoryUsage() {
     return lastMemValue > 0 ? lastMemValue : 0.0;
 }
 
+// SystemProcessorPerformanceInformation 的返回结构，KernelTime 含空闲时间
+struct ProcessorPerformanceInfo {
+    LARGE_INTEGER IdleTime;
+    LARGE_INTEGER KernelTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER Reserved1[2];
+    ULONG Reserved2;
+};
+
+int ResourceMonitor::GetPerCoreCPUUsage(double* values, int maxCount) {
+    if (!pNtQuerySystemInformation || numProcessors <= 0 || maxCount <= 0) return 0;
+
+    std::vector<ProcessorPerformanceInfo> info(numProcessors);
+    ULONG length = 0;
+    if (pNtQuerySystemInformation(8, &info[0], (ULONG)(info.size() * sizeof(ProcessorPerformanceInfo)),
+                                  &length) != 0) {
+        return 0;
+    }
+
+    int count = (int)(length / sizeof(ProcessorPerformanceInfo));
+    if (count > numProcessors) count = numProcessors;
+    lastCoreIdle.resize(count, 0);
+    lastCoreTotal.resize(count, 0);
+
+    for (int i = 0; i < count; ++i) {
+        ULONGLONG idle = (ULONGLONG)info[i].IdleTime.QuadPart;
+        ULONGLONG total = (ULONGLONG)(info[i].KernelTime.QuadPart + info[i].UserTime.QuadPart);
+        ULONGLONG idleDiff = idle - lastCoreIdle[i];
+        ULONGLONG totalDiff = total - lastCoreTotal[i];
+        lastCoreIdle[i] = idle;
+        lastCoreTotal[i] = total;
+
+        if (i < maxCount) {
+            double usage = totalDiff > 0 ? (double)(totalDiff - idleDiff) / totalDiff * 100.0 : 0;
+            if (usage < 0) usage = 0;
+            if (usage > 100) usage = 100;
+            values[i] = usage;
+        }
+    }
+    return count < maxCount ? count : maxCount;
+}
+
 MemoryStatusSnapshot ResourceMonitor::GetMemoryInfo() {
     MemoryStatusSnapshot memInfo;
     SystemCompat::QueryMemoryStatus(memInfo);
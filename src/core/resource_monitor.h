@@ -2,6 +2,7 @@
 #include <windows.h>
 #include <psapi.h>
 #include <string>
+#include <vector>
 #include "../platform/system_compat.h"
 
 // PDH 类型定义（动态加载，不依赖 pdh.h）
@@ -65,9 +66,16 @@ private:
     DWORD majorVersion;
     DWORD minorVersion;
 
+    // 每核占用（ntdll 动态加载，Windows 2000 起可用）
+    typedef LONG (WINAPI *PNtQuerySystemInformation)(int, PVOID, ULONG, PULONG);
+    PNtQuerySystemInformation pNtQuerySystemInformation;
+    std::vector<ULONGLONG> lastCoreIdle;
+    std::vector<ULONGLONG> lastCoreTotal;
+
     // 平滑值
     double lastCPUValue;
     double lastMemValue;
+    double lastRawCPUValue;
 
     // 平滑函数
     double SmoothValue(double newValue, double lastValue, double alpha = 0.3);
@@ -78,6 +86,11 @@ public:
 
     double GetCPUUsage();
     double GetMemoryUsage();
+    // 未平滑的原始值，供采样线程使用；内存查询失败时返回 -1
+    double GetCPUUsageRaw();
+    double GetMemoryUsageRaw();
+    // 各逻辑处理器自上次调用以来的占用，返回写入的个数（不可用时为 0）
+    int GetPerCoreCPUUsage(double* values, int maxCount);
     MemoryStatusSnapshot GetMemoryInfo();
     SYSTEM_INFO GetSysInfo();
 
@@ -0,0 +1,103 @@
+#include "resource_sampler.h"
+#include "resource_monitor.h"
+#include "overhead_meter.h"
+
+ResourceSampler::ResourceSampler(int hz)
+    : running(0), samplerThread(NULL), stopEvent(NULL), monitor(NULL),
+      rateHz(hz), lastMem(0) {
+    if (rateHz < 1) rateHz = 1;
+    if (rateHz > 100) rateHz = 100;
+    QueryPerformanceFrequency(&frequency);
+    stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+}
+
+ResourceSampler::~ResourceSampler() {
+    Stop();
+    if (stopEvent) CloseHandle(stopEvent);
+}
+
+void ResourceSampler::Start() {
+    if (InterlockedCompareExchange(&running, 1, 0) != 0) return;
+
+    if (!monitor) {
+        monitor = new ResourceMonitor();
+    }
+
+    // 先采一次建立 CPU 差分基线，再发布首个样本
+    monitor->GetCPUUsageRaw();
+    ResetEvent(stopEvent);
+
+    samplerThread = CreateThread(NULL, 0, SamplerThreadProc, this, 0, NULL);
+    if (!samplerThread) {
+        InterlockedExchange(&running, 0);
+        return;
+    }
+    // 采样本身很轻，提高优先级以免被负载线程挤掉时间片
+    SetThreadPriority(samplerThread, THREAD_PRIORITY_ABOVE_NORMAL);
+}
+
+void ResourceSampler::Stop() {
+    if (InterlockedCompareExchange(&running, 0, 1) != 1) return;
+
+    SetEvent(stopEvent);
+    // 采样线程还在用 monitor，必须等它真正退出后才能释放
+    if (samplerThread) {
+        WaitForSingleObject(samplerThread, INFINITE);
+        CloseHandle(samplerThread);
+        samplerThread = NULL;
+    }
+
+    delete monitor;
+    monitor = NULL;
+}
+
+DWORD WINAPI ResourceSampler::SamplerThreadProc(LPVOID lpParam) {
+    ResourceSampler* self = (ResourceSampler*)lpParam;
+    self->SamplerLoop();
+    return 0;
+}
+
+void ResourceSampler::SamplerLoop() {
+    LONG periodMs = 1000 / rateHz;
+    if (periodMs < 1) periodMs = 1;
+
+    // 周期性可等待定时器不会累积漂移；实际精度受系统时钟分辨率（通常 15.6ms）限制
+    HANDLE timer = CreateWaitableTimerA(NULL, FALSE, NULL);
+    if (timer) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)periodMs * 10000;
+        SetWaitableTimer(timer, &due, periodMs, NULL, NULL, FALSE);
+    }
+
+    HANDLE handles[2] = { stopEvent, timer };
+    while (running) {
+        DWORD result = timer ? WaitForMultipleObjects(2, handles, FALSE, INFINITE)
+                             : WaitForSingleObject(stopEvent, periodMs);
+        if (result == WAIT_OBJECT_0 || !running) break;
+        TakeSample();
+    }
+
+    if (timer) {
+        CancelWaitableTimer(timer);
+        CloseHandle(timer);
+    }
+}
+
+void ResourceSampler::TakeSample() {
+    OverheadScope overhead(OVERHEAD_SAMPLER);
+    SamplePoint point;
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (frequency.QuadPart > 0) {
+        // 拆成整秒与余数两部分换算，避免长时间运行后乘法溢出
+        point.timestampUs = now.QuadPart / frequency.QuadPart * 1000000 +
+                            now.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart;
+    }
+    point.cpu = monitor->GetCPUUsageRaw();
+
+    double mem = monitor->GetMemoryUsageRaw();
+    if (mem >= 0) lastMem = mem;
+    point.mem = lastMem;
+
+    ring.Publish(point);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include <stdint.h>
+#include "sample_ring.h"
+
+class ResourceMonitor;
+
+// 一次原始采样，时间戳为 QPC 换算的微秒
+struct SamplePoint {
+    int64_t timestampUs;
+    double cpu;
+    double mem;
+
+    SamplePoint() : timestampUs(0), cpu(0), mem(0) {}
+};
+
+// 约 40 秒的历史（100Hz 时），足够覆盖常见的采样周期
+#define SAMPLE_RING_CAPACITY 4096
+
+typedef SampleRing<SamplePoint, SAMPLE_RING_CAPACITY> SamplePointRing;
+
+// 高频采样线程 - 按固定频率读取未平滑的 CPU/内存占用发布到无锁环，
+// 控制器、控制台、导出器各自按游标读取原始样本，滤波方式由读取方决定
+class ResourceSampler {
+private:
+    volatile LONG running;
+    HANDLE samplerThread;
+    HANDLE stopEvent;
+    ResourceMonitor* monitor;   // 采样线程专用实例，差分状态不与主线程共享
+    int rateHz;
+    double lastMem;
+    LARGE_INTEGER frequency;
+
+    SamplePointRing ring;
+
+public:
+    ResourceSampler(int hz);
+    ~ResourceSampler();
+
+    void Start();
+    void Stop();
+    bool IsRunning() const { return running != 0; }
+    int GetRateHz() const { return rateHz; }
+
+    const SamplePointRing& GetRing() const { return ring; }
+    size_t ReadSince(DWORD& cursor, std::vector<SamplePoint>& out) const {
+        return ring.ReadSince(cursor, out);
+    }
+    bool ReadLatest(SamplePoint& out) const { return ring.ReadLatest(out); }
+
+private:
+    static DWORD WINAPI SamplerThreadProc(LPVOID lpParam);
+    void SamplerLoop();
+    void TakeSample();
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+
+// 单生产者多消费者的无锁环形缓冲区（每个槽位一个 seqlock）。
+// 生产者写槽位时序号先变奇数、写完变偶数；消费者拷贝前后序号一致且为偶数才算有效。
+// 每个消费者自带读取游标，互不影响；被覆盖的旧样本直接跳过，不阻塞生产者。
+template <typename T, DWORD Capacity>
+class SampleRing {
+private:
+    struct Slot {
+        volatile LONG seq;
+        DWORD index;    // 槽位中样本的全局序号，用于识别已被覆盖的槽位
+        T value;
+    };
+
+    Slot slots[Capacity];
+    volatile LONG published;  // 已发布的样本总数
+
+    // 容量必须是 2 的幂
+    typedef char CapacityMustBePowerOfTwo[(Capacity & (Capacity - 1)) == 0 ? 1 : -1];
+
+public:
+    SampleRing() : published(0) {
+        for (DWORD i = 0; i < Capacity; ++i) {
+            slots[i].seq = 0;
+            slots[i].index = 0;
+        }
+    }
+
+    // 仅允许一个线程调用
+    void Publish(const T& value) {
+        DWORD index = (DWORD)published;
+        Slot& slot = slots[index & (Capacity - 1)];
+
+        InterlockedIncrement(&slot.seq);
+        slot.index = index;
+        slot.value = value;
+        InterlockedIncrement(&slot.seq);
+
+        InterlockedExchange(&published, (LONG)(index + 1));
+    }
+
+    DWORD GetPublished() const {
+        DWORD count = (DWORD)published;
+        MemoryBarrier();
+        return count;
+    }
+
+    // 读取游标之后新发布的样本追加到 out，返回读取个数，并把游标推进到最新位置。
+    // 超出容量的旧样本已被覆盖，直接从仍在环内的最旧样本开始
+    size_t ReadSince(DWORD& cursor, std::vector<T>& out) const {
+        DWORD end = GetPublished();
+        if (end - cursor > Capacity) {
+            cursor = end - Capacity;
+        }
+
+        size_t count = 0;
+        for (DWORD i = cursor; i != end; ++i) {
+            T copy;
+            if (ReadSlot(i, copy)) {
+                out.push_back(copy);
+                ++count;
+            }
+        }
+        cursor = end;
+        return count;
+    }
+
+    // 最近一个样本
+    bool ReadLatest(T& out) const {
+        DWORD end = GetPublished();
+        if (end == 0) return false;
+        return ReadSlot(end - 1, out);
+    }
+
+private:
+    bool ReadSlot(DWORD index, T& out) const {
+        const Slot& slot = slots[index & (Capacity - 1)];
+
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            LONG before = slot.seq;
+            MemoryBarrier();
+            if (before & 1) {
+                YieldProcessor();
+                continue;
+            }
+
+            DWORD slotIndex = slot.index;
+            out = slot.value;
+            MemoryBarrier();
+
+            if (slot.seq == before) {
+                return slotIndex == index;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,202 @@
+#include "telemetry_log.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TELEMETRY_HEADER_BYTES 4096
+
+namespace {
+
+const char kTelemetryMagic[8] = { 'M', 'B', 'T', 'L', 'O', 'G', 0, 0 };
+
+void WriteFlag(FILE* out, uint32_t flags, uint32_t bit) {
+    fprintf(out, ",%d", (flags & bit) ? 1 : 0);
+}
+
+} // namespace
+
+TelemetryLog::TelemetryLog()
+    : file(INVALID_HANDLE_VALUE), mapping(NULL), header(NULL), records(NULL) {
+}
+
+TelemetryLog::~TelemetryLog() {
+    Close();
+}
+
+uint64_t TelemetryLog::NowMs() {
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    // FILETIME 以 1601 年为起点、100ns 为单位
+    return (ticks - 116444736000000000ULL) / 10000;
+}
+
+bool TelemetryLog::MapFile(uint64_t fileSize) {
+    mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                 (DWORD)(fileSize >> 32), (DWORD)(fileSize & 0xFFFFFFFF), NULL);
+    if (!mapping) return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)fileSize);
+    if (!view) return false;
+    header = (TelemetryHeader*)view;
+    records = (TelemetryRecord*)((char*)view + TELEMETRY_HEADER_BYTES);
+    return true;
+}
+
+bool TelemetryLog::Open(const std::string& filePath, int maxMB) {
+    Close();
+    if (maxMB < 1) maxMB = 1;
+
+    path = filePath;
+    uint64_t capacity = ((uint64_t)maxMB * 1024 * 1024 - TELEMETRY_HEADER_BYTES) / sizeof(TelemetryRecord);
+    uint64_t fileSize = TELEMETRY_HEADER_BYTES + capacity * sizeof(TelemetryRecord);
+
+    // 已有文件格式或容量不同时保留为 .old，不直接覆盖可能还要用于排查的数据
+    FILE* existing = NULL;
+    if (fopen_s(&existing, filePath.c_str(), "rb") == 0 && existing) {
+        TelemetryHeader old;
+        bool compatible = fread(&old, sizeof(old), 1, existing) == 1 &&
+                          memcmp(old.magic, kTelemetryMagic, sizeof(kTelemetryMagic)) == 0 &&
+                          old.version == TELEMETRY_VERSION &&
+                          old.recordSize == sizeof(TelemetryRecord) &&
+                          old.capacity == capacity;
+        fclose(existing);
+        if (!compatible) {
+            std::string oldPath = filePath + ".old";
+            MoveFileExA(filePath.c_str(), oldPath.c_str(), MOVEFILE_REPLACE_EXISTING);
+        }
+    }
+
+    file = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                       OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    if (!MapFile(fileSize)) {
+        Close();
+        return false;
+    }
+
+    // 新文件（或改名后重建的文件）映射后内容全为 0
+    if (memcmp(header->magic, kTelemetryMagic, sizeof(kTelemetryMagic)) != 0) {
+        memcpy(header->magic, kTelemetryMagic, sizeof(kTelemetryMagic));
+        header->version = TELEMETRY_VERSION;
+        header->recordSize = sizeof(TelemetryRecord);
+        header->capacity = capacity;
+        header->written = 0;
+        header->createdMs = NowMs();
+    }
+    return true;
+}
+
+void TelemetryLog::Close() {
+    if (header) {
+        FlushViewOfFile(header, 0);
+        UnmapViewOfFile(header);
+        header = NULL;
+        records = NULL;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = NULL;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+}
+
+void TelemetryLog::Append(const TelemetryRecord& record) {
+    if (!header) return;
+    // 先写记录再推进计数，进程中途退出时最多丢失正在写的这一条
+    uint64_t index = header->written;
+    records[index % header->capacity] = record;
+    header->written = index + 1;
+}
+
+int TelemetryLog::DumpCsv(const std::string& filePath, const std::string& csvPath) {
+    FILE* in = NULL;
+    if (fopen_s(&in, filePath.c_str(), "rb") != 0 || !in) {
+        fprintf(stderr, "cannot open %s\n", filePath.c_str());
+        return 1;
+    }
+
+    TelemetryHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, kTelemetryMagic, sizeof(kTelemetryMagic)) != 0) {
+        fprintf(stderr, "%s is not a telemetry log\n", filePath.c_str());
+        fclose(in);
+        return 1;
+    }
+    if (header.version != TELEMETRY_VERSION || header.recordSize != sizeof(TelemetryRecord) ||
+        header.capacity == 0) {
+        fprintf(stderr, "unsupported telemetry log version %u (record size %u)\n",
+                header.version, header.recordSize);
+        fclose(in);
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (!csvPath.empty() && (fopen_s(&out, csvPath.c_str(), "w") != 0 || !out)) {
+        fprintf(stderr, "cannot write %s\n", csvPath.c_str());
+        fclose(in);
+        return 1;
+    }
+
+    fprintf(out, "time_ms,time_utc,cpu_total,cpu_other,cpu_worker,cpu_forecast,cpu_threshold,cpu_intensity,"
+                 "mem_total,mem_other,mem_worker,mem_forecast,mem_threshold,"
+                 "target_bytes,allocated_bytes,resident_bytes,"
+                 "cpu_starts,cpu_stops,mem_starts,mem_stops,"
+                 "cpu_active,mem_active,cpu_running,mem_running,cpu_preemptive,mem_preemptive,"
+                 "cpu_quantile,mem_quantile,cpu_paused,mem_paused,mem_pressure\n");
+
+    // 环未写满时从 0 开始，写满后从最旧的一条（下一个写入位置）开始
+    uint64_t count = header.written < header.capacity ? header.written : header.capacity;
+    uint64_t first = header.written < header.capacity ? 0 : header.written % header.capacity;
+
+    // telemetry_max_mb 不超过 1024，偏移量在 long 范围内
+    fseek(in, (long)(TELEMETRY_HEADER_BYTES + first * sizeof(TelemetryRecord)), SEEK_SET);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (first + i == header.capacity) {
+            fseek(in, TELEMETRY_HEADER_BYTES, SEEK_SET);
+        }
+        TelemetryRecord r;
+        if (fread(&r, sizeof(r), 1, in) != 1) break;
+
+        uint64_t ticks = r.timeMs * 10000 + 116444736000000000ULL;
+        FILETIME ft;
+        ft.dwLowDateTime = (DWORD)(ticks & 0xFFFFFFFF);
+        ft.dwHighDateTime = (DWORD)(ticks >> 32);
+        SYSTEMTIME utc;
+        char stamp[32] = "";
+        if (FileTimeToSystemTime(&ft, &utc)) {
+            snprintf(stamp, sizeof(stamp), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+                     utc.wYear, utc.wMonth, utc.wDay,
+                     utc.wHour, utc.wMinute, utc.wSecond, utc.wMilliseconds);
+        }
+
+        fprintf(out, "%llu,%s,%.2f,%.2f,%.2f,%.2f,%u,%u,%.2f,%.2f,%.2f,%.2f,%u,%lld,%lld,%lld,%u,%u,%u,%u",
+                (unsigned long long)r.timeMs, stamp,
+                r.cpuTotal, r.cpuOther, r.cpuWorker, r.cpuForecast, r.cpuThreshold, r.cpuIntensity,
+                r.memTotal, r.memOther, r.memWorker, r.memForecast, r.memThreshold,
+                (long long)r.targetBytes, (long long)r.allocatedBytes, (long long)r.residentBytes,
+                r.cpuStarts, r.cpuStops, r.memStarts, r.memStops);
+        WriteFlag(out, r.flags, TELEMETRY_CPU_ACTIVE);
+        WriteFlag(out, r.flags, TELEMETRY_MEM_ACTIVE);
+        WriteFlag(out, r.flags, TELEMETRY_CPU_RUNNING);
+        WriteFlag(out, r.flags, TELEMETRY_MEM_RUNNING);
+        WriteFlag(out, r.flags, TELEMETRY_CPU_PREEMPTIVE);
+        WriteFlag(out, r.flags, TELEMETRY_MEM_PREEMPTIVE);
+        WriteFlag(out, r.flags, TELEMETRY_CPU_QUANTILE);
+        WriteFlag(out, r.flags, TELEMETRY_MEM_QUANTILE);
+        WriteFlag(out, r.flags, TELEMETRY_CPU_PAUSED);
+        WriteFlag(out, r.flags, TELEMETRY_MEM_PAUSED);
+        WriteFlag(out, r.flags, TELEMETRY_MEM_PRESSURE);
+        fprintf(out, "\n");
+    }
+
+    fclose(in);
+    if (out != stdout) fclose(out);
+    fprintf(stderr, "%llu records (%llu written, capacity %llu)\n",
+            (unsigned long long)count, (unsigned long long)header.written,
+            (unsigned long long)header.capacity);
+    return 0;
+}
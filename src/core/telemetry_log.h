@@ -0,0 +1,91 @@
+#pragma once
+#include <windows.h>
+#include <stdint.h>
+#include <string>
+
+#define TELEMETRY_VERSION 1
+
+// 决策标志位
+#define TELEMETRY_CPU_ACTIVE      0x0001  // 门限处于填充状态
+#define TELEMETRY_MEM_ACTIVE      0x0002
+#define TELEMETRY_CPU_RUNNING     0x0004
+#define TELEMETRY_MEM_RUNNING     0x0008
+#define TELEMETRY_CPU_PREEMPTIVE  0x0010  // 本轮按预测提前让出
+#define TELEMETRY_MEM_PREEMPTIVE  0x0020
+#define TELEMETRY_CPU_QUANTILE    0x0040  // 本轮为维持分位数补负载
+#define TELEMETRY_MEM_QUANTILE    0x0080
+#define TELEMETRY_CPU_PAUSED      0x0100
+#define TELEMETRY_MEM_PAUSED      0x0200
+#define TELEMETRY_MEM_PRESSURE    0x0400  // 系统处于低内存状态
+
+// 每个采样周期一条，固定 80 字节；字段按自然对齐排列，文件内不需要额外打包
+struct TelemetryRecord {
+    uint64_t timeMs;           // UTC，自 1970 年起的毫秒数
+    int64_t targetBytes;
+    int64_t allocatedBytes;
+    int64_t residentBytes;
+    float cpuTotal;
+    float cpuOther;
+    float cpuWorker;
+    float memTotal;
+    float memOther;
+    float memWorker;
+    float cpuForecast;
+    float memForecast;
+    uint16_t cpuStarts;        // 门限累计启停次数，相邻记录之差即本轮的决策
+    uint16_t cpuStops;
+    uint16_t memStarts;
+    uint16_t memStops;
+    uint8_t cpuIntensity;
+    uint8_t cpuThreshold;
+    uint8_t memThreshold;
+    uint8_t reserved;
+    uint32_t flags;
+};
+
+// 文件头占第一页，之后是 capacity 条记录组成的环
+struct TelemetryHeader {
+    char magic[8];             // "MBTLOG\0\0"
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    volatile uint64_t written; // 累计写入条数，下一条写到 written % capacity
+    uint64_t createdMs;
+};
+
+// 二进制遥测日志：文件按 max_mb 预先分配并整体映射，写满后覆盖最旧的记录，
+// 控制线程每轮只做一次内存拷贝，由系统在后台把脏页写回文件
+class TelemetryLog {
+private:
+    HANDLE file;
+    HANDLE mapping;
+    TelemetryHeader* header;
+    TelemetryRecord* records;
+    std::string path;
+
+public:
+    TelemetryLog();
+    ~TelemetryLog();
+
+    // 已有文件的格式和容量一致时接着写，否则把旧文件改名为 .old 后重建
+    bool Open(const std::string& filePath, int maxMB);
+    void Close();
+    bool IsOpen() const { return header != NULL; }
+
+    // 仅控制线程调用
+    void Append(const TelemetryRecord& record);
+
+    const std::string& GetPath() const { return path; }
+    uint64_t GetWritten() const { return header ? header->written : 0; }
+    uint64_t GetCapacity() const { return header ? header->capacity : 0; }
+
+    static uint64_t NowMs();
+    // 离线工具：按时间顺序把环中的记录转成 CSV，csvPath 为空时输出到标准输出
+    static int DumpCsv(const std::string& filePath, const std::string& csvPath);
+
+private:
+    bool MapFile(uint64_t fileSize);
+
+    TelemetryLog(const TelemetryLog&);
+    TelemetryLog& operator=(const TelemetryLog&);
+};
@@ -0,0 +1,242 @@
+#include "trace_recorder.h"
+#include <stdio.h>
+#include <cmath>
+#include <map>
+#include <new>
+#include <vector>
+
+// 线程退出后缓冲区先保留以便导出，总数达到该值后才复用已退出线程的缓冲区
+#define TRACE_MAX_BUFFERS 64
+
+volatile LONG TraceRecorder::enabled = 0;
+
+namespace {
+
+// 0 未初始化，1 初始化中，2 就绪；锁和 TLS 槽在第一次使用时创建，进程结束前不释放
+volatile LONG g_traceInitState = 0;
+CRITICAL_SECTION g_traceLock;
+DWORD g_traceTls = TLS_OUT_OF_INDEXES;
+LONGLONG g_traceBaseTicks = 0;
+
+// 以下由 g_traceLock 保护
+std::vector<TraceThreadBuffer*> g_traceBuffers;
+std::map<DWORD, const char*> g_traceThreadNames;
+
+bool EnsureTraceInit() {
+    if (g_traceInitState == 2) return g_traceTls != TLS_OUT_OF_INDEXES;
+    if (InterlockedCompareExchange(&g_traceInitState, 1, 0) == 0) {
+        InitializeCriticalSection(&g_traceLock);
+        g_traceTls = TlsAlloc();
+        InterlockedExchange(&g_traceInitState, 2);
+    } else {
+        while (g_traceInitState != 2) Sleep(0);
+    }
+    return g_traceTls != TLS_OUT_OF_INDEXES;
+}
+
+struct TraceSnapshot {
+    DWORD threadId;
+    const char* threadName;
+    std::vector<TraceEvent> events;
+};
+
+void WriteJsonString(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const char* p = text; *p; ++p) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            fputc('\\', out);
+            fputc(c, out);
+        } else if (c >= 0x20) {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+} // namespace
+
+bool TraceRecorder::Start() {
+    if (!EnsureTraceInit()) return false;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    EnterCriticalSection(&g_traceLock);
+    g_traceBaseTicks = now.QuadPart;
+    for (size_t i = 0; i < g_traceBuffers.size(); ++i) {
+        g_traceBuffers[i]->startCursor = g_traceBuffers[i]->ring.GetPublished();
+    }
+    LeaveCriticalSection(&g_traceLock);
+
+    InterlockedExchange(&enabled, 1);
+    return true;
+}
+
+void TraceRecorder::Stop() {
+    InterlockedExchange(&enabled, 0);
+}
+
+void TraceRecorder::SetThreadName(const char* name) {
+    if (!EnsureTraceInit()) return;
+    EnterCriticalSection(&g_traceLock);
+    g_traceThreadNames[GetCurrentThreadId()] = name;
+    TraceThreadBuffer* buffer = (TraceThreadBuffer*)TlsGetValue(g_traceTls);
+    if (buffer) buffer->threadName = name;
+    LeaveCriticalSection(&g_traceLock);
+}
+
+void TraceRecorder::ReleaseThread() {
+    if (g_traceInitState != 2 || g_traceTls == TLS_OUT_OF_INDEXES) return;
+    EnterCriticalSection(&g_traceLock);
+    g_traceThreadNames.erase(GetCurrentThreadId());
+    TraceThreadBuffer* buffer = (TraceThreadBuffer*)TlsGetValue(g_traceTls);
+    if (buffer) {
+        InterlockedExchange(&buffer->retired, 1);
+        TlsSetValue(g_traceTls, NULL);
+    }
+    LeaveCriticalSection(&g_traceLock);
+}
+
+TraceThreadBuffer* TraceRecorder::GetThreadBuffer() {
+    if (g_traceInitState != 2 || g_traceTls == TLS_OUT_OF_INDEXES) return NULL;
+    TraceThreadBuffer* buffer = (TraceThreadBuffer*)TlsGetValue(g_traceTls);
+    if (buffer) return buffer;
+
+    // 每个线程只在第一次记录时进锁
+    DWORD threadId = GetCurrentThreadId();
+    EnterCriticalSection(&g_traceLock);
+    if (g_traceBuffers.size() >= TRACE_MAX_BUFFERS) {
+        for (size_t i = 0; i < g_traceBuffers.size(); ++i) {
+            if (g_traceBuffers[i]->retired) {
+                buffer = g_traceBuffers[i];
+                break;
+            }
+        }
+    }
+    if (!buffer) {
+        buffer = new (std::nothrow) TraceThreadBuffer();
+        if (buffer) g_traceBuffers.push_back(buffer);
+    }
+    if (buffer) {
+        std::map<DWORD, const char*>::const_iterator it = g_traceThreadNames.find(threadId);
+        buffer->threadId = threadId;
+        buffer->threadName = it != g_traceThreadNames.end() ? it->second : NULL;
+        buffer->startCursor = buffer->ring.GetPublished();
+        InterlockedExchange(&buffer->retired, 0);
+        TlsSetValue(g_traceTls, buffer);
+    }
+    LeaveCriticalSection(&g_traceLock);
+    return buffer;
+}
+
+void TraceRecorder::Record(char phase, const char* name, const char* detail, double value) {
+    TraceThreadBuffer* buffer = GetThreadBuffer();
+    if (!buffer) return;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    TraceEvent event;
+    event.ticks = now.QuadPart;
+    event.name = name;
+    event.detail = detail;
+    event.value = value;
+    event.phase = phase;
+    buffer->ring.Publish(event);
+}
+
+void TraceRecorder::Begin(const char* name, const char* detail, double value) {
+    if (!enabled) return;
+    Record('B', name, detail, value);
+}
+
+void TraceRecorder::End(const char* name) {
+    // 不检查 enabled：区间开始后关闭跟踪也要补上结束事件
+    Record('E', name, NULL, 0);
+}
+
+int TraceRecorder::WriteChromeJson(const std::string& path) {
+    if (!EnsureTraceInit()) return -1;
+
+    // 先在锁内拷出所有事件，写文件时不阻塞新线程创建缓冲区
+    std::vector<TraceSnapshot> snapshots;
+    LONGLONG baseTicks = 0;
+    EnterCriticalSection(&g_traceLock);
+    baseTicks = g_traceBaseTicks;
+    snapshots.resize(g_traceBuffers.size());
+    for (size_t i = 0; i < g_traceBuffers.size(); ++i) {
+        TraceThreadBuffer* buffer = g_traceBuffers[i];
+        DWORD cursor = buffer->startCursor;
+        snapshots[i].threadId = buffer->threadId;
+        snapshots[i].threadName = buffer->threadName;
+        buffer->ring.ReadSince(cursor, snapshots[i].events);
+    }
+    LeaveCriticalSection(&g_traceLock);
+
+    LARGE_INTEGER frequency, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    double usPerTick = 1000000.0 / (double)frequency.QuadPart;
+    double endUs = (now.QuadPart - baseTicks) * usPerTick;
+
+    FILE* out = NULL;
+    if (fopen_s(&out, path.c_str(), "w") != 0 || !out) return -1;
+
+    DWORD pid = GetCurrentProcessId();
+    int written = 0;
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":0,\"args\":{\"name\":\"MikaBooM\"}}",
+            (unsigned long)pid);
+
+    for (size_t i = 0; i < snapshots.size(); ++i) {
+        const TraceSnapshot& snapshot = snapshots[i];
+        if (snapshot.events.empty()) continue;
+        unsigned long tid = (unsigned long)snapshot.threadId;
+
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":",
+                (unsigned long)pid, tid);
+        WriteJsonString(out, snapshot.threadName ? snapshot.threadName : "thread");
+        fprintf(out, "}}");
+
+        // 环被覆盖或中途开启时开头可能有孤立的结束事件，跳过；
+        // 导出时仍未结束的区间在导出时刻补上结束事件
+        std::vector<const char*> open;
+        for (size_t e = 0; e < snapshot.events.size(); ++e) {
+            const TraceEvent& event = snapshot.events[e];
+            double ts = (event.ticks - baseTicks) * usPerTick;
+            if (event.phase == 'E') {
+                if (open.empty()) continue;
+                open.pop_back();
+                fprintf(out, ",\n{\"name\":");
+                WriteJsonString(out, event.name);
+                fprintf(out, ",\"ph\":\"E\",\"ts\":%.3f,\"pid\":%lu,\"tid\":%lu}", ts, (unsigned long)pid, tid);
+            } else {
+                open.push_back(event.name);
+                fprintf(out, ",\n{\"name\":");
+                WriteJsonString(out, event.name);
+                fprintf(out, ",\"cat\":\"mikaboom\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":%lu,\"tid\":%lu,\"args\":{\"value\":",
+                        ts, (unsigned long)pid, tid);
+                // JSON 没有 nan/inf，非有限值写成 null
+                if (std::isfinite(event.value)) fprintf(out, "%g", event.value);
+                else fprintf(out, "null");
+                if (event.detail) {
+                    fprintf(out, ",\"detail\":");
+                    WriteJsonString(out, event.detail);
+                }
+                fprintf(out, "}}");
+            }
+            ++written;
+        }
+        while (!open.empty()) {
+            fprintf(out, ",\n{\"name\":");
+            WriteJsonString(out, open.back());
+            fprintf(out, ",\"ph\":\"E\",\"ts\":%.3f,\"pid\":%lu,\"tid\":%lu}", endUs, (unsigned long)pid, tid);
+            open.pop_back();
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+    bool ok = ferror(out) == 0;
+    fclose(out);
+    return ok ? written : -1;
+}
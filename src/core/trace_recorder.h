@@ -0,0 +1,72 @@
+#pragma once
+#include <windows.h>
+#include <string>
+#include "sample_ring.h"
+
+#define TRACE_EVENTS_PER_THREAD 8192
+
+// 一条 begin/end 事件；name/detail 必须是字符串常量或生命周期覆盖整个进程的字符串
+struct TraceEvent {
+    LONGLONG ticks;        // QueryPerformanceCounter
+    const char* name;
+    const char* detail;
+    double value;
+    char phase;            // 'B' 或 'E'
+};
+
+// 每个线程一个缓冲区，由 TLS 找到；只有所属线程写入，导出时按 seqlock 读取，写入路径不加锁
+struct TraceThreadBuffer {
+    DWORD threadId;
+    const char* threadName;
+    volatile LONG retired;     // 所属线程已退出，缓冲区数量较多时可复用
+    DWORD startCursor;         // Start 时的发布位置，导出只取之后的事件
+    SampleRing<TraceEvent, TRACE_EVENTS_PER_THREAD> ring;
+};
+
+// 线程级跟踪：记录工作线程的忙/睡、分配、触页、刷新以及控制器调整，
+// 导出为 Chrome trace-event JSON（chrome://tracing 或 Perfetto 打开）。
+// 关闭时每个埋点只读一次 enabled
+class TraceRecorder {
+private:
+    static volatile LONG enabled;
+
+public:
+    static bool IsEnabled() { return enabled != 0; }
+
+    // 仅控制线程调用
+    static bool Start();
+    static void Stop();
+    // 导出当前所有缓冲区，返回写出的事件数，失败返回 -1
+    static int WriteChromeJson(const std::string& path);
+
+    static void Begin(const char* name, const char* detail = NULL, double value = 0);
+    static void End(const char* name);
+
+    // 线程入口和退出处调用；名字为字符串常量
+    static void SetThreadName(const char* name);
+    static void ReleaseThread();
+
+private:
+    static TraceThreadBuffer* GetThreadBuffer();
+    static void Record(char phase, const char* name, const char* detail, double value);
+};
+
+// 作用域内记录一个区间；构造时跟踪未开启则析构也不记录，保证 B/E 成对
+class TraceScope {
+private:
+    const char* name;
+    bool active;
+
+public:
+    explicit TraceScope(const char* scopeName, const char* detail = NULL, double value = 0)
+        : name(scopeName), active(TraceRecorder::IsEnabled()) {
+        if (active) TraceRecorder::Begin(name, detail, value);
+    }
+    ~TraceScope() {
+        if (active) TraceRecorder::End(name);
+    }
+
+private:
+    TraceScope(const TraceScope&);
+    TraceScope& operator=(const TraceScope&);
+};
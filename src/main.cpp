@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -17,6 +18,21 @@
 #include "core/config_manager.h"
 #include "core/cpu_worker.h"
 #include "core/memory_worker.h"
+#include "core/bandwidth_worker.h"
+#include "core/io_worker.h"
+#include "core/network_worker.h"
+#include "core/resource_adapters.h"
+#include "core/resource_sampler.h"
+#include "core/load_estimator.h"
+#include "core/controller_sim.h"
+#include "core/load_bench.h"
+#include "core/micro_bench.h"
+#include "core/metrics_exporter.h"
+#include "core/control_server.h"
+#include "core/telemetry_log.h"
+#include "core/trace_recorder.h"
+#include "core/overhead_meter.h"
+#include "core/instance_coordinator.h"
 #include "platform/system_tray.h"
 #include "platform/autostart.h"
 #include "utils/console_utils.h"
@@ -33,33 +49,92 @@
 #pragma comment(lib, "psapi.lib")
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "wininet.lib")
+#pragma comment(lib, "ws2_32.lib")
 // pdh.dll 通过 LoadLibrary 动态加载，无需静态链接
 #endif
 
 volatile LONG g_running = 1;
 volatile LONG g_show_window = 1;
+// 无人值守模式：不建托盘、不写自启动、不检查更新，输出改为 logfmt 结构化日志
+bool g_headless = false;
+std::string g_pidfile_path;
 
 ConfigManager* g_config = nullptr;
 ResourceMonitor* g_monitor = nullptr;
 CPUWorker* g_cpu_worker = nullptr;
 MemoryWorker* g_memory_worker = nullptr;
+BandwidthWorker* g_bandwidth_worker = nullptr;
+IOWorker* g_io_worker = nullptr;
+NetworkWorker* g_network_worker = nullptr;
+ResourceSampler* g_sampler = nullptr;
+MetricsExporter* g_metrics = nullptr;
+ControlServer* g_control = nullptr;
+TelemetryLog* g_telemetry = nullptr;
+InstanceCoordinator* g_coordinator = nullptr;
+InstancePresence g_presence;  // 同机同名实例探测，决定按名字独占的资源改名或关闭
+std::string g_trace_path;  // -trace 指定时启动即开始跟踪，退出时写出
+DWORD g_start_tick = 0;
 SystemTray* g_tray = nullptr;
 DWORD g_last_mem_notice_tick = 0;
+LONG g_last_emergency_count = 0;
+bool g_overhead_alarm = false;
+
+// 主循环的唤醒源：退出事件（手动重置）与立即采样事件（自动重置，配置变化等场景使用）
+HANDLE g_shutdown_event = NULL;
+HANDLE g_wake_event = NULL;
+HANDLE g_cleanup_done_event = NULL;  // 主线程清理完成，不关闭，控制台处理函数可能仍在等待
 
 BOOL WINAPI ConsoleHandler(DWORD signal) {
-    if (signal == CTRL_C_EVENT || signal == CTRL_CLOSE_EVENT || signal == CTRL_BREAK_EVENT) {
+    // 作为服务运行时系统关机只会收到 CTRL_SHUTDOWN_EVENT；注销事件对服务进程无意义，不处理
+    if (signal == CTRL_C_EVENT || signal == CTRL_CLOSE_EVENT || signal == CTRL_BREAK_EVENT ||
+        (g_headless && signal == CTRL_SHUTDOWN_EVENT)) {
         InterlockedExchange(&g_running, 0);
-        
-        // 立即停止工作线程
-        if (g_cpu_worker) g_cpu_worker->Stop();
-        if (g_memory_worker) g_memory_worker->Stop();
-        
-        Sleep(100);  // 给一点时间清理
+        if (g_shutdown_event) SetEvent(g_shutdown_event);
+
+        // 工作者由主线程的清理路径统一停止和释放，这里只发出通知，
+        // 避免与仍在调节工作者的控制线程并发 Stop；
+        // 关闭控制台和关机时处理函数一返回进程就会被结束，等主线程清理完
+        if ((signal == CTRL_CLOSE_EVENT || signal == CTRL_SHUTDOWN_EVENT) && g_cleanup_done_event) {
+            WaitForSingleObject(g_cleanup_done_event, INFINITE);
+        }
         return TRUE;
     }
     return FALSE;
 }
 
+std::string GetExecutableDirectory() {
+    char buffer[MAX_PATH];
+    GetModuleFileNameA(NULL, buffer, MAX_PATH);
+    std::string exe_path(buffer);
+    size_t pos = exe_path.find_last_of("\\/");
+    return pos == std::string::npos ? std::string(".") : exe_path.substr(0, pos);
+}
+
+// 程序目录下按 coordination_name 命名的文件，不同名字的实例互不冲突
+std::string GetInstanceFilePath(const std::string& suffix) {
+    return GetExecutableDirectory() + "\\" + g_config->GetCoordinationName() + suffix;
+}
+
+// 遥测日志默认放在程序目录
+std::string GetTelemetryPath() {
+    if (!g_config->GetTelemetryFile().empty()) return g_config->GetTelemetryFile();
+    return GetInstanceFilePath(".telemetry.bin");
+}
+
+int RunControlClient(const std::string& command) {
+    std::string reply;
+    if (!ControlServer::Send(g_config->GetControlPipe(), command, reply)) {
+        ConsoleUtils::PrintError(
+            ConsoleUtils::UseLocalizedText() ?
+            "无法连接控制管道 %s，程序是否正在运行且已开启 control_enabled？" :
+            "Cannot connect to control pipe %s, is MikaBooM running with control_enabled=true?",
+            ControlServer::GetFullPipeName(g_config->GetControlPipe()).c_str());
+        return 1;
+    }
+    printf("%s", reply.c_str());
+    return reply.compare(0, 2, "ok") == 0 ? 0 : 1;
+}
+
 void ParseCommandLine(int argc, char* argv[]) {
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -72,6 +147,79 @@ void ParseCommandLine(int argc, char* argv[]) {
             ConsoleUtils::ShowVersion();
             exit(0);
         }
+        // 估计器回放对比（可选轨迹文件）
+        else if (arg == "-replay-estimator") {
+            ConsoleUtils::Init();
+            std::string trace;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                trace = argv[++i];
+            }
+            exit(RunEstimatorReplay(trace, g_config->GetUpdateInterval()));
+        }
+        // 控制器离线仿真（可选轨迹文件），其后的 -sim-* 参数仅在此模式下生效
+        else if (arg == "-simulate") {
+            ConsoleUtils::Init();
+            SimulationOptions options;
+            options.tickSec = (double)g_config->GetUpdateInterval();
+            options.confirmCount = SystemInfo::IsWindows7OrLater() ? 2 : 3;
+            options.forecastHorizon = g_config->GetForecastHorizon();
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.traceFile = argv[++i];
+            }
+            for (int j = i + 1; j + 1 < argc; j += 2) {
+                std::string name = argv[j];
+                if (name == "-sim-hours") options.hours = atof(argv[j + 1]);
+                else if (name == "-sim-lag") options.lagSec = atof(argv[j + 1]);
+                else if (name == "-sim-noise") options.noise = atof(argv[j + 1]);
+                else if (name == "-sim-seed") options.seed = (unsigned int)atoi(argv[j + 1]);
+                else if (name == "-sim-resource") options.resource = argv[j + 1];
+                else if (name == "-sim-memory-mb") options.memoryMB = atoi(argv[j + 1]);
+                else break;
+            }
+            options.threshold = options.resource == "mem" ? g_config->GetMemoryThreshold()
+                                                          : g_config->GetCPUThreshold();
+            exit(RunControllerSimulation(options));
+        }
+        // 控制精度基准：以子进程运行 MikaBooM 和脚本化竞争负载，阈值取当前配置
+        else if (arg == "-bench-load") {
+            ConsoleUtils::Init();
+            LoadBenchOptions options;
+            options.cpuThreshold = g_config->GetCPUThreshold();
+            options.memoryThreshold = g_config->GetMemoryThreshold();
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.profile = argv[++i];
+            }
+            for (int j = i + 1; j + 1 < argc; j += 2) {
+                std::string name = argv[j];
+                if (name == "-bench-seconds") options.seconds = atoi(argv[j + 1]);
+                else if (name == "-bench-warmup") options.warmupSeconds = atoi(argv[j + 1]);
+                else if (name == "-bench-hz") options.sampleHz = atoi(argv[j + 1]);
+                else if (name == "-bench-out") options.outputPath = argv[j + 1];
+                else break;
+            }
+            exit(RunLoadBenchmark(options));
+        }
+        // 热点路径微基准（可选输出文件），-bench-baseline 给出基线时逐项对比
+        else if (arg == "-bench") {
+            ConsoleUtils::Init();
+            MicroBenchOptions options;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.outputPath = argv[++i];
+            }
+            for (int j = i + 1; j + 1 < argc; j += 2) {
+                std::string name = argv[j];
+                if (name == "-bench-baseline") options.baselinePath = argv[j + 1];
+                else if (name == "-bench-tolerance") options.tolerancePercent = atof(argv[j + 1]);
+                else if (name == "-bench-mem-mb") options.memoryMB = atoi(argv[j + 1]);
+                else break;
+            }
+            exit(MicroBenchmark::Run(options));
+        }
+        // 基准使用的竞争负载子进程
+        else if (arg == "-fake-load" && i + 2 < argc) {
+            std::string profile = argv[i + 1];
+            exit(RunFakeLoad(profile, atoi(argv[i + 2])));
+        }
         // 一键更新（检测+下载+安装）
         else if (arg == "-update") {
             ConsoleUtils::Init();
@@ -83,11 +231,11 @@ void ParseCommandLine(int argc, char* argv[]) {
             ConsoleUtils::Init();
             if (AutoStart::Enable()) {
                 ConsoleUtils::PrintSuccess(
-                    ConsoleUtils::IsWindows7OrLater() ?
+                    ConsoleUtils::UseLocalizedText() ?
                     "自启动已启用" : "Auto-start enabled");
             } else {
                 ConsoleUtils::PrintError(
-                    ConsoleUtils::IsWindows7OrLater() ?
+                    ConsoleUtils::UseLocalizedText() ?
                     "启用自启动失败" : "Failed to enable auto-start");
             }
             exit(0);
@@ -96,15 +244,83 @@ void ParseCommandLine(int argc, char* argv[]) {
             ConsoleUtils::Init();
             if (AutoStart::Disable()) {
                 ConsoleUtils::PrintSuccess(
-                    ConsoleUtils::IsWindows7OrLater() ?
+                    ConsoleUtils::UseLocalizedText() ?
                     "自启动已禁用" : "Auto-start disabled");
             } else {
                 ConsoleUtils::PrintError(
-                    ConsoleUtils::IsWindows7OrLater() ?
+                    ConsoleUtils::UseLocalizedText() ?
                     "禁用自启动失败" : "Failed to disable auto-start");
             }
             exit(0);
         }
+        else if (arg == "-quantile" && i + 1 < argc) {
+            // 0 关闭分位数目标（包括状态文件的读写）
+            int level = atoi(argv[++i]);
+            g_config->SetQuantileEnabled(level > 0);
+            if (level > 0) g_config->SetQuantileCpuLevel(level);
+        }
+        else if (arg == "-quantile-p" && i + 1 < argc) {
+            g_config->SetQuantilePercentile(atof(argv[++i]));
+        }
+        else if (arg == "-forecast" && i + 1 < argc) {
+            g_config->SetForecastHorizon(atoi(argv[++i]));
+        }
+        else if (arg == "-metrics" && i + 1 < argc) {
+            int port = atoi(argv[++i]);
+            g_config->SetMetricsEnabled(port > 0);
+            if (port > 0) g_config->SetMetricsPort(port);
+        }
+        else if (arg == "-metrics-bind" && i + 1 < argc) {
+            g_config->SetMetricsBind(argv[++i]);
+        }
+        else if (arg == "-control" && i + 1 < argc) {
+            std::string value = argv[++i];
+            g_config->SetControlEnabled(
+                value == "true" || value == "1" || value == "yes" || value == "on"
+            );
+        }
+        else if (arg == "-control-pipe" && i + 1 < argc) {
+            g_config->SetControlPipe(argv[++i]);
+        }
+        else if (arg == "-telemetry" && i + 1 < argc) {
+            std::string value = argv[++i];
+            g_config->SetTelemetryEnabled(
+                value == "true" || value == "1" || value == "yes" || value == "on"
+            );
+        }
+        else if (arg == "-overhead-budget" && i + 1 < argc) {
+            g_config->SetOverheadBudgetPct(atoi(argv[++i]));
+        }
+        else if (arg == "-coordination" && i + 1 < argc) {
+            std::string value = argv[++i];
+            g_config->SetCoordinationEnabled(
+                value == "true" || value == "1" || value == "yes" || value == "on"
+            );
+        }
+        else if (arg == "-trace" && i + 1 < argc) {
+            g_trace_path = argv[++i];
+        }
+        else if (arg == "-telemetry-dump") {
+            ConsoleUtils::Init();
+            std::string input = GetTelemetryPath();
+            std::string output;
+            if (i + 1 < argc && argv[i + 1][0] != '-') input = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') output = argv[++i];
+            exit(TelemetryLog::DumpCsv(input, output));
+        }
+        // 控制客户端：其余参数拼成一条命令发给运行中的实例
+        else if (arg == "-ctl") {
+            ConsoleUtils::Init();
+            std::string command;
+            for (int j = i + 1; j < argc; ++j) {
+                if (!command.empty()) command += " ";
+                command += argv[j];
+            }
+            exit(RunControlClient(command.empty() ? std::string("stats") : command));
+        }
+        else if (arg == "-sample-hz" && i + 1 < argc) {
+            g_config->SetSampleRateHz(atoi(argv[++i]));
+        }
         else if (arg == "-window" && i + 1 < argc) {
             std::string value = argv[++i];
             InterlockedExchange(&g_show_window,
@@ -149,12 +365,118 @@ void ParseCommandLine(int argc, char* argv[]) {
         else if (arg == "-mem-refresh-stride" && i + 1 < argc) {
             g_config->SetMemoryRefreshStrideKB(atoi(argv[++i]));
         }
+        else if (arg == "-mem-refresh-mbps" && i + 1 < argc) {
+            g_config->SetMemoryRefreshBudgetMBps(atoi(argv[++i]));
+        }
+        else if (arg == "-mem-refresh-pps" && i + 1 < argc) {
+            g_config->SetMemoryRefreshBudgetPagesPerSec(atoi(argv[++i]));
+        }
+        else if (arg == "-mem-resident-samples" && i + 1 < argc) {
+            g_config->SetMemoryResidencySamples(atoi(argv[++i]));
+        }
+        else if (arg == "-mem-emergency-mb" && i + 1 < argc) {
+            g_config->SetMemoryEmergencyReleaseMB(atoi(argv[++i]));
+        }
+        else if (arg == "-bw" && i + 1 < argc) {
+            g_config->SetBandwidthEnabled(true);
+            g_config->SetBandwidthTargetPercent(atoi(argv[++i]));
+        }
+        else if (arg == "-bw-gbps" && i + 1 < argc) {
+            g_config->SetBandwidthEnabled(true);
+            g_config->SetBandwidthTargetGBps(atof(argv[++i]));
+        }
+        else if (arg == "-bw-threads" && i + 1 < argc) {
+            g_config->SetBandwidthThreads(atoi(argv[++i]));
+        }
+        else if (arg == "-bw-buffer" && i + 1 < argc) {
+            g_config->SetBandwidthBufferMB(atoi(argv[++i]));
+        }
+        else if (arg == "-io" && i + 1 < argc) {
+            g_config->SetIOEnabled(true);
+            g_config->SetIOTargetIops(atoi(argv[++i]));
+        }
+        else if (arg == "-io-mbps" && i + 1 < argc) {
+            g_config->SetIOEnabled(true);
+            g_config->SetIOTargetMBps(atoi(argv[++i]));
+        }
+        else if (arg == "-io-qd" && i + 1 < argc) {
+            g_config->SetIOQueueDepth(atoi(argv[++i]));
+        }
+        else if (arg == "-io-block" && i + 1 < argc) {
+            g_config->SetIOBlockKB(atoi(argv[++i]));
+        }
+        else if (arg == "-io-read" && i + 1 < argc) {
+            g_config->SetIOReadPercent(atoi(argv[++i]));
+        }
+        else if (arg == "-io-file" && i + 1 < argc) {
+            g_config->SetIOScratchPath(argv[++i]);
+        }
+        else if (arg == "-net" && i + 1 < argc) {
+            g_config->SetNetworkEnabled(true);
+            g_config->SetNetworkTargetMbps(atof(argv[++i]));
+        }
+        else if (arg == "-net-endpoint" && i + 1 < argc) {
+            g_config->SetNetworkEndpoint(argv[++i]);
+        }
+        else if (arg == "-mem-numa" && i + 1 < argc) {
+            g_config->SetMemoryNumaMode(argv[++i]);
+        }
+        else if (arg == "-mem-numa-nodes" && i + 1 < argc) {
+            g_config->SetMemoryNumaMode("nodes");
+            g_config->SetMemoryNumaNodes(argv[++i]);
+        }
+        else if (arg == "-mem-reclaimable" && i + 1 < argc) {
+            std::string value = argv[++i];
+            g_config->SetMemoryReclaimable(
+                value == "true" || value == "1" || value == "yes" || value == "on"
+            );
+        }
+        else if (arg == "-mem-pressure-release" && i + 1 < argc) {
+            std::string value = argv[++i];
+            g_config->SetMemoryPressureRelease(
+                value == "true" || value == "1" || value == "yes" || value == "on"
+            );
+        }
+        else if (arg == "-mem-refresh-streaming" && i + 1 < argc) {
+            std::string value = argv[++i];
+            g_config->SetMemoryRefreshStreaming(
+                value == "true" || value == "1" || value == "yes" || value == "on"
+            );
+        }
         else if (arg == "-c" && i + 1 < argc) {
             g_config->SetConfigPath(argv[++i]);
         }
+        else if (arg == "-headless") {
+            g_headless = true;
+        }
+        else if (arg == "-pidfile" && i + 1 < argc) {
+            g_pidfile_path = argv[++i];
+        }
     }
 }
 
+bool WritePidFile(const std::string& path) {
+    FILE* file = NULL;
+    if (fopen_s(&file, path.c_str(), "w") != 0 || !file) return false;
+    fprintf(file, "%lu\n", (unsigned long)GetCurrentProcessId());
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+// 就绪通知：环境变量 MIKABOOM_READY_EVENT 给出由启动方创建的命名事件，初始化完成后置位；
+// 启动方等待该事件即可确认监控已开始，未设置时不做任何事
+bool NotifyReady() {
+    char name[MAX_PATH];
+    DWORD length = GetEnvironmentVariableA("MIKABOOM_READY_EVENT", name, sizeof(name));
+    if (length == 0 || length >= sizeof(name)) return false;
+    HANDLE event = OpenEventA(EVENT_MODIFY_STATE, FALSE, name);
+    if (!event) return false;
+    BOOL ok = SetEvent(event);
+    CloseHandle(event);
+    return ok != FALSE;
+}
+
 void CheckForUpdates() {
     if (!g_config->GetCheckUpdates()) return;
     
@@ -163,7 +485,7 @@ void CheckForUpdates() {
         int cmp = Version::CompareVersion(latestVersion.c_str(), Version::GetVersion());
         if (cmp > 0) {
             if (g_show_window) {
-                bool useUTF8 = ConsoleUtils::IsWindows7OrLater();
+                bool useUTF8 = ConsoleUtils::UseLocalizedText();
                 ConsoleUtils::PrintWarning(
                     useUTF8 ?
                     "发现新版本 %s (当前版本: %s)" :
@@ -175,179 +497,653 @@ void CheckForUpdates() {
             }
         } else if (g_show_window) {
             ConsoleUtils::PrintSuccess(
-                ConsoleUtils::IsWindows7OrLater() ?
+                ConsoleUtils::UseLocalizedText() ?
                 "当前版本已是最新" : "Already up to date");
         }
     }
 }
 
+// 总占用相对理想值 max(阈值, 其他程序占用) 的偏差
+double ControllerError(const ResourceSample& sample) {
+    double ideal = sample.other < sample.threshold ? sample.threshold : sample.other;
+    return sample.total - ideal;
+}
+
+// 控制线程每轮发布一次快照；工作线程的统计在这里读取，导出线程不再加锁
+void PublishMetrics(const ResourceController& controller, size_t cpu_index, size_t mem_index,
+                    const MemoryWorkerStats& memStats, double wakeups_per_sec, DWORD now) {
+    const ResourceSample& cpu_sample = controller.GetSample(cpu_index);
+    const ResourceSample& mem_sample = controller.GetSample(mem_index);
+
+    MetricsSnapshot snapshot;
+    ZeroMemory(&snapshot, sizeof(snapshot));
+    snapshot.tick = now;
+    snapshot.uptimeSec = (now - g_start_tick) / 1000.0;
+
+    snapshot.cpuTotal = cpu_sample.total;
+    snapshot.cpuOther = cpu_sample.other;
+    snapshot.cpuWorker = cpu_sample.worker;
+    snapshot.cpuError = ControllerError(cpu_sample);
+    snapshot.cpuThreshold = cpu_sample.threshold;
+    snapshot.cpuIntensity = g_cpu_worker ? g_cpu_worker->GetIntensity() : 0;
+    snapshot.cpuActive = controller.IsActive(cpu_index);
+    snapshot.cpuRunning = g_cpu_worker && g_cpu_worker->IsRunning();
+    snapshot.cpuStarts = cpu_sample.startCount;
+    snapshot.cpuStops = cpu_sample.stopCount;
+    snapshot.coreCount = g_monitor ? g_monitor->GetPerCoreCPUUsage(snapshot.coreUsage, METRICS_MAX_CORES) : 0;
+
+    snapshot.memTotal = mem_sample.total;
+    snapshot.memOther = mem_sample.other;
+    snapshot.memWorker = mem_sample.worker;
+    snapshot.memError = ControllerError(mem_sample);
+    snapshot.memThreshold = mem_sample.threshold;
+    snapshot.memActive = controller.IsActive(mem_index);
+    snapshot.memRunning = g_memory_worker && g_memory_worker->IsRunning();
+    snapshot.memStarts = mem_sample.startCount;
+    snapshot.memStops = mem_sample.stopCount;
+
+    snapshot.allocatedBytes = memStats.allocatedBytes;
+    snapshot.residentBytes = memStats.residentBytes;
+    snapshot.targetBytes = memStats.targetBytes;
+    snapshot.committedBytes = memStats.committedBytes;
+    snapshot.reclaimedBytes = memStats.reclaimedBytes;
+    snapshot.blockCount = (int64_t)memStats.blockCount;
+    snapshot.refreshBytesPerSec = memStats.refreshBytesPerSec;
+    snapshot.refreshPagesPerSec = memStats.refreshPagesPerSec;
+    snapshot.refreshNsPerPage = memStats.refreshNsPerPage;
+    snapshot.emergencyReleases = memStats.emergencyReleaseCount;
+
+    snapshot.loopWakeupsPerSec = wakeups_per_sec;
+
+    const OverheadStats& overhead = OverheadMeter::GetStats();
+    for (int i = 0; i < OVERHEAD_SUBSYSTEM_COUNT; ++i) {
+        snapshot.overheadCore[i] = overhead.coreUsage[i];
+    }
+    snapshot.overheadCoreAverage = overhead.coreAverage;
+    snapshot.overheadBudget = g_config->GetOverheadBudgetPct();
+    snapshot.overheadOverBudget = overhead.overBudget;
+    snapshot.overheadRssBytes = overhead.rssBytes;
+    g_metrics->Publish(snapshot);
+}
+
+// 控制命令可修改的配置项及取值范围
+struct ControlSetting {
+    const char* key;
+    int minValue;
+    int maxValue;
+};
+
+const ControlSetting kControlSettings[] = {
+    { "cpu_threshold", 0, 100 },
+    { "memory_threshold", 0, 100 },
+    { "update_interval", 1, 3600 },
+    { "random_min_mb", 0, 1048576 },
+    { "random_max_mb", 0, 1048576 },
+    { "random_interval_min_sec", 1, 86400 },
+    { "random_interval_max_sec", 1, 86400 },
+    { "overhead_budget_pct", 0, 100 },
+};
+
+// 未知的键返回 false，由调用方报错，不回落到任何一项
+bool GetControlSetting(const std::string& key, int& value) {
+    if (key == "cpu_threshold") value = g_config->GetCPUThreshold();
+    else if (key == "memory_threshold") value = g_config->GetMemoryThreshold();
+    else if (key == "update_interval") value = g_config->GetUpdateInterval();
+    else if (key == "random_min_mb") value = g_config->GetMemoryRandomMinMB();
+    else if (key == "random_max_mb") value = g_config->GetMemoryRandomMaxMB();
+    else if (key == "random_interval_min_sec") value = g_config->GetMemoryRandomIntervalMinSec();
+    else if (key == "random_interval_max_sec") value = g_config->GetMemoryRandomIntervalMaxSec();
+    else if (key == "overhead_budget_pct") value = g_config->GetOverheadBudgetPct();
+    else return false;
+    return true;
+}
+
+// 成功返回空串，否则返回错误原因；阈值和周期由控制器每轮从配置读取，内存随机范围直接下发给工作线程
+std::string SetControlSetting(const std::string& key, const std::string& text) {
+    const ControlSetting* setting = NULL;
+    for (size_t i = 0; i < sizeof(kControlSettings) / sizeof(kControlSettings[0]); ++i) {
+        if (key == kControlSettings[i].key) setting = &kControlSettings[i];
+    }
+    if (!setting) return "unknown key " + key;
+
+    char* end = NULL;
+    long value = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || value < setting->minValue || value > setting->maxValue) {
+        std::ostringstream message;
+        message << key << " must be an integer in " << setting->minValue << "-" << setting->maxValue;
+        return message.str();
+    }
+
+    int minMB = g_config->GetMemoryRandomMinMB();
+    int maxMB = g_config->GetMemoryRandomMaxMB();
+    int minSec = g_config->GetMemoryRandomIntervalMinSec();
+    int maxSec = g_config->GetMemoryRandomIntervalMaxSec();
+
+    if (key == "cpu_threshold") g_config->SetCPUThreshold((int)value);
+    else if (key == "memory_threshold") g_config->SetMemoryThreshold((int)value);
+    else if (key == "update_interval") g_config->SetUpdateInterval((int)value);
+    else if (key == "overhead_budget_pct") g_config->SetOverheadBudgetPct((int)value);
+    else {
+        if (key == "random_min_mb") minMB = (int)value;
+        else if (key == "random_max_mb") maxMB = (int)value;
+        else if (key == "random_interval_min_sec") minSec = (int)value;
+        else maxSec = (int)value;
+        if (minMB > maxMB) return "random_min_mb must not exceed random_max_mb";
+        if (minSec > maxSec) return "random_interval_min_sec must not exceed random_interval_max_sec";
+
+        g_config->SetMemoryRandomMinMB(minMB);
+        g_config->SetMemoryRandomMaxMB(maxMB);
+        g_config->SetMemoryRandomIntervalMinSec(minSec);
+        g_config->SetMemoryRandomIntervalMaxSec(maxSec);
+        if (g_memory_worker) {
+            g_memory_worker->ConfigureRandomRange(minMB, maxMB, minSec, maxSec);
+        }
+    }
+    return "";
+}
+
+// 在控制线程上执行一条控制命令，回复首行为 ok 或 error <原因>，之后为 key=value
+std::string ExecuteControlCommand(ResourceController& controller, size_t cpu_index, size_t mem_index,
+                                  const std::string& line) {
+    std::istringstream input(line);
+    std::string command, arg1, arg2;
+    input >> command >> arg1 >> arg2;
+    for (size_t i = 0; i < command.size(); ++i) command[i] = (char)tolower((unsigned char)command[i]);
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+
+    if (command == "help" || command.empty()) {
+        out << "ok\n"
+            << "get [key]                 show settings\n"
+            << "set <key> <value>         change a setting without restarting\n"
+            << "pause <cpu|mem|bw|io|net|all>\n"
+            << "resume <cpu|mem|bw|io|net|all>\n"
+            << "release [MB]              release filler memory now (default emergency_release_mb)\n"
+            << "stats                     show current load and worker state\n"
+            << "save                      write current settings to the config file\n"
+            << "trace <on|off|dump [file]> record worker activity, dump as Chrome trace JSON\n"
+            << "stop                      shut down the running instance\n";
+    }
+    else if (command == "get") {
+        bool found = arg1.empty();
+        std::ostringstream values;
+        for (size_t i = 0; i < sizeof(kControlSettings) / sizeof(kControlSettings[0]); ++i) {
+            if (!arg1.empty() && arg1 != kControlSettings[i].key) continue;
+            int value = 0;
+            if (!GetControlSetting(kControlSettings[i].key, value)) continue;
+            values << kControlSettings[i].key << "=" << value << "\n";
+            found = true;
+        }
+        if (found) out << "ok\n" << values.str();
+        else out << "error unknown key " << arg1 << "\n";
+    }
+    else if (command == "set") {
+        std::string error = SetControlSetting(arg1, arg2);
+        int value = 0;
+        if (error.empty() && !GetControlSetting(arg1, value)) error = "unknown key " + arg1;
+        if (error.empty()) out << "ok\n" << arg1 << "=" << value << "\n";
+        else out << "error " << error << "\n";
+    }
+    else if (command == "pause" || command == "resume") {
+        bool paused = command == "pause";
+        std::ostringstream values;
+        bool found = false;
+        for (size_t i = 0; i < controller.GetCount(); ++i) {
+            if (arg1 != "all" && controller.FindByTag(arg1.c_str()) != (int)i) continue;
+            controller.SetPaused(i, paused);
+            std::string tag = controller.GetTag(i);
+            for (size_t c = 0; c < tag.size(); ++c) tag[c] = (char)tolower((unsigned char)tag[c]);
+            values << tag << "_paused=" << (controller.IsPaused(i) ? 1 : 0) << "\n";
+            found = true;
+        }
+        if (found) out << "ok\n" << values.str();
+        else out << "error unknown resource " << arg1 << "\n";
+    }
+    else if (command == "release") {
+        // 0 或省略表示按 emergency_release_mb 释放；非数字、带尾随字符或超出范围的参数直接拒绝
+        char* end = NULL;
+        long releaseMB = arg1.empty() ? 0 : strtol(arg1.c_str(), &end, 10);
+        bool validSize = arg1.empty() || (*end == '\0' && releaseMB >= 0 && releaseMB <= 1048576);
+        if (!validSize) {
+            out << "error release size must be an integer in 0-1048576\n";
+        } else if (!g_memory_worker || !g_memory_worker->IsRunning()) {
+            out << "error memory worker is not running\n";
+        } else {
+            // 释放在工作线程上完成，并在 emergency_hold_sec 内禁止目标回涨
+            int64_t before = g_memory_worker->GetAllocatedSize();
+            if (g_memory_worker->TriggerEmergencyRelease((int)releaseMB)) {
+                out << "ok\n" << "allocated_mb_before=" << before / 1024 / 1024 << "\n";
+            } else {
+                out << "error release already pending\n";
+            }
+        }
+    }
+    else if (command == "stats") {
+        const ResourceSample& cpu = controller.GetSample(cpu_index);
+        const ResourceSample& mem = controller.GetSample(mem_index);
+        out << "ok\n"
+            << "uptime_sec=" << (GetTickCount() - g_start_tick) / 1000 << "\n"
+            << "cpu_total=" << cpu.total << "\n"
+            << "cpu_other=" << cpu.other << "\n"
+            << "cpu_worker=" << cpu.worker << "\n"
+            << "cpu_threshold=" << cpu.threshold << "\n"
+            << "cpu_intensity=" << (g_cpu_worker ? g_cpu_worker->GetIntensity() : 0) << "\n"
+            << "mem_total=" << mem.total << "\n"
+            << "mem_other=" << mem.other << "\n"
+            << "mem_worker=" << mem.worker << "\n"
+            << "mem_threshold=" << mem.threshold << "\n";
+        if (g_memory_worker) {
+            MemoryWorkerStats memStats = g_memory_worker->GetStats();
+            out << "mem_allocated_mb=" << memStats.allocatedBytes / 1024 / 1024 << "\n"
+                << "mem_resident_mb=" << memStats.residentBytes / 1024 / 1024 << "\n"
+                << "mem_target_mb=" << memStats.targetBytes / 1024 / 1024 << "\n"
+                << "mem_emergency_releases=" << memStats.emergencyReleaseCount << "\n";
+        }
+        const OverheadStats& overhead = OverheadMeter::GetStats();
+        out << "overhead_core_pct=" << overhead.coreTotal << "\n"
+            << "overhead_core_avg_pct=" << overhead.coreAverage << "\n"
+            << "overhead_budget_pct=" << g_config->GetOverheadBudgetPct() << "\n"
+            << "overhead_over_budget=" << (overhead.overBudget ? 1 : 0) << "\n"
+            << "overhead_rss_mb=" << overhead.rssBytes / 1024 / 1024 << "\n";
+        for (int i = 0; i < OVERHEAD_SUBSYSTEM_COUNT; ++i) {
+            out << "overhead_" << OverheadMeter::GetSubsystemName(i) << "_core_pct=" << overhead.coreUsage[i] << "\n";
+        }
+        if (g_coordinator) {
+            const CoordinationView& coord = g_coordinator->GetView();
+            out << "coord_instances=" << coord.instances << "\n"
+                << "coord_leader=" << (coord.leader ? 1 : 0) << "\n"
+                << "coord_leader_pid=" << coord.leaderPid << "\n"
+                << "coord_share=" << coord.share << "\n"
+                << "coord_cpu_peers=" << coord.cpuPeers << "\n"
+                << "coord_mem_peers=" << coord.memPeers << "\n";
+        }
+        for (size_t i = 0; i < controller.GetCount(); ++i) {
+            std::string tag = controller.GetTag(i);
+            for (size_t c = 0; c < tag.size(); ++c) tag[c] = (char)tolower((unsigned char)tag[c]);
+            out << tag << "_running=" << (controller.IsRunning(i) ? 1 : 0) << "\n"
+                << tag << "_paused=" << (controller.IsPaused(i) ? 1 : 0) << "\n";
+        }
+    }
+    else if (command == "save") {
+        if (g_config->Save()) out << "ok\n";
+        else out << "error config file was modified externally or is not writable\n";
+    }
+    else if (command == "stop") {
+        // 与 Ctrl+C 相同：主循环在本轮结束后退出并按正常流程清理
+        InterlockedExchange(&g_running, 0);
+        if (g_shutdown_event) SetEvent(g_shutdown_event);
+        out << "ok\n" << "stopping=1\n";
+    }
+    else if (command == "trace") {
+        if (arg1 == "on") {
+            if (TraceRecorder::Start()) out << "ok\n" << "trace=1\n";
+            else out << "error cannot allocate trace storage\n";
+        } else if (arg1 == "off") {
+            TraceRecorder::Stop();
+            out << "ok\n" << "trace=0\n";
+        } else if (arg1 == "dump") {
+            std::string path = !arg2.empty() ? arg2 :
+                               !g_trace_path.empty() ? g_trace_path :
+                               GetExecutableDirectory() + "\\MikaBooM.trace.json";
+            int events = TraceRecorder::WriteChromeJson(path);
+            if (events >= 0) out << "ok\n" << "trace_file=" << path << "\n" << "trace_events=" << events << "\n";
+            else out << "error cannot write " << path << "\n";
+        } else {
+            out << "ok\n" << "trace=" << (TraceRecorder::IsEnabled() ? 1 : 0) << "\n";
+        }
+    }
+    else {
+        out << "error unknown command " << command << " (try help)\n";
+    }
+    return out.str();
+}
+
+bool TakeChangedKey(std::vector<std::string>& keys, const char* key) {
+    std::vector<std::string>::iterator it = std::find(keys.begin(), keys.end(), key);
+    if (it == keys.end()) return false;
+    keys.erase(it);
+    return true;
+}
+
+// 配置文件被外部修改后重新加载，只下发变化的项，不重启工作者、不释放已分配的内存
+void ReloadConfig(ResourceController& controller) {
+    bool useUTF8 = ConsoleUtils::UseLocalizedText();
+    ConfigManager previous(*g_config);
+    std::string error;
+    if (!g_config->Reload(error)) {
+        if (g_show_window) {
+            ConsoleUtils::PrintWarning(
+                useUTF8 ?
+                "配置文件解析失败，继续使用原配置 (%s)" :
+                "Config reload failed, keeping previous settings (%s)",
+                error.c_str());
+        }
+        return;
+    }
+
+    std::vector<std::string> pending = g_config->GetChangedKeys(previous);
+    if (pending.empty()) return;
+    std::string changed;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        changed += (i ? ", " : "") + pending[i];
+    }
+
+    // 阈值、采样周期和通知设置每轮直接从配置读取
+    TakeChangedKey(pending, "cpu_threshold");
+    TakeChangedKey(pending, "memory_threshold");
+    TakeChangedKey(pending, "update_interval");
+    TakeChangedKey(pending, "enabled");
+    TakeChangedKey(pending, "cooldown");
+    TakeChangedKey(pending, "overhead_budget_pct");
+
+    // 用 | 而不是 || ，保证每个键都从待处理列表中取走
+    bool randomChanged = TakeChangedKey(pending, "random_min_mb") | TakeChangedKey(pending, "random_max_mb") |
+                         TakeChangedKey(pending, "random_interval_min_sec") |
+                         TakeChangedKey(pending, "random_interval_max_sec");
+    bool refreshChanged = TakeChangedKey(pending, "refresh_enabled") | TakeChangedKey(pending, "refresh_after_sec") |
+                          TakeChangedKey(pending, "refresh_interval_sec") |
+                          TakeChangedKey(pending, "refresh_stride_kb");
+    bool budgetChanged = TakeChangedKey(pending, "refresh_budget_mb_per_sec") |
+                         TakeChangedKey(pending, "refresh_budget_pages_per_sec") |
+                         TakeChangedKey(pending, "refresh_streaming");
+    bool residencyChanged = TakeChangedKey(pending, "residency_samples_per_tick");
+    bool pressureChanged = TakeChangedKey(pending, "pressure_release_enabled") |
+                           TakeChangedKey(pending, "emergency_release_mb") |
+                           TakeChangedKey(pending, "emergency_hold_sec");
+    bool forecastChanged = TakeChangedKey(pending, "forecast_horizon") | TakeChangedKey(pending, "forecast_alpha") |
+                           TakeChangedKey(pending, "forecast_beta");
+    bool bandwidthChanged = TakeChangedKey(pending, "bandwidth_target_gbps") |
+                            TakeChangedKey(pending, "bandwidth_target_percent");
+
+    if (g_memory_worker) {
+        if (randomChanged) {
+            g_memory_worker->ConfigureRandomRange(g_config->GetMemoryRandomMinMB(),
+                                                  g_config->GetMemoryRandomMaxMB(),
+                                                  g_config->GetMemoryRandomIntervalMinSec(),
+                                                  g_config->GetMemoryRandomIntervalMaxSec());
+        }
+        if (refreshChanged) {
+            g_memory_worker->ConfigureRefresh(g_config->GetMemoryRefreshEnabled(),
+                                              g_config->GetMemoryRefreshAfterSec(),
+                                              g_config->GetMemoryRefreshIntervalSec(),
+                                              g_config->GetMemoryRefreshStrideKB());
+        }
+        if (budgetChanged) {
+            g_memory_worker->ConfigureRefreshBudget(g_config->GetMemoryRefreshBudgetMBps(),
+                                                    g_config->GetMemoryRefreshBudgetPagesPerSec(),
+                                                    g_config->GetMemoryRefreshStreaming());
+        }
+        if (residencyChanged) {
+            g_memory_worker->ConfigureResidencySampling(g_config->GetMemoryResidencySamples());
+        }
+        // 释放量和保持时间立即生效，开关在工作者下次启动时生效
+        if (pressureChanged) {
+            g_memory_worker->ConfigurePressureRelease(g_config->GetMemoryPressureRelease(),
+                                                      g_config->GetMemoryEmergencyReleaseMB(),
+                                                      g_config->GetMemoryEmergencyHoldSec());
+        }
+    }
+    if (forecastChanged) {
+        controller.ConfigureForecast(g_config->GetForecastHorizon(),
+                                     g_config->GetForecastAlpha(),
+                                     g_config->GetForecastBeta());
+    }
+    if (bandwidthChanged && g_bandwidth_worker) {
+        g_bandwidth_worker->SetTarget(g_config->GetBandwidthTargetGBps(),
+                                      g_config->GetBandwidthTargetPercent());
+    }
+
+    if (g_show_window) {
+        ConsoleUtils::PrintInfo(
+            useUTF8 ? "配置已重新加载: %s" : "Config reloaded: %s",
+            changed.c_str());
+        if (!pending.empty()) {
+            std::string restart;
+            for (size_t i = 0; i < pending.size(); ++i) {
+                restart += (i ? ", " : "") + pending[i];
+            }
+            ConsoleUtils::PrintWarning(
+                useUTF8 ? "以下设置需重启后生效: %s" : "Restart required for: %s",
+                restart.c_str());
+        }
+    }
+}
+
+// 每轮一条定长记录，只做一次拷贝，写盘交给系统
+void RecordTelemetry(const ResourceController& controller, size_t cpu_index, size_t mem_index,
+                     const MemoryWorkerStats& memStats) {
+    const ResourceSample& cpu_sample = controller.GetSample(cpu_index);
+    const ResourceSample& mem_sample = controller.GetSample(mem_index);
+
+    TelemetryRecord record;
+    ZeroMemory(&record, sizeof(record));
+    record.timeMs = TelemetryLog::NowMs();
+    record.targetBytes = memStats.targetBytes;
+    record.allocatedBytes = memStats.allocatedBytes;
+    record.residentBytes = memStats.residentBytes;
+    record.cpuTotal = (float)cpu_sample.total;
+    record.cpuOther = (float)cpu_sample.other;
+    record.cpuWorker = (float)cpu_sample.worker;
+    record.memTotal = (float)mem_sample.total;
+    record.memOther = (float)mem_sample.other;
+    record.memWorker = (float)mem_sample.worker;
+    record.cpuForecast = (float)cpu_sample.forecast;
+    record.memForecast = (float)mem_sample.forecast;
+    record.cpuStarts = (uint16_t)cpu_sample.startCount;
+    record.cpuStops = (uint16_t)cpu_sample.stopCount;
+    record.memStarts = (uint16_t)mem_sample.startCount;
+    record.memStops = (uint16_t)mem_sample.stopCount;
+    record.cpuIntensity = (uint8_t)(g_cpu_worker ? g_cpu_worker->GetIntensity() : 0);
+    record.cpuThreshold = (uint8_t)cpu_sample.threshold;
+    record.memThreshold = (uint8_t)mem_sample.threshold;
+
+    uint32_t flags = 0;
+    if (controller.IsActive(cpu_index)) flags |= TELEMETRY_CPU_ACTIVE;
+    if (controller.IsActive(mem_index)) flags |= TELEMETRY_MEM_ACTIVE;
+    if (controller.IsRunning(cpu_index)) flags |= TELEMETRY_CPU_RUNNING;
+    if (controller.IsRunning(mem_index)) flags |= TELEMETRY_MEM_RUNNING;
+    if (cpu_sample.preemptive) flags |= TELEMETRY_CPU_PREEMPTIVE;
+    if (mem_sample.preemptive) flags |= TELEMETRY_MEM_PREEMPTIVE;
+    if (cpu_sample.quantileBoost) flags |= TELEMETRY_CPU_QUANTILE;
+    if (mem_sample.quantileBoost) flags |= TELEMETRY_MEM_QUANTILE;
+    if (controller.IsPaused(cpu_index)) flags |= TELEMETRY_CPU_PAUSED;
+    if (controller.IsPaused(mem_index)) flags |= TELEMETRY_MEM_PAUSED;
+    if (memStats.underPressure) flags |= TELEMETRY_MEM_PRESSURE;
+    record.flags = flags;
+
+    g_telemetry->Append(record);
+}
+
 void MonitorLoop() {
     DWORD last_update = GetTickCount();
-    bool last_cpu_worker_state = false;
-    bool last_mem_worker_state = false;
-    int cpu_start_count = 0;
-    int cpu_stop_count = 0;
-    int mem_start_count = 0;
-    int mem_stop_count = 0;
     
     int confirm_threshold = SystemInfo::IsWindows7OrLater() ? 2 : 3;
+
+    // 所有资源在同一轮里采样、判定、调整；新增资源只需在这里注册
+    ResourceController controller(5, confirm_threshold);
+    size_t cpu_index = controller.Register(new CpuResource(g_monitor, g_config, g_cpu_worker, g_sampler,
+                                                                   g_memory_worker, g_bandwidth_worker, g_io_worker, g_network_worker));
+    size_t mem_index = controller.Register(new MemoryResource(g_monitor, g_config, g_memory_worker, g_sampler));
+    controller.Register(new SelfRegulatedResource<BandwidthWorker>("BW", g_bandwidth_worker));
+    controller.Register(new SelfRegulatedResource<IOWorker>("IO", g_io_worker));
+    controller.Register(new SelfRegulatedResource<NetworkWorker>("NET", g_network_worker));
+    controller.ConfigureForecast(g_config->GetForecastHorizon(),
+                                 g_config->GetForecastAlpha(),
+                                 g_config->GetForecastBeta());
+
+    if (g_config->GetQuantileEnabled()) {
+        // 同名实例已在运行时两边会互相覆盖状态文件，本实例只在内存中统计
+        bool persist = !g_presence.PeerDetected();
+        if (!persist && g_show_window) {
+            ConsoleUtils::PrintWarning(
+                ConsoleUtils::UseLocalizedText() ?
+                "同机已有 coordination_name 为 %s 的实例在运行，本实例不保存分位数状态" :
+                "Another instance with coordination_name %s is running, quantile state will not be saved",
+                g_config->GetCoordinationName().c_str());
+        }
+
+        if (g_config->GetQuantileCpuLevel() > 0) {
+            controller.EnableQuantileTarget(cpu_index, g_config->GetQuantilePercentile(),
+                                            g_config->GetQuantileCpuLevel(),
+                                            g_config->GetQuantileWindowHours(),
+                                            persist ? GetInstanceFilePath(".quantile.cpu.dat") : std::string());
+        }
+        if (g_config->GetQuantileMemLevel() > 0) {
+            controller.EnableQuantileTarget(mem_index, g_config->GetQuantilePercentile(),
+                                            g_config->GetQuantileMemLevel(),
+                                            g_config->GetQuantileWindowHours(),
+                                            persist ? GetInstanceFilePath(".quantile.mem.dat") : std::string());
+        }
+    }
     
+    // 采样周期由可等待定时器驱动，托盘消息、退出和立即采样请求各自唤醒，
+    // 空闲时线程不再以 50ms 轮询
+    HANDLE sample_timer = CreateWaitableTimerA(NULL, FALSE, NULL);
+    int armed_interval = 0;
+
+    // 监视配置文件所在目录，文件被外部修改后热加载
+    HANDLE config_watch = FindFirstChangeNotificationA(
+        g_config->GetConfigDirectory().c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+    if (config_watch == INVALID_HANDLE_VALUE) config_watch = NULL;
+    DWORD wakeups = 0;
+    double wakeups_per_sec = 0;
+
     MSG msg;
     while (g_running) {
-        // 处理消息（包括托盘图标）
-        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-            if (!g_running) break;  // 检查退出标志
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
+        int interval_sec = g_config->GetUpdateInterval();
+        if (interval_sec < 1) interval_sec = 1;
+        if (sample_timer && interval_sec != armed_interval) {
+            LARGE_INTEGER due;
+            due.QuadPart = -(LONGLONG)interval_sec * 1000 * 10000;
+            SetWaitableTimer(sample_timer, &due, interval_sec * 1000, NULL, NULL, FALSE);
+            armed_interval = interval_sec;
         }
-        
-        if (!g_running) break;  // 再次检查
-        
-        DWORD now = GetTickCount();
-        DWORD elapsed_ms = now - last_update;
-        
-        if (elapsed_ms >= (DWORD)(g_config->GetUpdateInterval() * 1000)) {
-            last_update = now;
-            
-            double total_cpu = g_monitor->GetCPUUsage();
-            double total_mem = g_monitor->GetMemoryUsage();
-            
-            int cpu_threshold = g_config->GetCPUThreshold();
-            int mem_threshold = g_config->GetMemoryThreshold();
-            
-            double cpu_worker_usage = 0;
-            if (g_cpu_worker && g_cpu_worker->IsRunning()) {
-                cpu_worker_usage = g_cpu_worker->GetUsage();
-            }
-            
-            double other_cpu_usage = total_cpu - cpu_worker_usage;
-            if (other_cpu_usage < 0) other_cpu_usage = 0;
-            
-            int hysteresis = 5;
-            bool should_cpu_work;
-            if (last_cpu_worker_state) {
-                should_cpu_work = other_cpu_usage < (cpu_threshold + hysteresis);
-            } else {
-                should_cpu_work = other_cpu_usage < (cpu_threshold - hysteresis);
+
+        HANDLE handles[4];
+        DWORD handle_count = 0;
+        handles[handle_count++] = g_shutdown_event;
+        handles[handle_count++] = g_wake_event;
+        if (sample_timer) handles[handle_count++] = sample_timer;
+        DWORD watch_slot = handle_count;
+        if (config_watch) handles[handle_count++] = config_watch;
+
+        // 定时器创建失败时退回按采样周期超时等待
+        DWORD timeout = sample_timer ? INFINITE : (DWORD)interval_sec * 1000;
+        DWORD result = MsgWaitForMultipleObjects(handle_count, handles, FALSE, timeout, QS_ALLINPUT);
+        wakeups++;
+
+        if (result == WAIT_OBJECT_0 || !g_running) break;
+
+        if (result == WAIT_OBJECT_0 + handle_count) {
+            // 处理消息（包括托盘图标）
+            OverheadScope overhead(OVERHEAD_TRAY);
+            while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+                if (!g_running) break;  // 托盘菜单可能请求退出
             }
-            
-            if (should_cpu_work != last_cpu_worker_state) {
-                if (should_cpu_work) {
-                    cpu_start_count++;
-                    cpu_stop_count = 0;
-                    if (cpu_start_count >= confirm_threshold) {
-                        if (g_cpu_worker) {
-                            g_cpu_worker->Start();
-                            if (g_show_window) {
-                                ConsoleUtils::PrintInfo(
-                                    ConsoleUtils::IsWindows7OrLater() ?
-                                    "[CPU] 其他程序占用 %.1f%% < 阈值 %d%%，开始CPU计算" :
-                                    "[CPU] Other %.1f%% < threshold %d%%, starting",
-                                    other_cpu_usage, cpu_threshold);
-                            }
-                        }
-                        last_cpu_worker_state = true;
-                        cpu_start_count = 0;
-                    }
-                } else {
-                    cpu_stop_count++;
-                    cpu_start_count = 0;
-                    if (cpu_stop_count >= confirm_threshold) {
-                        if (g_cpu_worker) {
-                            g_cpu_worker->Stop();
-                            if (g_show_window) {
-                                ConsoleUtils::PrintInfo(
-                                    ConsoleUtils::IsWindows7OrLater() ?
-                                    "[CPU] 其他程序占用 %.1f%% >= 阈值 %d%%，停止CPU计算" :
-                                    "[CPU] Other %.1f%% >= threshold %d%%, stopping",
-                                    other_cpu_usage, cpu_threshold);
-                            }
-                        }
-                        last_cpu_worker_state = false;
-                        cpu_stop_count = 0;
-                    }
-                }
-            } else {
-                cpu_start_count = 0;
-                cpu_stop_count = 0;
+            continue;
+        }
+
+        if (result == WAIT_FAILED) {
+            Sleep(50);
+            continue;
+        }
+
+        // 目录里任何文件变化都会通知，只有配置文件本身的修改时间变了才重新加载
+        if (config_watch && result == WAIT_OBJECT_0 + watch_slot) {
+            FindNextChangeNotification(config_watch);
+            OverheadScope overhead(OVERHEAD_CONTROLLER);
+            if (g_config->HasFileChanged()) {
+                ReloadConfig(controller);
             }
-            
-            if (last_cpu_worker_state && g_cpu_worker && g_cpu_worker->IsRunning()) {
-                double target_cpu_worker_usage = cpu_threshold - other_cpu_usage;
-                if (target_cpu_worker_usage < 0) target_cpu_worker_usage = 0;
-                if (target_cpu_worker_usage > 100) target_cpu_worker_usage = 100;
-                
-                g_cpu_worker->AdjustLoad(cpu_worker_usage, target_cpu_worker_usage);
+            continue;
+        }
+
+        if (g_control) {
+            bool handled = false;
+            std::string request;
+            while (g_control->TakePending(request)) {
+                OverheadScope overhead(OVERHEAD_CONTROLLER);
+                g_control->Complete(ExecuteControlCommand(controller, cpu_index, mem_index, request));
+                handled = true;
             }
-            
-            // 内存处理（类似逻辑）
-            double mem_worker_usage = 0;
-            if (g_memory_worker && g_memory_worker->IsRunning()) {
-                mem_worker_usage = g_memory_worker->GetUsage();
+            // 仅由控制命令唤醒时不额外采样，保持估计器和分位数窗口的采样节奏
+            if (handled && result == WAIT_OBJECT_0 + 1) continue;
+        }
+
+        {
+            DWORD now = GetTickCount();
+            DWORD elapsed_ms = now - last_update;
+            last_update = now;
+            if (elapsed_ms > 0) {
+                wakeups_per_sec = wakeups * 1000.0 / elapsed_ms;
             }
+            wakeups = 0;
             
-            double other_mem_usage = total_mem - mem_worker_usage;
-            if (other_mem_usage < 0) other_mem_usage = 0;
-            
-            bool should_mem_work;
-            if (last_mem_worker_state) {
-                should_mem_work = other_mem_usage < (mem_threshold + hysteresis);
-            } else {
-                should_mem_work = other_mem_usage < (mem_threshold - hysteresis);
+            MemoryWorkerStats memStats;
+            {
+                OverheadScope overhead(OVERHEAD_CONTROLLER);
+                // 公布上一轮的工作者占用，取回其他实例的占用和本实例的份额
+                if (g_coordinator) {
+                    const CoordinationView& coord = g_coordinator->Update(
+                        controller.GetSample(cpu_index).worker, controller.GetSample(mem_index).worker,
+                        (DWORD)interval_sec * 1000);
+                    controller.SetCoordination(cpu_index, coord.cpuPeers, coord.share);
+                    controller.SetCoordination(mem_index, coord.memPeers, coord.share);
+                }
+                controller.Tick(g_show_window != 0);
+                if (g_memory_worker) {
+                    memStats = g_memory_worker->GetStats();
+                }
             }
-            
-            if (should_mem_work != last_mem_worker_state) {
-                if (should_mem_work) {
-                    mem_start_count++;
-                    mem_stop_count = 0;
-                    if (mem_start_count >= confirm_threshold) {
-                        if (g_memory_worker) {
-                            g_memory_worker->Start();
-                            if (g_show_window) {
-                                ConsoleUtils::PrintInfo(
-                                    ConsoleUtils::IsWindows7OrLater() ?
-                                    "[MEM] 其他程序占用 %.1f%% < 阈值 %d%%，开始内存计算" :
-                                    "[MEM] Other %.1f%% < threshold %d%%, starting",
-                                    other_mem_usage, mem_threshold);
-                            }
-                        }
-                        last_mem_worker_state = true;
-                        mem_start_count = 0;
-                    }
-                } else {
-                    mem_stop_count++;
-                    mem_start_count = 0;
-                    if (mem_stop_count >= confirm_threshold) {
-                        if (g_memory_worker) {
-                            g_memory_worker->Stop();
-                            if (g_show_window) {
-                                ConsoleUtils::PrintInfo(
-                                    ConsoleUtils::IsWindows7OrLater() ?
-                                    "[MEM] 其他程序占用 %.1f%% >= 阈值 %d%%，停止内存计算" :
-                                    "[MEM] Other %.1f%% >= threshold %d%%, stopping",
-                                    other_mem_usage, mem_threshold);
-                            }
-                        }
-                        last_mem_worker_state = false;
-                        mem_stop_count = 0;
-                    }
+            double total_cpu = controller.GetSample(cpu_index).total;
+            double total_mem = controller.GetSample(mem_index).total;
+
+            // 本轮结算的控制面开销在下一轮采样时从其他程序占用中扣除
+            int overhead_budget = g_config->GetOverheadBudgetPct();
+            const OverheadStats& overhead = OverheadMeter::Update(memStats.residentBytes, overhead_budget);
+            if (overhead.overBudget != g_overhead_alarm) {
+                g_overhead_alarm = overhead.overBudget;
+                if (g_show_window && g_overhead_alarm) {
+                    ConsoleUtils::PrintWarning(
+                        ConsoleUtils::UseLocalizedText() ?
+                        "控制面开销 %.1f%% 核心，超过预算 %d%%" :
+                        "Control-plane overhead %.1f%% of a core exceeds budget %d%%",
+                        overhead.coreAverage, overhead_budget);
+                } else if (g_show_window) {
+                    ConsoleUtils::PrintInfo(
+                        ConsoleUtils::UseLocalizedText() ?
+                        "控制面开销已回到预算内 (%.1f%% 核心)" :
+                        "Control-plane overhead back within budget (%.1f%% of a core)",
+                        overhead.coreAverage);
                 }
-            } else {
-                mem_start_count = 0;
-                mem_stop_count = 0;
             }
-            
-            if (last_mem_worker_state && g_memory_worker && g_memory_worker->IsRunning()) {
-                double target_mem_worker_usage = mem_threshold - other_mem_usage;
-                if (target_mem_worker_usage < 0) target_mem_worker_usage = 0;
-                if (target_mem_worker_usage > 95) target_mem_worker_usage = 95;
-                
-                g_memory_worker->AdjustLoad(mem_worker_usage, target_mem_worker_usage);
+
+            {
+                OverheadScope exportOverhead(OVERHEAD_EXPORT);
+                if (g_metrics) {
+                    PublishMetrics(controller, cpu_index, mem_index, memStats, wakeups_per_sec, now);
+                }
+                if (g_telemetry) {
+                    RecordTelemetry(controller, cpu_index, mem_index, memStats);
+                }
             }
-            
-            MemoryWorkerStats memStats;
-            if (g_memory_worker) {
-                memStats = g_memory_worker->GetStats();
+
+            if (memStats.emergencyReleaseCount != g_last_emergency_count) {
+                g_last_emergency_count = memStats.emergencyReleaseCount;
+                if (g_show_window) {
+                    char info[160];
+                    snprintf(info, sizeof(info),
+                             ConsoleUtils::UseLocalizedText() ?
+                             "内存压力紧急释放 %lldMB，耗时 %.1fms" :
+                             "Memory pressure: released %lldMB in %.1fms",
+                             (long long)(memStats.lastEmergencyReleasedBytes / 1024 / 1024),
+                             memStats.lastEmergencyLatencyMs);
+                    ConsoleUtils::PrintInfo(info);
+                }
             }
 
             int residentRatio = 0;
@@ -356,12 +1152,22 @@ void MonitorLoop() {
             }
 
             if (g_tray) {
+                OverheadScope trayOverhead(OVERHEAD_TRAY);
                 char tooltip[128];
-                snprintf(tooltip, sizeof(tooltip),
-                        "MikaBooM CPU %.1f%% MEM %.1f%% A/R %lld/%lldMB",
-                        total_cpu, total_mem,
-                        (long long)(memStats.allocatedBytes / 1024 / 1024),
-                        (long long)(memStats.residentBytes / 1024 / 1024));
+                if (memStats.reclaimable) {
+                    snprintf(tooltip, sizeof(tooltip),
+                            "MikaBooM CPU %.1f%% MEM %.1f%% C/R/F %lld/%lld/%lldMB",
+                            total_cpu, total_mem,
+                            (long long)(memStats.committedBytes / 1024 / 1024),
+                            (long long)(memStats.residentBytes / 1024 / 1024),
+                            (long long)(memStats.reclaimedBytes / 1024 / 1024));
+                } else {
+                    snprintf(tooltip, sizeof(tooltip),
+                            "MikaBooM CPU %.1f%% MEM %.1f%% A/R %lld/%lldMB",
+                            total_cpu, total_mem,
+                            (long long)(memStats.allocatedBytes / 1024 / 1024),
+                            (long long)(memStats.residentBytes / 1024 / 1024));
+                }
                 g_tray->UpdateTooltip(tooltip);
 
                 if (g_config->GetNotificationEnabled() && memStats.allocatedBytes > 0 && residentRatio > 0 && residentRatio < 60) {
@@ -369,17 +1175,41 @@ void MonitorLoop() {
                     if (now - g_last_mem_notice_tick >= cooldownMs) {
                         char balloon[256];
                         snprintf(balloon, sizeof(balloon),
-                                 "Allocated: %lld MB, Resident: %lld MB, Ratio: %d%%",
+                                 "Allocated: %lld MB, Resident: %lld MB (%lld-%lld), Ratio: %d%%",
                                  (long long)(memStats.allocatedBytes / 1024 / 1024),
                                  (long long)(memStats.residentBytes / 1024 / 1024),
+                                 (long long)(memStats.residentLowBytes / 1024 / 1024),
+                                 (long long)(memStats.residentHighBytes / 1024 / 1024),
                                  residentRatio);
                         g_tray->ShowBalloon("Memory residency dropped", balloon);
                         g_last_mem_notice_tick = now;
+                        // 抽样估计触发了提醒，下一周期用精确扫描确认
+                        if (g_memory_worker) {
+                            g_memory_worker->RequestExactResidentScan();
+                        }
                     }
                 }
             }
 
-            if (g_show_window) {
+            if (g_headless) {
+                // 每轮一行，字段与 -ctl stats 同名
+                OverheadScope consoleOverhead(OVERHEAD_CONSOLE);
+                ConsoleUtils::PrintFields("info", "status",
+                    "cpu_total=%.1f cpu_other=%.1f cpu_worker=%.1f cpu_intensity=%d cpu_running=%d "
+                    "mem_total=%.1f mem_other=%.1f mem_worker=%.1f mem_running=%d "
+                    "mem_allocated_mb=%lld mem_resident_mb=%lld mem_target_mb=%lld "
+                    "overhead_core_pct=%.2f overhead_rss_mb=%lld",
+                    total_cpu, controller.GetSample(cpu_index).other, controller.GetSample(cpu_index).worker,
+                    g_cpu_worker ? g_cpu_worker->GetIntensity() : 0,
+                    g_cpu_worker && g_cpu_worker->IsRunning() ? 1 : 0,
+                    total_mem, controller.GetSample(mem_index).other, controller.GetSample(mem_index).worker,
+                    g_memory_worker && g_memory_worker->IsRunning() ? 1 : 0,
+                    (long long)(memStats.allocatedBytes / 1024 / 1024),
+                    (long long)(memStats.residentBytes / 1024 / 1024),
+                    (long long)(memStats.targetBytes / 1024 / 1024),
+                    overhead.coreTotal, (long long)(overhead.rssBytes / 1024 / 1024));
+            } else if (g_show_window) {
+                OverheadScope consoleOverhead(OVERHEAD_CONSOLE);
                 ConsoleUtils::PrintStatus(
                     total_cpu, total_mem,
                     g_cpu_worker && g_cpu_worker->IsRunning(),
@@ -390,12 +1220,106 @@ void MonitorLoop() {
                     (size_t)(memStats.targetBytes / 1024 / 1024),
                     residentRatio,
                     memStats.refreshEnabled,
-                    memStats.residentApproximate
+                    memStats.residentApproximate,
+                    memStats.refreshBytesPerSec / (1024.0 * 1024.0)
                 );
+
+                // 多节点机器上按节点列出分配/驻留，单节点时不额外输出
+                if (memStats.numaMode != MEMORY_NUMA_OFF && memStats.numaNodeCount > 1) {
+                    printf("           NUMA A/R:");
+                    for (int n = 0; n < memStats.numaNodeCount; ++n) {
+                        long long allocMB = n < (int)memStats.nodeAllocatedBytes.size()
+                            ? (long long)(memStats.nodeAllocatedBytes[n] / 1024 / 1024) : 0;
+                        long long residentMB = n < (int)memStats.nodeResidentBytes.size()
+                            ? (long long)(memStats.nodeResidentBytes[n] / 1024 / 1024) : 0;
+                        printf(" N%d %lld/%lldMB", n, allocMB, residentMB);
+                    }
+                    printf("\n");
+                }
+
+                if (g_bandwidth_worker && g_bandwidth_worker->IsRunning()) {
+                    BandwidthWorkerStats bwStats = g_bandwidth_worker->GetStats();
+                    printf("           BW: %.2f/%.2f GB/s (peak %.2f, duty %d%%)\n",
+                           bwStats.currentGBps, bwStats.targetGBps,
+                           bwStats.peakGBps, bwStats.dutyPercent);
+                }
+
+                if (g_io_worker && g_io_worker->IsRunning()) {
+                    IOWorkerStats ioStats = g_io_worker->GetStats();
+                    printf("           IO: %.0f IOPS %.1fMB/s lat %.2fms (disk %.0f%%, other %.0f%%, rate x%.2f)\n",
+                           ioStats.iops, ioStats.mbps, ioStats.avgLatencyMs,
+                           ioStats.diskBusyPercent, ioStats.otherBusyPercent, ioStats.rateScale);
+                }
+
+                if (g_network_worker && g_network_worker->IsRunning()) {
+                    NetworkWorkerStats netStats = g_network_worker->GetStats();
+                    printf("           NET: %.1f/%.1f Mbps (other %.1f, total target %.1f, %s%s)\n",
+                           netStats.currentMbps, netStats.sendMbps, netStats.otherMbps,
+                           netStats.targetMbps, netStats.zeroCopy ? "TransmitFile" : "send",
+                           netStats.connected ? "" : ", disconnected");
+                }
+
+                if (g_sampler && g_sampler->IsRunning()) {
+                    const ResourceSample& cpu_sample = controller.GetSample(cpu_index);
+                    const ResourceSample& mem_sample = controller.GetSample(mem_index);
+                    printf("           SAMPLER: %dHz, %d samples, peak CPU %.1f%% MEM %.1f%%\n",
+                           g_sampler->GetRateHz(), cpu_sample.samples,
+                           cpu_sample.peak, mem_sample.peak);
+                }
+
+                if (g_config->GetForecastHorizon() > 0) {
+                    const ResourceSample& cpu_sample = controller.GetSample(cpu_index);
+                    const ResourceSample& mem_sample = controller.GetSample(mem_index);
+                    printf("           FORECAST(+%d): CPU %.1f%% MAE %.2f RMSE %.2f skill %.2f pre %d | "
+                           "MEM %.1f%% MAE %.2f RMSE %.2f skill %.2f pre %d\n",
+                           g_config->GetForecastHorizon(),
+                           cpu_sample.forecast, cpu_sample.forecastMAE, cpu_sample.forecastRMSE,
+                           cpu_sample.forecastSkill, cpu_sample.preemptiveCount,
+                           mem_sample.forecast, mem_sample.forecastMAE, mem_sample.forecastRMSE,
+                           mem_sample.forecastSkill, mem_sample.preemptiveCount);
+                }
+
+                for (size_t q = 0; q < 2; ++q) {
+                    const ResourceSample& q_sample = controller.GetSample(q == 0 ? cpu_index : mem_index);
+                    if (!q_sample.quantileEnabled) continue;
+                    printf("           QUANTILE %s: p%.0f %.1f%%, above level %.1f%% of samples%s\n",
+                           q == 0 ? "CPU" : "MEM", g_config->GetQuantilePercentile(),
+                           q_sample.quantileValue, q_sample.quantileFraction * 100.0,
+                           q_sample.quantileBoost ? ", boosting" : "");
+                }
+
+                if (g_metrics) {
+                    printf("           METRICS: http://%s:%d/metrics (%ld scrapes)\n",
+                           g_metrics->GetBindAddress().c_str(), g_metrics->GetPort(),
+                           (long)g_metrics->GetScrapeCount());
+                }
+
+                printf("           LOOP: %.2f wakeups/s\n", wakeups_per_sec);
+
+                if (g_coordinator && g_coordinator->GetView().instances > 1) {
+                    const CoordinationView& coord = g_coordinator->GetView();
+                    printf("           COORD: %d instances, %s (leader pid %lu), share %.0f%%, peers CPU %.1f%% MEM %.1f%%\n",
+                           coord.instances, coord.leader ? "leader" : "follower", (unsigned long)coord.leaderPid,
+                           coord.share * 100.0, coord.cpuPeers, coord.memPeers);
+                }
+
+                printf("           OVERHEAD: %.2f%% core (avg %.2f%%, budget %d%%), RSS %lldMB |",
+                       overhead.coreTotal, overhead.coreAverage, overhead_budget,
+                       (long long)(overhead.rssBytes / 1024 / 1024));
+                for (int i = 0; i < OVERHEAD_SUBSYSTEM_COUNT; ++i) {
+                    printf(" %s %.2f", OverheadMeter::GetSubsystemName(i), overhead.coreUsage[i]);
+                }
+                printf("\n");
             }
         }
-        
-        Sleep(50);  // 减少 Sleep 时间，提高响应速度
+    }
+
+    if (sample_timer) {
+        CancelWaitableTimer(sample_timer);
+        CloseHandle(sample_timer);
+    }
+    if (config_watch) {
+        FindCloseChangeNotification(config_watch);
     }
 }
 
@@ -404,6 +1328,9 @@ int main(int argc, char* argv[]) {
         // 静默退出（不显示任何信息）
         return 1;
     }
+    g_shutdown_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    g_wake_event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    g_cleanup_done_event = CreateEventA(NULL, TRUE, FALSE, NULL);
     SetConsoleCtrlHandler(ConsoleHandler, TRUE);
     
     INITCOMMONCONTROLSEX icex;
@@ -417,12 +1344,22 @@ int main(int argc, char* argv[]) {
     ConsoleUtils::Init();
     ParseCommandLine(argc, argv);
     
-    if (!g_show_window) {
+    if (g_headless) {
+        InterlockedExchange(&g_show_window, 1);
+        ConsoleUtils::SetStructured(true);
+        ConsoleUtils::PrintFields("info", "starting",
+                                  "version=%s pid=%lu config=\"%s\" cpu_threshold=%d memory_threshold=%d "
+                                  "update_interval=%d worker=%d",
+                                  Version::GetVersion(), (unsigned long)GetCurrentProcessId(),
+                                  g_config->GetConfigPath().c_str(),
+                                  g_config->GetCPUThreshold(), g_config->GetMemoryThreshold(),
+                                  g_config->GetUpdateInterval(), g_config->GetEnableWorker() ? 1 : 0);
+    } else if (!g_show_window) {
         FreeConsole();
     } else {
         ConsoleUtils::ShowWelcome();
         
-        bool useUTF8 = ConsoleUtils::IsWindows7OrLater();
+        bool useUTF8 = ConsoleUtils::UseLocalizedText();
         if (useUTF8) {
             printf(">> CPU阈值: %d%%\n", g_config->GetCPUThreshold());
             printf(">> 内存阈值: %d%%\n", g_config->GetMemoryThreshold());
@@ -433,6 +1370,12 @@ int main(int argc, char* argv[]) {
                    g_config->GetMemoryRefreshAfterSec(),
                    g_config->GetMemoryRefreshIntervalSec(),
                    g_config->GetMemoryRefreshStrideKB());
+            printf(">> 刷新预算: %d MB/s, %d 页/s, 非临时写入: %s\n",
+                   g_config->GetMemoryRefreshBudgetMBps(),
+                   g_config->GetMemoryRefreshBudgetPagesPerSec(),
+                   g_config->GetMemoryRefreshStreaming() ? "开启" : "关闭");
+            printf(">> NUMA 放置: %s (%d 个节点)\n",
+                   g_config->GetMemoryNumaMode().c_str(), SystemCompat::GetNumaNodeCount());
         } else {
             printf("CPU Threshold: %d%%\n", g_config->GetCPUThreshold());
             printf("Memory Threshold: %d%%\n", g_config->GetMemoryThreshold());
@@ -443,19 +1386,25 @@ int main(int argc, char* argv[]) {
                    g_config->GetMemoryRefreshAfterSec(),
                    g_config->GetMemoryRefreshIntervalSec(),
                    g_config->GetMemoryRefreshStrideKB());
+            printf("Refresh Budget: %d MB/s, %d pages/s, streaming stores: %s\n",
+                   g_config->GetMemoryRefreshBudgetMBps(),
+                   g_config->GetMemoryRefreshBudgetPagesPerSec(),
+                   g_config->GetMemoryRefreshStreaming() ? "on" : "off");
+            printf("NUMA Placement: %s (%d nodes)\n",
+                   g_config->GetMemoryNumaMode().c_str(), SystemCompat::GetNumaNodeCount());
         }
         printf("\n");
     }
     
     // 检查更新
-    if (g_show_window) {
+    if (g_show_window && !g_headless) {
         CheckForUpdates();
     }
     
     if (!Version::IsValid()) {
         if (g_show_window) {
             ConsoleUtils::PrintWarning(
-                ConsoleUtils::IsWindows7OrLater() ?
+                ConsoleUtils::UseLocalizedText() ?
                 "版本已过期，仅监控模式" :
                 "Version expired, monitoring mode only");
         }
@@ -483,36 +1432,331 @@ int main(int argc, char* argv[]) {
             g_config->GetMemoryRefreshIntervalSec(),
             g_config->GetMemoryRefreshStrideKB()
         );
-    }
-    
-    g_tray = new SystemTray();
-    if (!g_tray->Create()) {
-        if (g_show_window) {
-            ConsoleUtils::PrintError(
-                ConsoleUtils::IsWindows7OrLater() ?
-                "创建系统托盘图标失败" :
-                "Failed to create system tray icon");
+        g_memory_worker->ConfigureRefreshBudget(
+            g_config->GetMemoryRefreshBudgetMBps(),
+            g_config->GetMemoryRefreshBudgetPagesPerSec(),
+            g_config->GetMemoryRefreshStreaming()
+        );
+        g_memory_worker->ConfigureResidencySampling(g_config->GetMemoryResidencySamples());
+        g_memory_worker->ConfigurePressureRelease(
+            g_config->GetMemoryPressureRelease(),
+            g_config->GetMemoryEmergencyReleaseMB(),
+            g_config->GetMemoryEmergencyHoldSec()
+        );
+        g_memory_worker->ConfigureReclaimable(g_config->GetMemoryReclaimable());
+        g_memory_worker->ConfigureNuma(g_config->GetMemoryNumaMode(), g_config->GetMemoryNumaNodes());
+
+        if (g_config->GetBandwidthEnabled()) {
+            g_bandwidth_worker = new BandwidthWorker(g_config->GetBandwidthThreads(),
+                                                     g_config->GetBandwidthBufferMB());
+            g_bandwidth_worker->SetTarget(g_config->GetBandwidthTargetGBps(),
+                                          g_config->GetBandwidthTargetPercent());
+            if (g_show_window) {
+                ConsoleUtils::PrintInfo(
+                    ConsoleUtils::UseLocalizedText() ?
+                    "正在测量内存带宽峰值..." :
+                    "Calibrating peak memory bandwidth...");
+            }
+            g_bandwidth_worker->Start();
+            if (g_show_window && !g_headless) {
+                BandwidthWorkerStats bwStats = g_bandwidth_worker->GetStats();
+                printf(ConsoleUtils::UseLocalizedText() ?
+                       ">> 内存带宽峰值: %.2f GB/s, 目标: %.2f GB/s, 线程: %d\n" :
+                       "Peak Memory Bandwidth: %.2f GB/s, target: %.2f GB/s, threads: %d\n",
+                       bwStats.peakGBps, bwStats.targetGBps, bwStats.threadCount);
+            }
+        }
+
+        if (g_config->GetIOEnabled()) {
+            g_io_worker = new IOWorker();
+            std::string scratch_path = g_config->GetIOScratchPath();
+            if (scratch_path.empty()) {
+                char suffix[32];
+                snprintf(suffix, sizeof(suffix), ".io.%lu.tmp", (unsigned long)GetCurrentProcessId());
+                scratch_path = GetInstanceFilePath(suffix);
+            }
+            g_io_worker->Configure(scratch_path,
+                                   g_config->GetIOFileMB(),
+                                   g_config->GetIOBlockKB(),
+                                   g_config->GetIOQueueDepth(),
+                                   g_config->GetIOReadPercent(),
+                                   g_config->GetIOTargetIops(),
+                                   g_config->GetIOTargetMBps(),
+                                   g_config->GetIOBackoffBusyPercent());
+            g_io_worker->Start();
+            if (g_show_window && !g_headless) {
+                printf(ConsoleUtils::UseLocalizedText() ?
+                       ">> 磁盘负载: 目标 %d IOPS / %d MB/s, 块 %dKB, 队列深度 %d, 读 %d%%\n" :
+                       "Disk Load: target %d IOPS / %d MB/s, block %dKB, queue depth %d, read %d%%\n",
+                       g_config->GetIOTargetIops(), g_config->GetIOTargetMBps(),
+                       g_config->GetIOBlockKB(), g_config->GetIOQueueDepth(),
+                       g_config->GetIOReadPercent());
+            }
+        }
+
+        if (g_config->GetNetworkEnabled()) {
+            g_network_worker = new NetworkWorker();
+            g_network_worker->Configure(g_config->GetNetworkEndpoint(),
+                                        g_config->GetNetworkTargetMbps(),
+                                        g_config->GetNetworkSubtractOther());
+            g_network_worker->Start();
+            if (g_show_window && !g_headless) {
+                const std::string& endpoint = g_config->GetNetworkEndpoint();
+                printf(ConsoleUtils::UseLocalizedText() ?
+                       ">> 网络负载: 目标 %.1f Mbps, 端点 %s\n" :
+                       "Network Load: target %.1f Mbps, endpoint %s\n",
+                       g_config->GetNetworkTargetMbps(),
+                       endpoint.empty() ? "loopback" : endpoint.c_str());
+            }
         }
     }
     
-    if (g_config->GetAutoStart()) {
-        AutoStart::Enable();
+    // 无人值守时没有桌面会话，托盘和自启动注册表项都不适用
+    if (!g_headless) {
+        g_tray = new SystemTray();
+        if (!g_tray->Create()) {
+            if (g_show_window) {
+                ConsoleUtils::PrintError(
+                    ConsoleUtils::UseLocalizedText() ?
+                    "创建系统托盘图标失败" :
+                    "Failed to create system tray icon");
+            }
+        }
+
+        if (g_config->GetAutoStart()) {
+            AutoStart::Enable();
+        }
     }
     
-    if (g_show_window) {
+    if (g_show_window && !g_headless) {
         ConsoleUtils::PrintSuccess(
-            ConsoleUtils::IsWindows7OrLater() ?
+            ConsoleUtils::UseLocalizedText() ?
             "程序启动成功，开始监控..." :
             "Started successfully, monitoring...");
         printf("\n");
     }
     
+    if (g_config->GetSampleRateHz() > 0) {
+        g_sampler = new ResourceSampler(g_config->GetSampleRateHz());
+        g_sampler->Start();
+    }
+
+    g_start_tick = GetTickCount();
+    if (g_config->GetMetricsEnabled()) {
+        g_metrics = new MetricsExporter();
+        bool started = g_metrics->Start(g_config->GetMetricsBind(), g_config->GetMetricsPort());
+        if (!started) {
+            delete g_metrics;
+            g_metrics = nullptr;
+        }
+        if (g_show_window) {
+            if (started && !g_headless) {
+                printf(ConsoleUtils::UseLocalizedText() ?
+                       ">> 指标导出: http://%s:%d/metrics\n" :
+                       "Metrics: http://%s:%d/metrics\n",
+                       g_config->GetMetricsBind().c_str(), g_config->GetMetricsPort());
+            } else if (!started) {
+                ConsoleUtils::PrintError(
+                    ConsoleUtils::UseLocalizedText() ?
+                    "指标导出端口监听失败" :
+                    "Failed to start metrics listener");
+            }
+        }
+    }
+
+    // 控制管道、遥测日志和分位数状态文件按名字独占，先确认同机是否已有同名实例
+    g_presence.Acquire(g_config->GetCoordinationName());
+    bool peer_running = g_presence.PeerDetected();
+    if (g_show_window && g_presence.GetScope()[0]) {
+        if (g_headless) {
+            ConsoleUtils::PrintFields("info", "instance scope", "scope=%s coordination_name=%s peer=%d",
+                                      g_presence.GetScope(), g_config->GetCoordinationName().c_str(),
+                                      peer_running ? 1 : 0);
+        } else {
+            printf(ConsoleUtils::UseLocalizedText() ?
+                   ">> 实例命名空间: %s\\%s%s\n" :
+                   "Instance Scope: %s\\%s%s\n",
+                   g_presence.GetScope(), g_config->GetCoordinationName().c_str(),
+                   peer_running ? (ConsoleUtils::UseLocalizedText() ? "（已有同名实例）" : " (peer running)") : "");
+        }
+        if (strcmp(g_presence.GetScope(), "Local") == 0) {
+            ConsoleUtils::PrintWarning(
+                ConsoleUtils::UseLocalizedText() ?
+                "无法使用 Global 命名空间，只能发现同一会话内的实例，管理员与普通权限的实例互相看不到" :
+                "Global namespace unavailable, only instances in this session are detected; elevated and non-elevated instances cannot see each other");
+        }
+    }
+
+    if (g_config->GetTelemetryEnabled() && peer_running && g_config->GetTelemetryFile().empty()) {
+        // 日志文件独占写入，两个实例会争用同一个文件；显式指定 telemetry_file 时按用户设置
+        if (g_show_window) {
+            ConsoleUtils::PrintWarning(
+                ConsoleUtils::UseLocalizedText() ?
+                "同机已有 coordination_name 为 %s 的实例在运行，本实例不记录遥测日志（可单独设置 telemetry_file）" :
+                "Another instance with coordination_name %s is running, telemetry is disabled for this instance (set telemetry_file to enable)",
+                g_config->GetCoordinationName().c_str());
+        }
+    } else if (g_config->GetTelemetryEnabled()) {
+        g_telemetry = new TelemetryLog();
+        std::string telemetryPath = GetTelemetryPath();
+        if (!g_telemetry->Open(telemetryPath, g_config->GetTelemetryMaxMB())) {
+            delete g_telemetry;
+            g_telemetry = nullptr;
+            if (g_show_window) {
+                ConsoleUtils::PrintWarning(
+                    ConsoleUtils::UseLocalizedText() ?
+                    "无法打开遥测日志 %s" :
+                    "Failed to open telemetry log %s",
+                    telemetryPath.c_str());
+            }
+        }
+    }
+
+    if (g_config->GetControlEnabled()) {
+        // 同名实例已占用管道名时，本实例的管道名加上进程号，用 -control-pipe <名字> -ctl 访问
+        std::string controlPipe = g_config->GetControlPipe();
+        if (peer_running) {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), ".%lu", (unsigned long)GetCurrentProcessId());
+            controlPipe += suffix;
+            if (g_show_window) {
+                ConsoleUtils::PrintWarning(
+                    ConsoleUtils::UseLocalizedText() ?
+                    "同机已有 coordination_name 为 %s 的实例在运行，本实例的控制管道改为 %s" :
+                    "Another instance with coordination_name %s is running, this instance uses control pipe %s",
+                    g_config->GetCoordinationName().c_str(), controlPipe.c_str());
+            }
+        }
+        g_control = new ControlServer();
+        bool started = g_control->Start(controlPipe, g_wake_event);
+        if (!started) {
+            delete g_control;
+            g_control = nullptr;
+        }
+        if (g_show_window) {
+            std::string pipeName = ControlServer::GetFullPipeName(controlPipe);
+            if (started && !g_headless) {
+                printf(ConsoleUtils::UseLocalizedText() ?
+                       ">> 控制管道: %s\n" :
+                       "Control Pipe: %s\n",
+                       pipeName.c_str());
+            } else if (!started) {
+                ConsoleUtils::PrintWarning(
+                    ConsoleUtils::UseLocalizedText() ?
+                    "控制管道 %s 创建失败（可能已有实例在运行）" :
+                    "Failed to create control pipe %s (another instance may be running)",
+                    pipeName.c_str());
+            }
+        }
+    }
+
+    if (g_config->GetCoordinationEnabled()) {
+        g_coordinator = new InstanceCoordinator();
+        if (g_coordinator->Start(g_config->GetCoordinationName(), g_config->GetCoordinationWeight())) {
+            if (g_show_window && !g_headless) {
+                printf(ConsoleUtils::UseLocalizedText() ?
+                       ">> 多实例协同: %s\\%s.coord\n" :
+                       "Coordination: %s\\%s.coord\n",
+                       g_coordinator->GetScope(), g_config->GetCoordinationName().c_str());
+            } else if (g_headless) {
+                ConsoleUtils::PrintFields("info", "coordination", "scope=%s name=%s",
+                                          g_coordinator->GetScope(), g_config->GetCoordinationName().c_str());
+            }
+        } else {
+            delete g_coordinator;
+            g_coordinator = nullptr;
+            if (g_show_window) {
+                ConsoleUtils::PrintWarning(
+                    ConsoleUtils::UseLocalizedText() ?
+                    "无法创建多实例协同共享段 %s，按单实例运行" :
+                    "Failed to open coordination segment %s, running standalone",
+                    g_config->GetCoordinationName().c_str());
+            }
+        }
+    }
+
+    TraceRecorder::SetThreadName("controller");
+    if (!g_trace_path.empty()) {
+        TraceRecorder::Start();
+    }
+
+    // pid 文件在初始化完成后才写出，文件存在即表示已就绪
+    bool pidfile_written = false;
+    if (!g_pidfile_path.empty()) {
+        pidfile_written = WritePidFile(g_pidfile_path);
+        if (!pidfile_written && g_show_window) {
+            ConsoleUtils::PrintWarning(
+                ConsoleUtils::UseLocalizedText() ?
+                "无法写入 pid 文件 %s" :
+                "Failed to write pid file %s",
+                g_pidfile_path.c_str());
+        }
+    }
+    bool ready_notified = NotifyReady();
+    if (g_headless) {
+        ConsoleUtils::PrintFields("info", "ready",
+                                  "pid=%lu workers=%d metrics=%s control_pipe=%s ready_event=%d",
+                                  (unsigned long)GetCurrentProcessId(),
+                                  g_cpu_worker || g_memory_worker ? 1 : 0,
+                                  g_metrics ? "on" : "off",
+                                  g_control ? g_control->GetPipeName().c_str() : "off",
+                                  ready_notified ? 1 : 0);
+    }
+
     MonitorLoop();
+
+    if (g_headless) {
+        ConsoleUtils::PrintFields("info", "stopping", "uptime_sec=%lu",
+                                  (unsigned long)((GetTickCount() - g_start_tick) / 1000));
+    }
+
+    if (!g_trace_path.empty()) {
+        int events = TraceRecorder::WriteChromeJson(g_trace_path);
+        if (g_show_window && events < 0) {
+            ConsoleUtils::PrintWarning(
+                ConsoleUtils::UseLocalizedText() ?
+                "无法写入跟踪文件 %s" :
+                "Failed to write trace file %s",
+                g_trace_path.c_str());
+        }
+    }
+
+    if (g_control) {
+        g_control->Stop();
+        delete g_control;
+        g_control = nullptr;
+    }
+
+    // 退出前清空自己的槽位，其他实例下一轮即可收回份额
+    if (g_coordinator) {
+        g_coordinator->Stop();
+        delete g_coordinator;
+        g_coordinator = nullptr;
+    }
+    g_presence.Release();
+
+    if (g_telemetry) {
+        g_telemetry->Close();
+        delete g_telemetry;
+        g_telemetry = nullptr;
+    }
+
+    if (g_metrics) {
+        g_metrics->Stop();
+        delete g_metrics;
+        g_metrics = nullptr;
+    }
+
+    if (g_sampler) {
+        g_sampler->Stop();
+        delete g_sampler;
+        g_sampler = nullptr;
+    }
     
     // 清理资源
     if (g_show_window) {
         ConsoleUtils::PrintInfo(
-            ConsoleUtils::IsWindows7OrLater() ?
+            ConsoleUtils::UseLocalizedText() ?
             "正在清理资源..." :
             "Cleaning up resources...");
     }
@@ -528,6 +1772,24 @@ int main(int argc, char* argv[]) {
         delete g_memory_worker;
         g_memory_worker = nullptr;
     }
+
+    if (g_bandwidth_worker) {
+        g_bandwidth_worker->Stop();
+        delete g_bandwidth_worker;
+        g_bandwidth_worker = nullptr;
+    }
+
+    if (g_io_worker) {
+        g_io_worker->Stop();
+        delete g_io_worker;
+        g_io_worker = nullptr;
+    }
+
+    if (g_network_worker) {
+        g_network_worker->Stop();
+        delete g_network_worker;
+        g_network_worker = nullptr;
+    }
     
     if (g_tray) {
         g_tray->Destroy();
@@ -545,13 +1807,27 @@ int main(int argc, char* argv[]) {
         delete g_config;
         g_config = nullptr;
     }
+
+    if (g_wake_event) {
+        CloseHandle(g_wake_event);
+        g_wake_event = NULL;
+    }
+    if (g_shutdown_event) {
+        CloseHandle(g_shutdown_event);
+        g_shutdown_event = NULL;
+    }
+
+    if (pidfile_written) {
+        DeleteFileA(g_pidfile_path.c_str());
+    }
     
     if (g_show_window) {
         ConsoleUtils::PrintSuccess(
-            ConsoleUtils::IsWindows7OrLater() ?
+            ConsoleUtils::UseLocalizedText() ?
             "程序已安全退出" :
             "Exited safely");
     }
-    
+
+    if (g_cleanup_done_event) SetEvent(g_cleanup_done_event);
     return 0;
 }
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86 1
+#include <emmintrin.h>
+#endif
+
+// legacy i686 MinGW 构建没有默认开启 SSE2，用 target 属性单独为这几个函数打开，
+// 运行时再通过 HasStreamingStores() 决定是否调用
+#if defined(CPU_FEATURES_X86) && defined(__GNUC__) && !defined(__SSE2__)
+#define CPU_FEATURES_SSE2_FN __attribute__((target("sse2")))
+#else
+#define CPU_FEATURES_SSE2_FN
+#endif
+
+#ifndef PF_XMMI64_INSTRUCTIONS_AVAILABLE
+#define PF_XMMI64_INSTRUCTIONS_AVAILABLE 10
+#endif
+
+class CpuFeatures {
+public:
+    // 是否可以使用非临时写入（MOVNTI），不支持时调用方回退到普通写入
+    static bool HasStreamingStores() {
+#if defined(_M_X64) || defined(__x86_64__)
+        return true;
+#elif defined(CPU_FEATURES_X86) && defined(_WIN32)
+        static int cached = -1;
+        if (cached < 0) {
+            cached = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) ? 1 : 0;
+        }
+        return cached != 0;
+#else
+        return false;
+#endif
+    }
+
+    // 绕过缓存写入 4 字节，页面被置脏但不会把整条缓存行拉进 LLC
+    CPU_FEATURES_SSE2_FN static void StreamStore32(void* address, uint32_t value) {
+#if defined(CPU_FEATURES_X86)
+        _mm_stream_si32((int*)address, (int)value);
+#else
+        *(volatile uint32_t*)address = value;
+#endif
+    }
+
+    // 非临时写入是弱序的，一轮写完后需要 sfence 才能对其他核可见
+    CPU_FEATURES_SSE2_FN static void StreamFence() {
+#if defined(CPU_FEATURES_X86)
+        _mm_sfence();
+#endif
+    }
+
+    // STREAM triad：a = b + scalar * c，三个数组需 16 字节对齐；
+    // 支持 SSE2 时 a 使用非临时写入，不支持时退回标量循环
+    static void StreamTriad(double* a, const double* b, const double* c,
+                            double scalar, size_t count) {
+#if defined(CPU_FEATURES_X86)
+        if (HasStreamingStores()) {
+            StreamTriadSse2(a, b, c, scalar, count);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i) {
+            a[i] = b[i] + scalar * c[i];
+        }
+    }
+
+private:
+#if defined(CPU_FEATURES_X86)
+    CPU_FEATURES_SSE2_FN static void StreamTriadSse2(double* a, const double* b, const double* c,
+                                                     double scalar, size_t count) {
+        const __m128d s = _mm_set1_pd(scalar);
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2) {
+            __m128d v = _mm_add_pd(_mm_load_pd(b + i), _mm_mul_pd(s, _mm_load_pd(c + i)));
+            _mm_stream_pd(a + i, v);
+        }
+        for (; i < count; ++i) {
+            a[i] = b[i] + scalar * c[i];
+        }
+        _mm_sfence();
+    }
+#endif
+};
@@ -53,72 +53,144 @@ public:
     }
 
 #ifdef _WIN32
-    static bool QueryRegionResidentBytes(void* base, size_t sizeBytes, size_t strideBytes,
-                                         uint64_t& residentBytes, bool& approximate) {
-        residentBytes = 0;
-        approximate = true;
-        if (!base || sizeBytes == 0) {
+    // 批量查询页面是否在工作集中，调用方预先填好 VirtualAddress
+    static bool QueryPagesResident(PSAPI_WORKING_SET_EX_INFORMATION* entries, size_t count) {
+        if (!entries || count == 0) {
             return false;
         }
 
-        SYSTEM_INFO sysInfo;
-        GetSystemInfo(&sysInfo);
-        const size_t pageSize = sysInfo.dwPageSize ? (size_t)sysInfo.dwPageSize : 4096;
-        const size_t stride = strideBytes < pageSize ? pageSize : strideBytes;
-        const size_t pageCount = (sizeBytes + pageSize - 1) / pageSize;
-        if (pageCount == 0) {
+        typedef BOOL (WINAPI *PQueryWorkingSetEx)(HANDLE, PVOID, DWORD);
+        static PQueryWorkingSetEx pQueryWorkingSetEx = NULL;
+        static bool resolved = false;
+        if (!resolved) {
+            HMODULE hPsapi = GetModuleHandleA("psapi.dll");
+            if (!hPsapi) {
+                hPsapi = LoadLibraryA("psapi.dll");
+            }
+            if (hPsapi) {
+                pQueryWorkingSetEx =
+                    (PQueryWorkingSetEx)GetProcAddress(hPsapi, "QueryWorkingSetEx");
+            }
+            resolved = true;
+        }
+        if (!pQueryWorkingSetEx) {
             return false;
         }
 
-        typedef BOOL (WINAPI *PQueryWorkingSetEx)(HANDLE, PVOID, DWORD);
-        HMODULE hPsapi = GetModuleHandleA("psapi.dll");
-        if (!hPsapi) {
-            hPsapi = LoadLibraryA("psapi.dll");
+        return pQueryWorkingSetEx(GetCurrentProcess(), entries,
+                                  (DWORD)(sizeof(PSAPI_WORKING_SET_EX_INFORMATION) * count)) != FALSE;
+    }
+
+    static size_t GetPageSize() {
+        static size_t pageSize = 0;
+        if (pageSize == 0) {
+            SYSTEM_INFO sysInfo;
+            GetSystemInfo(&sysInfo);
+            pageSize = sysInfo.dwPageSize ? (size_t)sysInfo.dwPageSize : 4096;
         }
-        if (!hPsapi) {
-            return false;
+        return pageSize;
+    }
+
+    // NUMA 节点数；GetNumaHighestNodeNumber 从 XP SP2 开始提供，更早的系统视为单节点
+    static int GetNumaNodeCount() {
+        static int nodeCount = 0;
+        if (nodeCount == 0) {
+            typedef BOOL (WINAPI *PGetNumaHighestNodeNumber)(PULONG);
+            HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
+            PGetNumaHighestNodeNumber pGetHighest = hKernel32
+                ? (PGetNumaHighestNodeNumber)GetProcAddress(hKernel32, "GetNumaHighestNodeNumber")
+                : NULL;
+            ULONG highest = 0;
+            if (pGetHighest && pGetHighest(&highest)) {
+                nodeCount = (int)highest + 1;
+            } else {
+                nodeCount = 1;
+            }
+            if (nodeCount > 64) nodeCount = 64;
         }
+        return nodeCount;
+    }
 
-        PQueryWorkingSetEx pQueryWorkingSetEx =
-            (PQueryWorkingSetEx)GetProcAddress(hPsapi, "QueryWorkingSetEx");
-        if (!pQueryWorkingSetEx) {
+    static bool QueryNumaNodeFreeBytes(int node, uint64_t& freeBytes) {
+        freeBytes = 0;
+        typedef BOOL (WINAPI *PGetNumaAvailableMemoryNode)(UCHAR, PULONGLONG);
+        static PGetNumaAvailableMemoryNode pGetAvailable = NULL;
+        static bool resolved = false;
+        if (!resolved) {
+            HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
+            if (hKernel32) {
+                pGetAvailable = (PGetNumaAvailableMemoryNode)GetProcAddress(hKernel32, "GetNumaAvailableMemoryNode");
+            }
+            resolved = true;
+        }
+        if (!pGetAvailable || node < 0 || node > 255) {
             return false;
         }
 
-        const size_t sampleCount = (sizeBytes + stride - 1) / stride;
-        if (sampleCount == 0) {
+        ULONGLONG available = 0;
+        if (!pGetAvailable((UCHAR)node, &available)) {
             return false;
         }
+        freeBytes = (uint64_t)available;
+        return true;
+    }
 
-        PSAPI_WORKING_SET_EX_INFORMATION* entries =
-            new PSAPI_WORKING_SET_EX_INFORMATION[sampleCount];
-        if (!entries) {
-            return false;
+    // 在指定节点上提交内存；VirtualAllocExNuma 从 Vista 开始提供，不可用或 node<0 时退回普通分配
+    static void* AllocateOnNode(size_t sizeBytes, int node) {
+        typedef LPVOID (WINAPI *PVirtualAllocExNuma)(HANDLE, LPVOID, SIZE_T, DWORD, DWORD, DWORD);
+        static PVirtualAllocExNuma pAllocExNuma = NULL;
+        static bool resolved = false;
+        if (!resolved) {
+            HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
+            if (hKernel32) {
+                pAllocExNuma = (PVirtualAllocExNuma)GetProcAddress(hKernel32, "VirtualAllocExNuma");
+            }
+            resolved = true;
         }
 
-        size_t index = 0;
-        for (size_t offset = 0; offset < sizeBytes; offset += stride) {
-            entries[index].VirtualAddress = (PVOID)((char*)base + offset);
-            ++index;
+        if (node >= 0 && pAllocExNuma) {
+            void* ptr = pAllocExNuma(GetCurrentProcess(), NULL, (SIZE_T)sizeBytes,
+                                     MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE, (DWORD)node);
+            if (ptr) {
+                return ptr;
+            }
         }
+        return VirtualAlloc(NULL, (SIZE_T)sizeBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    }
 
-        BOOL ok = pQueryWorkingSetEx(GetCurrentProcess(), entries,
-                                     (DWORD)(sizeof(PSAPI_WORKING_SET_EX_INFORMATION) * index));
-        if (!ok) {
-            delete[] entries;
+    static bool QueryRegionResidentBytes(void* base, size_t sizeBytes, size_t strideBytes,
+                                         uint64_t& residentBytes, bool& approximate) {
+        residentBytes = 0;
+        approximate = true;
+        if (!base || sizeBytes == 0) {
             return false;
         }
 
-        size_t residentPages = 0;
-        for (size_t i = 0; i < index; ++i) {
-            if (entries[i].VirtualAttributes.Valid) {
-                ++residentPages;
+        const size_t pageSize = GetPageSize();
+        const size_t stride = strideBytes < pageSize ? pageSize : strideBytes;
+
+        // 分批查询，复用栈上缓冲区，避免每个块都在堆上申请数组
+        const size_t batchSize = 512;
+        PSAPI_WORKING_SET_EX_INFORMATION entries[batchSize];
+
+        size_t residentSamples = 0;
+        size_t offset = 0;
+        while (offset < sizeBytes) {
+            size_t count = 0;
+            for (; count < batchSize && offset < sizeBytes; ++count, offset += stride) {
+                entries[count].VirtualAddress = (PVOID)((char*)base + offset);
+            }
+            if (!QueryPagesResident(entries, count)) {
+                return false;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (entries[i].VirtualAttributes.Valid) {
+                    ++residentSamples;
+                }
             }
         }
 
-        delete[] entries;
-
-        residentBytes = (uint64_t)residentPages * stride;
+        residentBytes = (uint64_t)residentSamples * stride;
         if (residentBytes > (uint64_t)sizeBytes) {
             residentBytes = (uint64_t)sizeBytes;
         }
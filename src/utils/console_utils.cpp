@@ -12,6 +12,7 @@ static HANDLE hConsole = NULL;
 static WORD originalAttributes = 7;
 static bool isInitialized = false;
 bool ConsoleUtils::useUTF8 = false;
+bool ConsoleUtils::structured = false;
 
 namespace {
 std::string GetExecutableNameForDisplay() {
@@ -41,7 +42,7 @@ void ConsoleUtils::Init() {
         originalAttributes = consoleInfo.wAttributes;
     }
 
-    useUTF8 = IsWindows7OrLater();
+    useUTF8 = UseLocalizedText();
 
     if (useUTF8) {
         SetConsoleCP(65001);
@@ -70,7 +71,7 @@ void ConsoleUtils::Reinit() {
         originalAttributes = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE;
     }
 
-    useUTF8 = IsWindows7OrLater();
+    useUTF8 = UseLocalizedText();
 
     if (useUTF8) {
         SetConsoleCP(65001);
@@ -100,6 +101,69 @@ bool ConsoleUtils::IsWindows7OrLater() {
     return SystemInfo::IsWindows7OrLater();
 }
 
+bool ConsoleUtils::UseLocalizedText() {
+    // 旧控制台无法显示 UTF-8 中文，结构化日志固定输出英文
+    return !structured && SystemInfo::IsWindows7OrLater();
+}
+
+void ConsoleUtils::SetStructured(bool enabled) {
+    structured = enabled;
+    if (enabled) {
+        useUTF8 = false;
+        hConsole = NULL;  // 不再设置颜色
+    }
+}
+
+namespace {
+// logfmt 值：含空格、引号或等号时加引号，换行折成空格
+void WriteLogValue(const char* text) {
+    bool quote = *text == '\0' || strpbrk(text, " \"=\t") != NULL;
+    if (quote) putchar('"');
+    for (const char* p = text; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            putchar('\\');
+            putchar(*p);
+        } else if (*p == '\r' || *p == '\n') {
+            putchar(' ');
+        } else {
+            putchar(*p);
+        }
+    }
+    if (quote) putchar('"');
+}
+
+void WriteLogPrefix(const char* level) {
+    SYSTEMTIME utc;
+    GetSystemTime(&utc);
+    printf("ts=%04d-%02d-%02dT%02d:%02d:%02d.%03dZ level=%s msg=",
+           utc.wYear, utc.wMonth, utc.wDay, utc.wHour, utc.wMinute, utc.wSecond,
+           utc.wMilliseconds, level);
+}
+}
+
+void ConsoleUtils::WriteLogLine(const char* level, const char* format, va_list args) {
+    char message[1024];
+    vsnprintf(message, sizeof(message), format, args);
+    message[sizeof(message) - 1] = '\0';
+    WriteLogPrefix(level);
+    WriteLogValue(message);
+    printf("\n");
+    // 输出通常被重定向到管道或文件，逐行刷新
+    fflush(stdout);
+}
+
+void ConsoleUtils::PrintFields(const char* level, const char* message, const char* fieldsFormat, ...) {
+    WriteLogPrefix(level);
+    WriteLogValue(message);
+    putchar(' ');
+    va_list args;
+    va_start(args, fieldsFormat);
+    vprintf(fieldsFormat, args);
+    va_end(args);
+    printf("\n");
+    fflush(stdout);
+}
+
 void ConsoleUtils::SetColor(WORD color) {
     if (hConsole) {
         SetConsoleTextAttribute(hConsole, color);
@@ -270,11 +334,53 @@ void ConsoleUtils::PrintHelpContent() {
         printf("  -mem-refresh <true|false>   设置是否启用页面刷新\n");
         printf("  -mem-refresh-after <sec>    设置分配多久后开始刷新页面\n");
         printf("  -mem-refresh-interval <sec> 设置刷新周期\n");
-        printf("  -mem-refresh-stride <KB>    设置刷新步长\n\n");
+        printf("  -mem-refresh-stride <KB>    设置刷新步长\n");
+        printf("  -mem-refresh-mbps <MB>      设置刷新带宽预算 (MB/s, 0=不限)\n");
+        printf("  -mem-refresh-pps <pages>    设置刷新页数预算 (页/s, 0=不限)\n");
+        printf("  -mem-refresh-streaming <b>  设置是否使用非临时写入刷新\n");
+        printf("  -mem-resident-samples <n>   设置每秒驻留抽样页数\n");
+        printf("  -mem-pressure-release <b>   设置是否在系统低内存时紧急释放\n");
+        printf("  -mem-emergency-mb <MB>      设置每次紧急释放的内存量\n");
+        printf("  -mem-reclaimable <b>        设置填充内存是否可被系统直接回收\n");
+        printf("  -mem-numa <mode>            设置 NUMA 放置 (off/interleave/proportional/nodes)\n");
+        printf("  -mem-numa-nodes <list>      仅在指定节点上填充，例如 0,1\n");
+        printf("  -bw <percent>               启用内存带宽负载，目标为峰值百分比\n");
+        printf("  -bw-gbps <GB/s>             启用内存带宽负载，使用绝对目标\n");
+        printf("  -bw-threads <n>             设置带宽负载线程数 (0=半数核心)\n");
+        printf("  -bw-buffer <MB>             设置带宽负载缓冲区大小\n");
+        printf("  -io <iops>                  启用磁盘负载，目标 IOPS\n");
+        printf("  -io-mbps <MB>               启用磁盘负载，目标 MB/s\n");
+        printf("  -io-qd <n>                  设置磁盘负载队列深度\n");
+        printf("  -io-block <KB>              设置磁盘负载块大小\n");
+        printf("  -io-read <percent>          设置读请求比例\n");
+        printf("  -io-file <path>             设置磁盘负载临时文件路径\n");
+        printf("  -net <Mbps>                 启用网络负载，目标 Mbit/s\n");
+        printf("  -net-endpoint <host:port>   设置网络负载发送端点（默认本地回环）\n\n");
+        printf("  -sample-hz <Hz>             设置高频采样频率 (0 关闭)\n");
+        printf("  -metrics <port>             启用 Prometheus 指标导出 (0 关闭)\n");
+        printf("  -metrics-bind <addr>        设置指标导出监听地址 (默认 127.0.0.1)\n");
+        printf("  -control <b>                设置是否开启本地控制管道\n");
+        printf("  -control-pipe <name>        设置控制管道名 (默认 MikaBooM)\n");
+        printf("  -telemetry <b>              设置是否记录二进制遥测日志\n");
+        printf("  -overhead-budget <pct>      控制面开销告警阈值，占单核百分比 (0 关闭)\n");
+        printf("  -coordination <b>           设置是否与同机其他实例协同分摊填充\n");
+        printf("  -headless                   无人值守运行：无托盘/自启动，输出 logfmt 日志\n");
+        printf("  -pidfile <file>             就绪后写出 pid 文件，退出时删除\n");
+        printf("  -forecast <ticks>           设置负载预测步数 (0 关闭)\n");
+        printf("  -quantile <level>           启用分位数目标，CPU 分位数不低于 level%% (0 关闭)\n");
+        printf("  -quantile-p <percentile>    设置分位数目标的分位 (默认 95)\n");
         printf("  -window <value>             设置窗口显示模式\n");
         printf("  -auto                       启用开机自启动\n");
         printf("  -noauto                     禁用开机自启动\n");
         printf("  -update                     检测并安装更新（一键完成）\n");
+        printf("  -replay-estimator [csv]     回放对比 EMA 与卡尔曼负载估计\n");
+        printf("  -simulate [csv]             虚拟时钟下仿真控制器与工作者调整逻辑\n");
+        printf("                              (-sim-resource cpu|mem/-sim-hours/-sim-lag/-sim-noise/-sim-seed)\n");
+        printf("  -bench-load [profile]       运行控制精度基准，输出 JSON 报告 (steps/ramp/bursts/sine/mixed)\n");
+        printf("  -bench [json]               运行热点路径微基准 (-bench-baseline <json> 对比基线)\n");
+        printf("  -ctl <command...>           向运行中的实例发送控制命令 (-ctl help 查看命令)\n");
+        printf("  -telemetry-dump [bin] [csv] 把遥测日志转换为 CSV (默认输出到控制台)\n");
+        printf("  -trace <json>               记录工作线程活动，退出时写出 Chrome trace JSON\n");
         printf("  -c <file>                   指定配置文件路径\n");
         printf("  -v                          显示版本信息\n");
         printf("  -h                          显示此帮助信息\n\n");
@@ -296,10 +402,52 @@ void ConsoleUtils::PrintHelpContent() {
         printf("  -mem-refresh-after <sec>    Delay before refresh starts\n");
         printf("  -mem-refresh-interval <sec> Set refresh interval\n");
         printf("  -mem-refresh-stride <KB>    Set refresh stride\n");
+        printf("  -mem-refresh-mbps <MB>      Set refresh bandwidth budget (MB/s, 0=unlimited)\n");
+        printf("  -mem-refresh-pps <pages>    Set refresh page budget (pages/s, 0=unlimited)\n");
+        printf("  -mem-refresh-streaming <b>  Use non-temporal stores for refresh\n");
+        printf("  -mem-resident-samples <n>   Set residency sample pages per second\n");
+        printf("  -mem-pressure-release <b>   Release memory immediately on low-memory signal\n");
+        printf("  -mem-emergency-mb <MB>      Set memory released per emergency\n");
+        printf("  -mem-reclaimable <b>        Let the system discard filler pages (MEM_RESET)\n");
+        printf("  -mem-numa <mode>            NUMA placement (off/interleave/proportional/nodes)\n");
+        printf("  -mem-numa-nodes <list>      Fill only the listed nodes, e.g. 0,1\n");
+        printf("  -bw <percent>               Enable bandwidth load, target as %% of peak\n");
+        printf("  -bw-gbps <GB/s>             Enable bandwidth load with absolute target\n");
+        printf("  -bw-threads <n>             Bandwidth worker threads (0=half the cores)\n");
+        printf("  -bw-buffer <MB>             Bandwidth worker buffer size\n");
+        printf("  -io <iops>                  Enable disk load with target IOPS\n");
+        printf("  -io-mbps <MB>               Enable disk load with target MB/s\n");
+        printf("  -io-qd <n>                  Disk load queue depth\n");
+        printf("  -io-block <KB>              Disk load block size\n");
+        printf("  -io-read <percent>          Share of reads in the disk load\n");
+        printf("  -io-file <path>             Disk load scratch file path\n");
+        printf("  -net <Mbps>                 Enable network load with target Mbit/s\n");
+        printf("  -net-endpoint <host:port>   Network load endpoint (default: loopback)\n");
+        printf("  -sample-hz <Hz>             Set high-frequency sampling rate (0 = off)\n");
+        printf("  -metrics <port>             Enable Prometheus metrics exporter (0 = off)\n");
+        printf("  -metrics-bind <addr>        Set metrics listen address (default 127.0.0.1)\n");
+        printf("  -control <b>                Enable or disable the local control pipe\n");
+        printf("  -control-pipe <name>        Set control pipe name (default MikaBooM)\n");
+        printf("  -telemetry <b>              Enable or disable the binary telemetry log\n");
+        printf("  -overhead-budget <pct>      Control-plane overhead alarm, percent of one core (0 = off)\n");
+        printf("  -coordination <b>           Share the fill target with other instances on this host\n");
+        printf("  -headless                   Unattended mode: no tray/autostart, logfmt output\n");
+        printf("  -pidfile <file>             Write a pid file once ready, removed on exit\n");
+        printf("  -forecast <ticks>           Set load forecast horizon (0 = off)\n");
+        printf("  -quantile <level>           Keep the CPU percentile at or above level%% (0 = off)\n");
+        printf("  -quantile-p <percentile>    Percentile for quantile targeting (default 95)\n");
         printf("  -window <value>             Set window mode\n");
         printf("  -auto                       Enable auto-start\n");
         printf("  -noauto                     Disable auto-start\n");
         printf("  -update                     Check and install updates\n");
+        printf("  -replay-estimator [csv]     Replay trace comparing EMA and Kalman estimators\n");
+        printf("  -simulate [csv]             Simulate controller and worker adjust logic on a virtual clock\n");
+        printf("                              (-sim-resource cpu|mem/-sim-hours/-sim-lag/-sim-noise/-sim-seed)\n");
+        printf("  -bench-load [profile]       Run load-control accuracy benchmark with JSON report (steps/ramp/bursts/sine/mixed)\n");
+        printf("  -bench [json]               Run hot-path microbenchmarks (-bench-baseline <json> to compare)\n");
+        printf("  -ctl <command...>           Send a control command to the running instance (-ctl help for commands)\n");
+        printf("  -telemetry-dump [bin] [csv] Convert the telemetry log to CSV (stdout by default)\n");
+        printf("  -trace <json>               Trace worker activity, write Chrome trace JSON on exit\n");
         printf("  -c <file>                   Specify config file\n");
         printf("  -v                          Show version\n");
         printf("  -h                          Show help\n\n");
@@ -320,6 +468,13 @@ void ConsoleUtils::ShowHelp() {
 }
 
 void ConsoleUtils::PrintInfo(const char* format, ...) {
+    if (structured) {
+        va_list args;
+        va_start(args, format);
+        WriteLogLine("info", format, args);
+        va_end(args);
+        return;
+    }
     SetColor(FOREGROUND_GREEN | FOREGROUND_BLUE | FOREGROUND_INTENSITY);
     printf("[INFO] ");
     ResetColor();
@@ -331,6 +486,13 @@ void ConsoleUtils::PrintInfo(const char* format, ...) {
 }
 
 void ConsoleUtils::PrintSuccess(const char* format, ...) {
+    if (structured) {
+        va_list args;
+        va_start(args, format);
+        WriteLogLine("info", format, args);
+        va_end(args);
+        return;
+    }
     SetColor(FOREGROUND_GREEN | FOREGROUND_INTENSITY);
     printf("[OK] ");
     ResetColor();
@@ -342,6 +504,13 @@ void ConsoleUtils::PrintSuccess(const char* format, ...) {
 }
 
 void ConsoleUtils::PrintWarning(const char* format, ...) {
+    if (structured) {
+        va_list args;
+        va_start(args, format);
+        WriteLogLine("warn", format, args);
+        va_end(args);
+        return;
+    }
     SetColor(FOREGROUND_GREEN | FOREGROUND_RED | FOREGROUND_INTENSITY);
     printf("[WARN] ");
     ResetColor();
@@ -353,6 +522,13 @@ void ConsoleUtils::PrintWarning(const char* format, ...) {
 }
 
 void ConsoleUtils::PrintError(const char* format, ...) {
+    if (structured) {
+        va_list args;
+        va_start(args, format);
+        WriteLogLine("error", format, args);
+        va_end(args);
+        return;
+    }
     SetColor(FOREGROUND_RED | FOREGROUND_INTENSITY);
     printf("[ERROR] ");
     ResetColor();
@@ -366,7 +542,7 @@ void ConsoleUtils::PrintError(const char* format, ...) {
 void ConsoleUtils::PrintStatus(double cpu, double mem, bool cpuWork, bool memWork,
                                int cpuIntensity, size_t memAllocMB, size_t memResidentMB,
                                size_t memTargetMB, int residentRatio, bool refreshEnabled,
-                               bool residentApproximate) {
+                               bool residentApproximate, double refreshMBps) {
     time_t now = time(0);
     struct tm timeinfo;
     if (localtime_s(&timeinfo, &now) != 0) {
@@ -415,20 +591,22 @@ void ConsoleUtils::PrintStatus(double cpu, double mem, bool cpuWork, bool memWor
     if (memWork) {
         SetColor(FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_INTENSITY);
         if (useUTF8) {
-            printf(" [内存计算: 运行中 (目标:%luMB 已分配:%luMB 驻留:%luMB 比例:%d%% 刷新:%s%s)]",
+            printf(" [内存计算: 运行中 (目标:%luMB 已分配:%luMB 驻留:%luMB 比例:%d%% 刷新:%s %.1fMB/s%s)]",
                    (unsigned long)memTargetMB,
                    (unsigned long)memAllocMB,
                    (unsigned long)memResidentMB,
                    residentRatio,
                    refreshEnabled ? "开" : "关",
+                   refreshMBps,
                    residentApproximate ? ",估算" : "");
         } else {
-            printf(" [MEM-W: ON, T:%luMB A:%luMB R:%luMB RR:%d%% %s%s]",
+            printf(" [MEM-W: ON, T:%luMB A:%luMB R:%luMB RR:%d%% %s %.1fMB/s%s]",
                    (unsigned long)memTargetMB,
                    (unsigned long)memAllocMB,
                    (unsigned long)memResidentMB,
                    residentRatio,
                    refreshEnabled ? "REF:ON" : "REF:OFF",
+                   refreshMBps,
                    residentApproximate ? ",APPROX" : "");
         }
     } else {
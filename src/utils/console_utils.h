@@ -1,6 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <string>
+#include <stdarg.h>
 
 class ConsoleUtils {
 public:
@@ -16,8 +17,16 @@ public:
     static void PrintStatus(double cpu, double mem, bool cpuWork, bool memWork,
                           int cpuIntensity, size_t memAllocMB, size_t memResidentMB,
                           size_t memTargetMB, int residentRatio, bool refreshEnabled,
-                          bool residentApproximate);
+                          bool residentApproximate, double refreshMBps);
     static bool IsWindows7OrLater();
+    // 各处据此选择中文/英文文本
+    static bool UseLocalizedText();
+
+    // 结构化日志（logfmt）：每条一行 ts=... level=... msg=...，不带颜色，固定输出英文，
+    // 供无人值守运行时由服务包装器或日志采集器读取
+    static void SetStructured(bool enabled);
+    static bool IsStructured() { return structured; }
+    static void PrintFields(const char* level, const char* message, const char* fieldsFormat, ...);
 
 private:
     static void SetColor(WORD color);
@@ -26,6 +35,8 @@ private:
     static void PrintSystemInfo();
     static void PrintVersionInfo();
     static void PrintHelpContent();
+    static void WriteLogLine(const char* level, const char* format, va_list args);
     static bool useUTF8;
     static bool initialized;
+    static bool structured;
 };
@@ -219,7 +219,7 @@ std::string Updater::CreateUpdateBatch(const std::string& tempExePath) {
     FILE* script = NULL;
     if (fopen_s(&script, scriptPath.c_str(), "w") != 0 || !script) return "";
 
-    bool useUTF8 = ConsoleUtils::IsWindows7OrLater();
+    bool useUTF8 = ConsoleUtils::UseLocalizedText();
 
     fprintf(script, "@echo off\n");
     if (useUTF8) {
@@ -297,7 +297,7 @@ bool Updater::ApplyUpdate(const std::vector<char>& newExeData) {
 }
 
 void Updater::AutoUpdate() {
-    bool useUTF8 = ConsoleUtils::IsWindows7OrLater();
+    bool useUTF8 = ConsoleUtils::UseLocalizedText();
 
     printf("\n");
     ConsoleUtils::PrintInfo(useUTF8 ? "检查更新中..." : "Checking for updates...");